@@ -0,0 +1,140 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/domain.hpp>
+#include <dynamix/domain_settings_builder.hpp>
+#include <dynamix/mixin_info_data.hpp>
+#include <dynamix/feature_info_data.hpp>
+#include <dynamix/type.hpp>
+
+#include <picobench/picobench.hpp>
+
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <random>
+
+// a domain with many features where each type implements only a few of them
+// compares flat ftables (an entry for every feature id up to the greatest) with compact ones
+
+constexpr uint32_t NUM_FEATURES = 12000;
+constexpr uint32_t NUM_MIXINS = 2000;
+constexpr uint32_t FEATURES_PER_MIXIN = 6;
+constexpr uint32_t MIXINS_PER_TYPE = 8;
+constexpr uint32_t NUM_TYPES = 500;
+constexpr uint32_t NUM_LOOKUPS = 4096;
+
+struct state {
+    std::unique_ptr<dynamix::domain> dom;
+    std::vector<std::unique_ptr<dynamix::util::feature_info_data>> features;
+    std::vector<std::unique_ptr<dynamix::util::mixin_info_data>> mixins;
+    std::vector<const dynamix::type*> types;
+
+    // (type index, feature index) pairs to look up: half of them implemented by the type
+    std::vector<std::pair<uint32_t, uint32_t>> lookups;
+
+    explicit state(bool compact) {
+        std::minstd_rand rnd(42);
+
+        dom.reset(new dynamix::domain("bench", dynamix::domain_settings_builder().compact_types(compact)));
+
+        for (uint32_t i = 0; i < NUM_FEATURES; ++i) {
+            auto& f = features.emplace_back(new dynamix::util::feature_info_data);
+            dynamix::util::feature_info_data_builder b(*f, "");
+            b.store_name("feature_" + std::to_string(i));
+            f->info.allow_clashes = true;
+        }
+
+        for (uint32_t i = 0; i < NUM_MIXINS; ++i) {
+            auto& m = *mixins.emplace_back(new dynamix::util::mixin_info_data);
+            dynamix::util::mixin_info_data_builder b(m, "");
+            b.store_name("mixin_" + std::to_string(i));
+            m.info.set_size_alignment(8, 8);
+            std::unordered_set<uint32_t> fids;
+            while (fids.size() != FEATURES_PER_MIXIN) fids.insert(rnd() % NUM_FEATURES);
+            for (auto fid : fids) {
+                b.implements_with(features[fid]->info, int(fid));
+            }
+            m.register_in(*dom);
+        }
+
+        for (uint32_t i = 0; i < NUM_TYPES; ++i) {
+            std::unordered_set<uint32_t> mids;
+            while (mids.size() != MIXINS_PER_TYPE) mids.insert(rnd() % NUM_MIXINS);
+            std::vector<const dynamix::mixin_info*> query;
+            for (auto mid : mids) query.push_back(&mixins[mid]->info);
+            types.push_back(&dom->get_type(query));
+        }
+
+        for (uint32_t i = 0; i < NUM_LOOKUPS; ++i) {
+            const auto ti = uint32_t(rnd() % NUM_TYPES);
+            uint32_t fi;
+            if (i % 2) {
+                // implemented
+                auto& t = *types[ti];
+                auto fs = t.mixins[rnd() % t.num_mixins()]->features_span();
+                fi = fs[rnd() % fs.size()].info->iid();
+            }
+            else {
+                fi = uint32_t(rnd() % NUM_FEATURES);
+            }
+            lookups.emplace_back(ti, fi);
+        }
+    }
+};
+
+void dispatch(picobench::state& pb, bool compact) {
+    state s(compact);
+
+    size_t num_found = 0;
+    {
+        picobench::scope benchmark(pb);
+        for (int i = 0; i < pb.iterations(); ++i) {
+            auto& l = s.lookups[i % NUM_LOOKUPS];
+            auto entry = s.types[l.first]->ftable_at(s.features[l.second]->info.id);
+            num_found += !!entry;
+        }
+    }
+    pb.set_result(num_found);
+}
+
+void footprint(picobench::state& pb, bool compact) {
+    size_t memory = 0;
+    {
+        picobench::scope benchmark(pb);
+        for (int i = 0; i < pb.iterations(); ++i) {
+            state s(compact);
+            memory = s.dom->types_memory();
+        }
+    }
+    pb.set_result(memory);
+}
+
+PICOBENCH_SUITE("dispatch");
+
+void flat_dispatch(picobench::state& pb) {
+    dispatch(pb, false);
+}
+PICOBENCH(flat_dispatch).baseline();
+
+void compact_dispatch(picobench::state& pb) {
+    dispatch(pb, true);
+}
+PICOBENCH(compact_dispatch);
+
+// the result of the footprint benchmarks is the memory occupied by types
+// they're in separate suites, as the results differ
+
+PICOBENCH_SUITE("footprint flat");
+
+void flat_footprint(picobench::state& pb) {
+    footprint(pb, false);
+}
+PICOBENCH(flat_footprint).iterations({1});
+
+PICOBENCH_SUITE("footprint compact");
+
+void compact_footprint(picobench::state& pb) {
+    footprint(pb, true);
+}
+PICOBENCH(compact_footprint).iterations({1});
@@ -0,0 +1,214 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/declare_domain.hpp>
+#include <dynamix/declare_mixin.hpp>
+#include <dynamix/msg/declare_msg.hpp>
+
+#include <dynamix/define_domain.hpp>
+#include <dynamix/define_mixin.hpp>
+#include <dynamix/msg/define_msg.hpp>
+#include <dynamix/msg/func_traits.hpp>
+#include <dynamix/object.hpp>
+#include <dynamix/mutate.hpp>
+
+#include <picobench/picobench.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+// calling a message on many objects one by one vs in a batch
+// the objects are scattered in memory and are called through pointers
+
+struct bench;
+DYNAMIX_DECLARE_DOMAIN(bench);
+DYNAMIX_DEFINE_DOMAIN(bench);
+
+class bench_obj : public dynamix::object {
+public:
+    bench_obj() : dynamix::object(dynamix::g::get_domain<bench>()) {}
+};
+
+DYNAMIX_DECLARE_MSG(tick_msg, tick, int, (const bench_obj&, int));
+DYNAMIX_MAKE_FUNC_TRAITS(tick);
+
+// the same operation with and without a batch payload
+DYNAMIX_DECLARE_MSG(advance_msg, advance, void, (bench_obj&, int));
+DYNAMIX_MAKE_FUNC_TRAITS(advance);
+DYNAMIX_DECLARE_MSG(advance_batched_msg, advance_batched, void, (bench_obj&, int));
+DYNAMIX_MAKE_FUNC_TRAITS(advance_batched);
+
+template <int N>
+struct body {
+    int val = N;
+    int pos = 0;
+    char payload[48] = {}; // some state which makes the mixins larger than a cache line together
+    int tick(int dt) const { return val * dt + payload[N] + pos; }
+    void advance(int dt) { pos += val * dt; }
+    void advance_batched(int dt) { advance(dt); }
+    static void advance_batch(itlib::span<body*> bodies, int dt) {
+        for (auto b : bodies) b->advance(dt);
+    }
+};
+
+using body0 = body<0>;
+using body1 = body<1>;
+using body2 = body<2>;
+using body3 = body<3>;
+
+struct extra {
+    int val = 0;
+};
+
+DYNAMIX_DEFINE_MIXIN(bench, body0)
+    .implements<tick_msg>()
+    .implements<advance_msg>()
+    .implements<advance_batched_msg>()
+    .implements_batch_by<advance_batched_msg>(body0::advance_batch)
+;
+DYNAMIX_DEFINE_MIXIN(bench, body1)
+    .implements<tick_msg>()
+    .implements<advance_msg>()
+    .implements<advance_batched_msg>()
+    .implements_batch_by<advance_batched_msg>(body1::advance_batch)
+;
+DYNAMIX_DEFINE_MIXIN(bench, body2)
+    .implements<tick_msg>()
+    .implements<advance_msg>()
+    .implements<advance_batched_msg>()
+    .implements_batch_by<advance_batched_msg>(body2::advance_batch)
+;
+DYNAMIX_DEFINE_MIXIN(bench, body3)
+    .implements<tick_msg>()
+    .implements<advance_msg>()
+    .implements<advance_batched_msg>()
+    .implements_batch_by<advance_batched_msg>(body3::advance_batch)
+;
+DYNAMIX_DEFINE_MIXIN(bench, extra);
+
+DYNAMIX_DEFINE_MSG(tick_msg, unicast, tick, int, (const bench_obj&, int));
+DYNAMIX_DEFINE_MSG(advance_msg, unicast, advance, void, (bench_obj&, int));
+DYNAMIX_DEFINE_MSG(advance_batched_msg, unicast, advance_batched, void, (bench_obj&, int));
+
+constexpr uint32_t seed = 42;
+
+struct objects {
+    std::vector<std::unique_ptr<bench_obj>> storage;
+    std::vector<bench_obj*> ptrs;
+
+    // sorted: the objects are grouped by type (long runs of the same type)
+    // otherwise the types are random
+    objects(size_t n, bool sorted) {
+        using namespace dynamix::mutate_ops;
+        std::minstd_rand rng(seed);
+
+        storage.resize(n);
+        for (auto& o : storage) {
+            o.reset(new bench_obj);
+            switch (rng() % 4) {
+            case 0: mutate(*o, add<body0>(), add<extra>()); break;
+            case 1: mutate(*o, add<body1>()); break;
+            case 2: mutate(*o, add<extra>(), add<body2>()); break;
+            case 3: mutate(*o, add<body3>()); break;
+            }
+        }
+
+        for (auto& o : storage) ptrs.push_back(o.get());
+
+        // scatter the objects in memory
+        std::shuffle(ptrs.begin(), ptrs.end(), rng);
+
+        if (sorted) {
+            std::stable_sort(ptrs.begin(), ptrs.end(), [](const bench_obj* a, const bench_obj* b) {
+                return &a->get_type() < &b->get_type();
+            });
+        }
+    }
+};
+
+void one_by_one(picobench::state& pb, bool sorted) {
+    objects objs(size_t(pb.iterations()), sorted);
+
+    intptr_t sum = 0;
+    {
+        picobench::scope benchmark(pb);
+        for (auto o : objs.ptrs) {
+            sum += tick(*o, 3);
+        }
+    }
+    pb.set_result(sum);
+}
+
+void batch(picobench::state& pb, bool sorted) {
+    objects objs(size_t(pb.iterations()), sorted);
+    std::vector<int> results(objs.ptrs.size());
+
+    intptr_t sum = 0;
+    {
+        picobench::scope benchmark(pb);
+        tick_msg::traits::call_unicast_batch(itlib::span(objs.ptrs), results.data(), 3);
+        for (auto r : results) {
+            sum += r;
+        }
+    }
+    pb.set_result(sum);
+}
+
+const std::vector<int> iters = {1000, 10000, 100000};
+
+PICOBENCH_SUITE("sorted");
+
+void one_by_one_sorted(picobench::state& pb) { one_by_one(pb, true); }
+PICOBENCH(one_by_one_sorted).iterations(iters).baseline();
+void batch_sorted(picobench::state& pb) { batch(pb, true); }
+PICOBENCH(batch_sorted).iterations(iters);
+
+PICOBENCH_SUITE("random types");
+
+void one_by_one_random(picobench::state& pb) { one_by_one(pb, false); }
+PICOBENCH(one_by_one_random).iterations(iters).baseline();
+void batch_random(picobench::state& pb) { batch(pb, false); }
+PICOBENCH(batch_random).iterations(iters);
+
+// sorted objects with a void message which the mixins implement with batch payloads
+PICOBENCH_SUITE("batch payload");
+
+intptr_t sum_ticks(const objects& objs) {
+    intptr_t sum = 0;
+    for (auto o : objs.ptrs) sum += tick(*o, 1);
+    return sum;
+}
+
+void advance_one_by_one(picobench::state& pb) {
+    objects objs(size_t(pb.iterations()), true);
+    {
+        picobench::scope benchmark(pb);
+        for (auto o : objs.ptrs) {
+            advance(*o, 3);
+        }
+    }
+    pb.set_result(sum_ticks(objs));
+}
+PICOBENCH(advance_one_by_one).iterations(iters).baseline();
+
+void advance_batch(picobench::state& pb) {
+    objects objs(size_t(pb.iterations()), true);
+    {
+        picobench::scope benchmark(pb);
+        advance_msg::traits::call_unicast_batch(itlib::span(objs.ptrs), nullptr, 3);
+    }
+    pb.set_result(sum_ticks(objs));
+}
+PICOBENCH(advance_batch).iterations(iters);
+
+void advance_batch_payload(picobench::state& pb) {
+    objects objs(size_t(pb.iterations()), true);
+    {
+        picobench::scope benchmark(pb);
+        advance_batched_msg::traits::call_unicast_batch(itlib::span(objs.ptrs), nullptr, 3);
+    }
+    pb.set_result(sum_ticks(objs));
+}
+PICOBENCH(advance_batch_payload).iterations(iters);
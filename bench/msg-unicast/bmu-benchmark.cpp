@@ -15,7 +15,7 @@
 
 constexpr uint32_t seed = 42;
 
-void virt(picobench::state& pb) {
+void virt(picobench::state& pb, uint32_t num_types) {
     std::minstd_rand rng(seed);
     auto rnd = [&]() {
         return rng() % 10;
@@ -23,7 +23,7 @@ void virt(picobench::state& pb) {
 
     std::vector<std::unique_ptr<shape>> shapes(size_t(pb.iterations()));
     for (auto& s : shapes) {
-        auto type = rng() % 4;
+        auto type = rng() % num_types;
         int a = rnd();
         int b = rnd();
         switch (type) {
@@ -50,9 +50,7 @@ void virt(picobench::state& pb) {
     pb.set_result(sum);
 }
 
-PICOBENCH(virt).baseline();
-
-void std_func(picobench::state& pb) {
+void std_func(picobench::state& pb, uint32_t num_types) {
     std::minstd_rand rng(seed);
     auto rnd = [&]() {
         return rng() % 10;
@@ -60,7 +58,7 @@ void std_func(picobench::state& pb) {
 
     std::vector<area_func> shapes(size_t(pb.iterations()));
     for (auto& s : shapes) {
-        auto type = rng() % 4;
+        auto type = rng() % num_types;
         int a = rnd();
         int b = rnd();
         switch (type) {
@@ -87,21 +85,17 @@ void std_func(picobench::state& pb) {
     pb.set_result(sum);
 }
 
-PICOBENCH(std_func);
-
 struct bench_obj : public dynamix::object {
     bench_obj() : dynamix::object(dynamix::g::get_domain<bench>()) {}
 };
 
-void dynamix_msg(picobench::state& pb) {
-    std::minstd_rand rng(seed);
+void fill_shapes(std::vector<bench_obj>& shapes, std::minstd_rand& rng, uint32_t num_types) {
     auto rnd = [&]() {
         return rng() % 10;
     };
 
-    std::vector<bench_obj> shapes(size_t(pb.iterations()));
     for (auto& s : shapes) {
-        auto type = rng() % 4;
+        auto type = rng() % num_types;
         int a = rnd();
         int b = rnd();
         switch (type) {
@@ -119,13 +113,54 @@ void dynamix_msg(picobench::state& pb) {
             break;
         }
     }
+}
+
+void dynamix_msg(picobench::state& pb, uint32_t num_types) {
+    std::minstd_rand rng(seed);
+    std::vector<bench_obj> shapes(size_t(pb.iterations()));
+    fill_shapes(shapes, rng, num_types);
+
+    uintptr_t sum = 0;
+    picobench::scope benchmark(pb);
+    for (auto& s : shapes) {
+        sum += area(s, rng() % 10);
+    }
+    pb.set_result(sum);
+}
+
+void dynamix_msg_cached(picobench::state& pb, uint32_t num_types) {
+    std::minstd_rand rng(seed);
+    std::vector<bench_obj> shapes(size_t(pb.iterations()));
+    fill_shapes(shapes, rng, num_types);
 
     uintptr_t sum = 0;
     picobench::scope benchmark(pb);
     for (auto& s : shapes) {
-        sum += area(s, rnd());
+        sum += area_cached(s, rng() % 10);
     }
     pb.set_result(sum);
 }
 
-PICOBENCH(dynamix_msg);
+// objects of all four shapes
+PICOBENCH_SUITE("mixed");
+
+void virt_mixed(picobench::state& pb) { virt(pb, 4); }
+PICOBENCH(virt_mixed).baseline();
+void std_func_mixed(picobench::state& pb) { std_func(pb, 4); }
+PICOBENCH(std_func_mixed);
+void dynamix_msg_mixed(picobench::state& pb) { dynamix_msg(pb, 4); }
+PICOBENCH(dynamix_msg_mixed);
+void dynamix_msg_cached_mixed(picobench::state& pb) { dynamix_msg_cached(pb, 4); }
+PICOBENCH(dynamix_msg_cached_mixed);
+
+// objects of a single type: the case where a monomorphic inline cache shines
+PICOBENCH_SUITE("one type");
+
+void virt_one(picobench::state& pb) { virt(pb, 1); }
+PICOBENCH(virt_one).baseline();
+void std_func_one(picobench::state& pb) { std_func(pb, 1); }
+PICOBENCH(std_func_one);
+void dynamix_msg_one(picobench::state& pb) { dynamix_msg(pb, 1); }
+PICOBENCH(dynamix_msg_one);
+void dynamix_msg_cached_one(picobench::state& pb) { dynamix_msg_cached(pb, 1); }
+PICOBENCH(dynamix_msg_cached_one);
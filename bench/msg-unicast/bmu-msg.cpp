@@ -13,24 +13,28 @@
 struct square_mixin {
     square_mixin(int side) : m_side(side) {}
     int area(int mod) const;
+    int area_cached(int mod) const { return area(mod); }
     int m_side;
 };
 
 struct rect_mixin {
     rect_mixin(int a, int b) : m_a(a), m_b(b) {}
     int area(int mod) const;
+    int area_cached(int mod) const { return area(mod); }
     int m_a, m_b;
 };
 
 struct circle_mixin {
     circle_mixin(int radius) : m_radius(radius) {}
     int area(int mod) const;
+    int area_cached(int mod) const { return area(mod); }
     int m_radius;
 };
 
 struct triangle_mixin {
     triangle_mixin(int a, int ha) : m_a(a), m_ha(ha) {}
     int area(int mod) const;
+    int area_cached(int mod) const { return area(mod); }
     int m_a, m_ha;
 };
 
@@ -70,11 +74,13 @@ void mixin_triangle::do_init(dynamix::init_new_args args) {
 DYNAMIX_DEFINE_DOMAIN(bench);
 
 DYNAMIX_MAKE_FUNC_TRAITS(area);
+DYNAMIX_MAKE_FUNC_TRAITS(area_cached);
 
-DYNAMIX_DEFINE_MIXIN(bench, square_mixin).implements<area_msg>();
-DYNAMIX_DEFINE_MIXIN(bench, rect_mixin).implements<area_msg>();
-DYNAMIX_DEFINE_MIXIN(bench, triangle_mixin).implements<area_msg>();
-DYNAMIX_DEFINE_MIXIN(bench, circle_mixin).implements<area_msg>();
+DYNAMIX_DEFINE_MIXIN(bench, square_mixin).implements<area_msg>().implements<area_cached_msg>();
+DYNAMIX_DEFINE_MIXIN(bench, rect_mixin).implements<area_msg>().implements<area_cached_msg>();
+DYNAMIX_DEFINE_MIXIN(bench, triangle_mixin).implements<area_msg>().implements<area_cached_msg>();
+DYNAMIX_DEFINE_MIXIN(bench, circle_mixin).implements<area_msg>().implements<area_cached_msg>();
 
 DYNAMIX_DEFINE_MSG(area_msg, unicast, area, int, (const dynamix::object&, int));
 
+DYNAMIX_DEFINE_CACHED_MSG(area_cached_msg, unicast, 4, area_cached, int, (const dynamix::object&, int));
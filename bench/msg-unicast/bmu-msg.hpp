@@ -40,3 +40,6 @@ struct mixin_triangle : public dynamix::common_mixin_init<triangle_mixin> {
 };
 
 DYNAMIX_DECLARE_MSG(area_msg, area, int, (const dynamix::object&, int));
+
+// same as area, but with an inline cache at the call site
+DYNAMIX_DECLARE_MSG(area_cached_msg, area_cached, int, (const dynamix::object&, int));
@@ -0,0 +1,110 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/domain.hpp>
+#include <dynamix/mixin_info_data.hpp>
+#include <dynamix/type_mutation.hpp>
+#include <dynamix/type.hpp>
+
+#include <picobench/picobench.hpp>
+
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <random>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// getting types from mutations and queries whose results are already known
+// the result of each benchmark is the number of heap allocations while it runs
+// it's expected to be zero (and the same for all benchmarks)
+
+static std::atomic<size_t> num_allocations = {};
+
+void* operator new(std::size_t size) {
+    ++num_allocations;
+    if (auto p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    ++num_allocations;
+    const auto a = static_cast<std::size_t>(al);
+    if (auto p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+constexpr int NUM_MIXINS = 20;
+constexpr int NUM_BASES = 100;
+
+struct state {
+    dynamix::domain dom{"bench"};
+    std::vector<std::unique_ptr<dynamix::util::mixin_info_data>> mixins;
+    std::vector<std::vector<const dynamix::mixin_info*>> queries;
+    std::vector<const dynamix::type*> bases;
+
+    state() {
+        for (int i = 0; i < NUM_MIXINS; ++i) {
+            auto& m = *mixins.emplace_back(new dynamix::util::mixin_info_data);
+            dynamix::util::mixin_info_data_builder b(m, "");
+            b.store_name("mixin_" + std::to_string(i));
+            m.register_in(dom);
+        }
+
+        std::minstd_rand rnd(42);
+        while (bases.size() != NUM_BASES) {
+            auto num_mixins = rnd() % 8 + 1;
+            std::unordered_set<uint32_t> mids;
+            while (mids.size() != num_mixins) {
+                mids.insert(rnd() % NUM_MIXINS);
+            }
+            auto& q = queries.emplace_back();
+            for (auto i : mids) {
+                q.push_back(&mixins[i]->info);
+            }
+            auto& base = dom.get_type(q); // create type and store query
+            bases.push_back(&base);
+
+            // what mutate(obj, add<last>()) would request from an object of this type
+            dynamix::type_mutation mut(base);
+            mut.add_if_lacking(mixins.back()->info);
+            dom.get_type(std::move(mut));
+        }
+    }
+};
+
+void mutate_get_type(picobench::state& pb) {
+    static state s;
+    auto& last = s.mixins.back()->info;
+
+    const auto allocs = num_allocations.load();
+    {
+        picobench::scope benchmark(pb);
+        for (int i = 0; i < pb.iterations(); ++i) {
+            // same as what mutate does
+            dynamix::type_mutation mut(*s.bases[i % NUM_BASES]);
+            mut.add_if_lacking(last);
+            s.dom.get_type(std::move(mut));
+        }
+    }
+    pb.set_result(num_allocations.load() - allocs);
+}
+PICOBENCH(mutate_get_type);
+
+void get_type_span(picobench::state& pb) {
+    static state s;
+
+    const auto allocs = num_allocations.load();
+    {
+        picobench::scope benchmark(pb);
+        for (int i = 0; i < pb.iterations(); ++i) {
+            s.dom.get_type(s.queries[i % NUM_BASES]);
+        }
+    }
+    pb.set_result(num_allocations.load() - allocs);
+}
+PICOBENCH(get_type_span);
@@ -0,0 +1,78 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/domain.hpp>
+#include <dynamix/mixin_info_data.hpp>
+#include <dynamix/feature_info_data.hpp>
+
+#include <picobench/picobench.hpp>
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <random>
+
+// startup-like registration of many mixins (iterations) which implement features from a big pool
+
+constexpr uint32_t FEATURES_PER_MIXIN = 5;
+
+struct state {
+    std::vector<std::unique_ptr<dynamix::util::feature_info_data>> features;
+    std::vector<std::unique_ptr<dynamix::util::mixin_info_data>> mixins;
+    std::vector<dynamix::mixin_info*> infos;
+};
+
+state create_state(uint32_t num_mixins) {
+    std::minstd_rand rnd(42);
+    state ret;
+
+    const uint32_t num_features = num_mixins * FEATURES_PER_MIXIN;
+    for (uint32_t i = 0; i < num_features; ++i) {
+        auto& f = ret.features.emplace_back(new dynamix::util::feature_info_data);
+        dynamix::util::feature_info_data_builder b(*f, "");
+        b.store_name("feature_" + std::to_string(i));
+    }
+
+    for (uint32_t i = 0; i < num_mixins; ++i) {
+        auto& m = *ret.mixins.emplace_back(new dynamix::util::mixin_info_data);
+        dynamix::util::mixin_info_data_builder b(m, "");
+        b.store_name("mixin_" + std::to_string(i));
+        m.info.set_size_alignment(8, 8);
+        for (uint32_t j = 0; j < FEATURES_PER_MIXIN; ++j) {
+            auto& f = *ret.features[rnd() % num_features];
+            b.implements_with(f.info, m.stored_name + '-' + f.stored_name);
+        }
+        ret.infos.push_back(&m.info);
+    }
+
+    return ret;
+}
+
+void benchmark(picobench::state& pb, bool bulk) {
+    auto state = create_state(uint32_t(pb.iterations()));
+    dynamix::domain dom("bench");
+
+    {
+        picobench::scope benchmark(pb);
+        if (bulk) {
+            dom.register_mixins(state.infos);
+        }
+        else {
+            for (auto m : state.infos) {
+                dom.register_mixin(*m);
+            }
+        }
+    }
+
+    pb.set_result(state.infos.back()->iid());
+}
+
+void one_by_one(picobench::state& pb) {
+    benchmark(pb, false);
+}
+PICOBENCH(one_by_one).baseline();
+
+void bulk(picobench::state& pb) {
+    benchmark(pb, true);
+}
+PICOBENCH(bulk);
@@ -5,6 +5,7 @@
 #include <dynamix/mixin_info_data.hpp>
 #include <dynamix/feature_info_data.hpp>
 #include <dynamix/type_mutation.hpp>
+#include <dynamix/type_manifest.hpp>
 
 #include <picobench/picobench.hpp>
 
@@ -17,7 +18,7 @@
 // some code pasted from fuzz-objects-types.cpp
 
 class custom_rule {
-    dynamix::mutation_rule_info m_info;
+    dynamix::mutation_rule_info m_info = {};
     const dynamix::mixin_info& m_primary;
     const dynamix::mixin_info& m_dep;
     std::string m_name;
@@ -131,7 +132,15 @@ state create_state(dynamix::domain& dom, uint32_t features_per_mixin, uint32_t n
     return ret;
 }
 
-void benchmark(uint32_t mixins, uint32_t features, uint32_t rules, picobench::state& pb) {
+enum class lookup {
+    create, // types don't exist
+    stored_query, // types exist and their queries are stored
+    stored_type, // types exist but the queries are not stored
+    manifest, // types don't exist, but are loaded from a manifest first
+    derived, // types don't exist, but types without their last mixin do
+};
+
+void benchmark(uint32_t mixins, uint32_t features, uint32_t rules, picobench::state& pb, lookup l = lookup::create) {
     dynamix::domain dom("bench");
     std::minstd_rand rnd(13);
 
@@ -159,11 +168,48 @@ void benchmark(uint32_t mixins, uint32_t features, uint32_t rules, picobench::st
         }
     }
 
-    picobench::scope benchmark(pb);
-    for (auto& t : types) {
-        dom.get_type(t);
+    if (l == lookup::derived) {
+        for (auto& t : types) {
+            dom.get_type(itlib::span(t.data(), t.size() - 1));
+        }
+    }
+
+    std::vector<dynamix::byte_t> manifest;
+    if (l == lookup::manifest) {
+        for (auto& t : types) {
+            dom.get_type(t);
+        }
+        manifest = dynamix::util::save_type_manifest(dom);
+        dom.garbage_collect_types(); // no objects, so this drops all types
+    }
+
+    dynamix::mutation_rule_info noop = {};
+    if (l == lookup::stored_query || l == lookup::stored_type) {
+        for (auto& t : types) {
+            dom.get_type(t);
+        }
+        if (l == lookup::stored_type) {
+            // adding a rule drops all stored queries
+            noop.name = dnmx_make_sv_lit("noop");
+            noop.apply = [](dnmx_type_mutation_handle, uintptr_t) { return dynamix::result_success; };
+            dom.add_mutation_rule(noop);
+        }
+    }
+
+    {
+        picobench::scope benchmark(pb);
+        if (l == lookup::manifest) {
+            dynamix::util::load_type_manifest(dom, manifest);
+        }
+        for (auto& t : types) {
+            dom.get_type(t);
+        }
     }
     pb.set_result(dom.num_types());
+
+    if (l == lookup::stored_type) {
+        dom.remove_mutation_rule(noop);
+    }
 }
 
 void trivial_mixins(picobench::state& pb) {
@@ -180,3 +226,25 @@ void many_features(picobench::state& pb) {
     benchmark(5, 20, 0, pb);
 }
 PICOBENCH(many_features);
+
+void stored_queries(picobench::state& pb) {
+    benchmark(5, 0, 0, pb, lookup::stored_query);
+}
+PICOBENCH(stored_queries);
+
+void stored_types(picobench::state& pb) {
+    benchmark(5, 0, 0, pb, lookup::stored_type);
+}
+PICOBENCH(stored_types);
+
+// ftables are derived from existing types
+void derived(picobench::state& pb) {
+    benchmark(9, 20, 0, pb, lookup::derived);
+}
+PICOBENCH(derived);
+
+// compare with many_rules
+void manifest(picobench::state& pb) {
+    benchmark(5, 0, 10, pb, lookup::manifest);
+}
+PICOBENCH(manifest);
@@ -0,0 +1,111 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/domain.hpp>
+#include <dynamix/mixin_info_data.hpp>
+#include <dynamix/type.hpp>
+
+#include <picobench/picobench.hpp>
+
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <random>
+#include <thread>
+#include <atomic>
+
+// many threads requesting already created types from the same domain
+// the per-iteration time is per-thread, so with perfect scaling it doesn't change as threads are added
+
+constexpr int NUM_MIXINS = 20;
+constexpr int NUM_QUERIES = 500;
+
+struct state {
+    dynamix::domain dom{"bench"};
+    std::vector<std::unique_ptr<dynamix::util::mixin_info_data>> mixins;
+    std::vector<std::vector<const dynamix::mixin_info*>> queries;
+
+    state() {
+        for (int i = 0; i < NUM_MIXINS; ++i) {
+            auto& m = *mixins.emplace_back(new dynamix::util::mixin_info_data);
+            dynamix::util::mixin_info_data_builder b(m, "");
+            b.store_name("mixin_" + std::to_string(i));
+            m.register_in(dom);
+        }
+
+        std::minstd_rand rnd(42);
+        while (queries.size() != NUM_QUERIES) {
+            auto num_mixins = rnd() % 8 + 1;
+            std::unordered_set<uint32_t> mids;
+            while (mids.size() != num_mixins) {
+                mids.insert(rnd() % NUM_MIXINS);
+            }
+            auto& q = queries.emplace_back();
+            for (auto i : mids) {
+                q.push_back(&mixins[i]->info);
+            }
+            dom.get_type(q); // create type and store query
+        }
+    }
+};
+
+void benchmark(uint32_t num_threads, picobench::state& pb) {
+    static state s;
+
+    std::atomic_bool start = false;
+    std::atomic<size_t> total_mixins = 0;
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i]() {
+            std::minstd_rand rnd(i);
+            while (!start); // spin
+            size_t sum = 0;
+            for (int j = 0; j < pb.iterations(); ++j) {
+                auto& q = s.queries[rnd() % s.queries.size()];
+                sum += s.dom.get_type(q).num_mixins();
+            }
+            total_mixins += sum;
+        });
+    }
+
+    {
+        picobench::scope benchmark(pb);
+        start = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    pb.set_result(s.dom.num_types());
+}
+
+void threads_1(picobench::state& pb) {
+    benchmark(1, pb);
+}
+PICOBENCH(threads_1).baseline();
+
+void threads_2(picobench::state& pb) {
+    benchmark(2, pb);
+}
+PICOBENCH(threads_2);
+
+void threads_4(picobench::state& pb) {
+    benchmark(4, pb);
+}
+PICOBENCH(threads_4);
+
+void threads_8(picobench::state& pb) {
+    benchmark(8, pb);
+}
+PICOBENCH(threads_8);
+
+void threads_16(picobench::state& pb) {
+    benchmark(16, pb);
+}
+PICOBENCH(threads_16);
+
+void threads_64(picobench::state& pb) {
+    benchmark(64, pb);
+}
+PICOBENCH(threads_64);
@@ -51,24 +51,63 @@ typedef struct dnmx_ftable_entry {
 #endif
 } dnmx_ftable_entry;
 
+// a perfect hash of feature ids for compact ftables
+// the ids are split into buckets, and the keys of each bucket are displaced to free slots
+// (the hash is built by the domain and is not meant to be used directly)
+typedef struct dnmx_ftable_hash {
+    const dnmx_id_int_t* keys; // feature id per slot of the ftable
+    const uint32_t* displacements; // per bucket
+    uint32_t num_buckets;
+    uint32_t seed;
+} dnmx_ftable_hash;
+
+// multiplicative hashes reduced to ranges with a multiply-shift
+static FORCE_INLINE uint32_t dnmx_ftable_hash_bucket(dnmx_id_int_t id, uint32_t seed, uint32_t num_buckets) {
+    return (uint32_t)(((uint64_t)((id ^ seed) * 0x9E3779B1u) * num_buckets) >> 32);
+}
+static FORCE_INLINE uint32_t dnmx_ftable_hash_displaced_slot(dnmx_id_int_t id, uint32_t displacement, uint32_t length) {
+    return (uint32_t)(((uint64_t)((id ^ displacement) * 0x85EBCA77u) * length) >> 32);
+}
+
+// slot in an ftable with length entries in which the feature id may be
+static FORCE_INLINE uint32_t dnmx_ftable_hash_slot(const dnmx_ftable_hash* hash, uint32_t length, dnmx_id_int_t id) {
+    const uint32_t bucket = dnmx_ftable_hash_bucket(id, hash->seed, hash->num_buckets);
+    return dnmx_ftable_hash_displaced_slot(id, hash->displacements[bucket], length);
+}
+
 struct dnmx_basic_type {
     // ftable visible to C so that feature queries can be inlined there too
 
     // sparse array of ftable entry per feature id
     // an empty entry here may still be "implemented" by this type if it has a default payload
+    // in domains with compact_types (see domain_settings) it's instead an array of the entries of the
+    // implemented features, indexed by ftable_hash
     const dnmx_ftable_entry* ftable;
     uint32_t ftable_length;
 
+    // keys are null for sparse ftables
+    dnmx_ftable_hash ftable_hash;
+
 #if defined(__cplusplus)
     [[nodiscard]] FORCE_INLINE dnmx_ftable_entry ftable_at(dnmx_feature_id id) const noexcept {
-        if (id.i < ftable_length) return ftable[id.i];
+        if (!ftable_hash.keys) {
+            if (id.i < ftable_length) return ftable[id.i];
+            return {nullptr, nullptr, nullptr};
+        }
+        const auto slot = dnmx_ftable_hash_slot(&ftable_hash, ftable_length, id.i);
+        if (ftable_hash.keys[slot] == id.i) return ftable[slot];
         return {nullptr, nullptr, nullptr};
     }
 #endif
 };
 
 static FORCE_INLINE dnmx_ftable_entry dnmx_ftable_at(const struct dnmx_basic_type* type, dnmx_feature_id id) {
-    if (id.i < type->ftable_length) return type->ftable[id.i];
+    if (!type->ftable_hash.keys) {
+        if (id.i < type->ftable_length) return type->ftable[id.i];
+        return DNMX_EMPTY_T(dnmx_ftable_entry);
+    }
+    const uint32_t slot = dnmx_ftable_hash_slot(&type->ftable_hash, type->ftable_length, id.i);
+    if (type->ftable_hash.keys[slot] == id.i) return type->ftable[slot];
     return DNMX_EMPTY_T(dnmx_ftable_entry);
 }
 
@@ -0,0 +1,14 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+
+// hint that the memory at ptr will be read soon
+#if defined(__GNUC__)
+#define I_DYNAMIX_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define I_DYNAMIX_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#else
+#define I_DYNAMIX_PREFETCH(ptr) ((void)(ptr))
+#endif
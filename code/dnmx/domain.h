@@ -6,6 +6,8 @@
 
 #include "domain_handle.h"
 #include "basic_domain.h"
+#include "domain_stats.h"
+#include "domain_listener.h"
 
 #include "feature_id.h"
 #include "mixin_id.h"
@@ -47,16 +49,22 @@ DYNAMIX_API dnmx_error_return_t dnmx_register_feature(dnmx_domain_handle hd, dnm
 DYNAMIX_API void dnmx_unregister_feature(dnmx_domain_handle hd, dnmx_feature_info* info);
 DYNAMIX_API dnmx_error_return_t dnmx_register_mixin(dnmx_domain_handle hd, dnmx_mixin_info* info);
 DYNAMIX_API void dnmx_unregister_mixin(dnmx_domain_handle hd, dnmx_mixin_info* info);
+DYNAMIX_API dnmx_error_return_t dnmx_register_features(dnmx_domain_handle hd, dnmx_feature_info* const* infos, uint32_t num_infos);
+DYNAMIX_API dnmx_error_return_t dnmx_register_mixins(dnmx_domain_handle hd, dnmx_mixin_info* const* infos, uint32_t num_infos);
+DYNAMIX_API void dnmx_unregister_mixins(dnmx_domain_handle hd, dnmx_mixin_info* const* infos, uint32_t num_infos);
 
 DYNAMIX_API const dnmx_feature_info* dnmx_get_feature_info_by_id(dnmx_domain_handle hd, dnmx_feature_id id);
 DYNAMIX_API const dnmx_feature_info* dnmx_get_feature_info_by_name(dnmx_domain_handle hd, dnmx_sv name);
 DYNAMIX_API const dnmx_mixin_info* dnmx_get_mixin_info_by_id(dnmx_domain_handle hd, dnmx_mixin_id id);
 DYNAMIX_API const dnmx_mixin_info* dnmx_get_mixin_info_by_name(dnmx_domain_handle hd, dnmx_sv name);
 
-DYNAMIX_API dnmx_error_return_t dnmx_register_type_class(dnmx_domain_handle hd, const dnmx_type_class* tc);
-DYNAMIX_API void dnmx_unregister_type_class(dnmx_domain_handle hd, const dnmx_type_class* tc);
+DYNAMIX_API dnmx_error_return_t dnmx_register_type_class(dnmx_domain_handle hd, dnmx_type_class* tc);
+DYNAMIX_API void dnmx_unregister_type_class(dnmx_domain_handle hd, dnmx_type_class* tc);
 DYNAMIX_API const dnmx_type_class* dnmx_get_type_class_by_name(dnmx_domain_handle hd, dnmx_sv name);
 
+typedef void(*dnmx_type_visit_func)(dnmx_type_handle ht, uintptr_t user_data);
+DYNAMIX_API void dnmx_for_each_type_of(dnmx_domain_handle hd, const dnmx_type_class* tc, dnmx_type_visit_func func, uintptr_t user_data);
+
 DYNAMIX_API dnmx_error_return_t dnmx_add_mutation_rule(dnmx_domain_handle hd, const dnmx_mutation_rule_info* info);
 DYNAMIX_API void dnmx_remove_mutation_rule(dnmx_domain_handle hd, const dnmx_mutation_rule_info* info);
 
@@ -65,7 +73,10 @@ DYNAMIX_API dnmx_type_handle dnmx_get_type(dnmx_domain_handle hd, dnmx_type_muta
 
 DYNAMIX_API dnmx_type_handle dnmx_get_empty_type(dnmx_domain_handle hd);
 DYNAMIX_API size_t dnmx_get_num_types(dnmx_domain_handle hd);
+DYNAMIX_API dnmx_domain_stats dnmx_get_domain_stats(dnmx_domain_handle hd);
+DYNAMIX_API void dnmx_set_domain_listener(dnmx_domain_handle hd, const dnmx_domain_listener* listener);
 DYNAMIX_API void dnmx_garbage_collect_types(dnmx_domain_handle hd);
+DYNAMIX_API size_t dnmx_garbage_collect_types_step(dnmx_domain_handle hd, uint32_t budget);
 
 #if defined(__cplusplus)
 }
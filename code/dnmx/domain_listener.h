@@ -0,0 +1,70 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "domain_handle.h"
+#include "type_handle.h"
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+#include <itlib/span.hpp>
+extern "C" {
+#endif
+
+typedef struct dnmx_mixin_info dnmx_mixin_info;
+
+typedef enum dnmx_domain_event_type {
+    // a get_type request without a stored query (the event covers the entire request)
+    // mixins is the query and type is the resulting type (null if the request failed)
+    dnmx_domain_event_query_miss,
+
+    // a new type was built
+    // mixins are its mixins and type is the new type
+    // (it may be discarded later if an equivalent type was added in the meantime)
+    dnmx_domain_event_type_created,
+
+    // mutation rules were applied to a mutation
+    // mixins are the result and count is the number of passes over the rules
+    dnmx_domain_event_rules_applied,
+
+    // a garbage collection of types
+    // count is the number of collected types
+    dnmx_domain_event_gc,
+} dnmx_domain_event_type;
+
+typedef struct dnmx_domain_event {
+    dnmx_domain_event_type type;
+    dnmx_domain_handle dom;
+
+    // steady clock times in nanoseconds
+    uint64_t start_ns;
+    uint64_t duration_ns;
+
+    // valid only while the listener is being called
+    const dnmx_mixin_info* const* mixins;
+    uint32_t num_mixins;
+
+    dnmx_type_handle type_handle;
+    uint32_t count;
+
+#if defined(__cplusplus)
+    itlib::span<const dnmx_mixin_info* const> mixins_span() const noexcept {
+        return {mixins, num_mixins};
+    }
+#endif
+} dnmx_domain_event;
+
+typedef void(*dnmx_domain_listener_func)(const dnmx_domain_event* event, uintptr_t user_data);
+
+// a listener for the events of a domain (see domain::set_listener)
+// the listener is called from the thread which caused the event, possibly while internal locks of the
+// domain are held, so it must not call functions of the domain (or anything which may call them) and must not throw
+typedef struct dnmx_domain_listener {
+    dnmx_domain_listener_func on_event;
+    uintptr_t user_data;
+} dnmx_domain_listener;
+
+#if defined(__cplusplus)
+}
+#endif
@@ -28,4 +28,11 @@ typedef struct dnmx_domain_settings {
     // WARNING: if duplicate names exist,
     // any ops involing with mixin names will produce unpredictable results
     bool allow_duplicate_mixin_names;
+
+    // if true, types are stored in a compact form, suitable for domains with many features and mixins
+    // the ftables of types hold only the implemented features (in a perfect hash table by feature id)
+    // instead of an entry for every feature id up to the greatest one
+    // and the types don't have sparse mixin indices (mixin indices are found by the rank of the id in mixin_id_bits)
+    // this saves memory at the cost of slower feature and mixin lookups
+    bool compact_types;
 } dnmx_domain_settings;
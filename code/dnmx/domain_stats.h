@@ -0,0 +1,41 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <stdint.h>
+
+// instrumentation counters of a domain
+// they are counted with relaxed atomics and are always available
+// all of them are cumulative from the creation of the domain
+// (a snapshot is not atomic as a whole: the counters are read one by one)
+typedef struct dnmx_domain_stats {
+    // get_type requests for which a stored query was found (and ones for which it wasn't)
+    uint64_t type_query_hits;
+    uint64_t type_query_misses;
+
+    // times mutation rules were applied to a mutation (a query miss with rules in the domain)
+    // and the total number of passes over the rules (rules are reapplied while they change the mutation)
+    uint64_t rule_applications;
+    uint64_t rule_passes;
+
+    // new types added to the registry
+    uint64_t types_created;
+    // types which were built, but dropped, because an equivalent one was added in the meantime
+    uint64_t types_discarded;
+    // builds avoided because another thread was building the same type (see domain::num_avoided_type_builds)
+    uint64_t type_builds_avoided;
+
+    // garbage collection runs (explicit, automatic, and on zero objects) and types collected by them
+    uint64_t gc_runs;
+    uint64_t types_collected;
+
+    // acquisitions of the type registry lock and the time spent waiting for them
+    // (only contended acquisitions are timed)
+    uint64_t shared_locks;
+    uint64_t shared_lock_wait_ns;
+    uint64_t unique_locks;
+    uint64_t unique_lock_wait_ns;
+
+    // bytes allocated for the buffers of types
+    uint64_t type_bytes_allocated;
+} dnmx_domain_stats;
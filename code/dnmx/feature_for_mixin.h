@@ -22,6 +22,12 @@ typedef struct dnmx_feature_for_mixin {
     // perks
     int32_t bid;
     int32_t priority;
+
+    // optional payload which implements the feature for an array of instances of the mixin
+    // it's called instead of payload by batched calls (only msg unicasts use it)
+    // payload must not be null if this is not null
+    // (for messages it points to a msg_caller::batch_payload, see msg_traits::make_batch_payload_by)
+    dnmx_feature_payload batch_payload;
 } dnmx_feature_for_mixin;
 
 #if defined(__cplusplus)
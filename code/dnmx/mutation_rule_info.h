@@ -6,12 +6,25 @@
 #include "type_mutation_handle.h"
 #include "bits/sv.h"
 
+#include <stdbool.h>
+
 #if defined(__cplusplus)
+#include <itlib/span.hpp>
 extern "C" {
 #endif
 
+typedef struct dnmx_mixin_info dnmx_mixin_info;
+
 typedef dnmx_error_return_t(*dmmx_mutation_rule_apply_func)(dnmx_type_mutation_handle mutation, uintptr_t user_data);
 
+// a clause of a declarative mutation rule
+// if a mutation has the condition mixin, the target is added to it (or removed from it)
+typedef struct dnmx_mutation_rule_clause {
+    const dnmx_mixin_info* condition;
+    const dnmx_mixin_info* target;
+    bool remove;
+} dnmx_mutation_rule_clause;
+
 // it is not safe to change the values of a mutation rule info once it's added
 // unlike features and mixins, the same rule can be added to multiple domains
 // it also safe (noop-like) to add the same mutation rule to the same domain
@@ -21,6 +34,7 @@ typedef struct dnmx_mutation_rule_info {
 
     // the function which applies the rule
     // if it returns an error or throws, the mutation is considered flawed and no type will be created
+    // it can be null for declarative rules (which have clauses)
     dmmx_mutation_rule_apply_func apply;
 
     // optional user data for rule to be provided to apply function
@@ -32,8 +46,42 @@ typedef struct dnmx_mutation_rule_info {
     // if the names are also the same, executed in an indeterminate order
     int32_t order_priority;
 
+    // optional declaration of the mixins the rule reacts to and the mixins it may add or remove
+    // when a rule which declares mixins is added or removed, only the stored type queries which involve
+    // them (contain them or lead to types which have them) are invalidated
+    // if a rule declares nothing, it's opaque and all stored type queries are invalidated
+    // a rule which declares mixins must not change mutations which have none of the ones it reacts to
+    // (ie rules which react to the absence of mixins must not declare anything)
+    const dnmx_mixin_info* const* reacts_to;
+    uint32_t num_reacts_to;
+    const dnmx_mixin_info* const* changes;
+    uint32_t num_changes;
+
+    // optional clauses of a declarative rule
+    // the clauses of all rules are compiled by the domain and evaluated to a fixed point in a single pass
+    // (additions are propagated in the order in which they become active, regardless of order_priority)
+    // removals win over additions: a mixin which is removed by an active clause is never added
+    // and the additions caused by removed mixins are dropped
+    // declarative rules are evaluated before the ones with an apply function
+    // a rule without an apply function is never opaque as the mixins it reacts to and changes are known
+    const dnmx_mutation_rule_clause* clauses;
+    uint32_t num_clauses;
+
 #if defined(__cplusplus)
     using apply_func = dmmx_mutation_rule_apply_func;
+
+    itlib::span<const dnmx_mixin_info* const> reacts_to_span() const noexcept {
+        return {reacts_to, num_reacts_to};
+    }
+    itlib::span<const dnmx_mixin_info* const> changes_span() const noexcept {
+        return {changes, num_changes};
+    }
+    itlib::span<const dnmx_mutation_rule_clause> clauses_span() const noexcept {
+        return {clauses, num_clauses};
+    }
+    bool is_opaque() const noexcept {
+        return apply && num_reacts_to == 0 && num_changes == 0;
+    }
 #endif
 } dnmx_mutation_rule_info;
 
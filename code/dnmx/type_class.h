@@ -5,6 +5,16 @@
 #include "bits/sv.h"
 #include "bits/noexcept.h"
 #include "type_handle.h"
+#include "domain_handle.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+#include <itlib/span.hpp>
+#endif
+
+typedef struct dnmx_mixin_info dnmx_mixin_info;
 
 typedef bool (*dnmx_type_class_match_func)(dnmx_type_handle) DNMX_NOEXCEPT;
 
@@ -12,6 +22,35 @@ typedef struct dnmx_type_class {
     // may be left empty, but in such a case the type class cannot be registered in a domain
     dnmx_sv name;
 
-    // this must not be left null: it's always assumed to not be null
+    // the match function
+    // it can be null for declarative type classes (which have required or forbidden mixins)
+    // if it's not null, the required and forbidden mixins are ignored
     dnmx_type_class_match_func matches;
+
+    // optional declaration of a type class: the types which have all required mixins and none of the forbidden ones
+    // when a declarative type class is registered, the domain compiles it to bitsets of mixin ids, so
+    // its mixins must be registered in the domain before it, and can't be unregistered while it's registered
+    // (unregistering them throws)
+    const dnmx_mixin_info* const* required;
+    uint32_t num_required;
+    const dnmx_mixin_info* const* forbidden;
+    uint32_t num_forbidden;
+
+    // will be set by the domain once registered
+    // a type class can be registered in a single domain at a time
+    // the id is its slot in the domain, by which types cache their results for it
+    dnmx_domain_handle dom;
+    uint32_t id;
+
+#if defined(__cplusplus)
+    using match_func = dnmx_type_class_match_func;
+
+    itlib::span<const dnmx_mixin_info* const> required_span() const noexcept {
+        return {required, num_required};
+    }
+    itlib::span<const dnmx_mixin_info* const> forbidden_span() const noexcept {
+        return {forbidden, num_forbidden};
+    }
+    bool declarative() const noexcept { return !matches; }
+#endif
 } dnmx_type_class;
@@ -9,6 +9,7 @@
 #include "domain_handle.h"
 #include "type_handle.h"
 #include "mixin_index.h"
+#include "mixin_id.h"
 
 #include "bits/sv.h"
 
@@ -27,6 +28,8 @@ DYNAMIX_API dnmx_domain_handle dnmx_type_mutation_get_domain(dnmx_type_mutation_
 
 DYNAMIX_API bool dnmx_type_mutation_has(dnmx_type_mutation_handle hmut, const dnmx_mixin_info* info);
 DYNAMIX_API const dnmx_mixin_info* dnmx_type_mutation_has_by_name(dnmx_type_mutation_handle hmut, dnmx_sv name);
+// constant time membership test by id (only mixins registered in the mutation's domain have ids)
+DYNAMIX_API bool dnmx_type_mutation_has_id(dnmx_type_mutation_handle hmut, dnmx_mixin_id id);
 DYNAMIX_API bool dnmx_type_mutation_implements_strong(dnmx_type_mutation_handle hmut, const dnmx_feature_info* info);
 DYNAMIX_API const dnmx_feature_info* dnmx_type_mutation_implements_strong_by_name(dnmx_type_mutation_handle hmut, dnmx_sv name);
 DYNAMIX_API bool dnmx_type_mutation_implements(dnmx_type_mutation_handle hmut, const dnmx_feature_info* info);
@@ -0,0 +1,73 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "thread_slot.hpp"
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+namespace dynamix::bits {
+
+// a minimal epoch-based reclamation scheme for data which is published through atomic pointers
+// readers enter a read-side critical section which never locks
+// writers publish a new version of the data, then call synchronize() to wait until no reader
+// which could have observed the old version remains, after which the old version can be freed
+//
+// readers are spread over cache-line-sized slots (per thread) so that they don't contend with each other
+// each slot has two counters: one per epoch parity
+// synchronize flips the epoch and waits for the counters of the previous parity to drain
+//
+// writers must be serialized externally (only one synchronize at a time)
+// a reader must never call synchronize (or wait for a writer which does) while inside a critical section
+class epoch {
+public:
+    static constexpr uint32_t num_slots = 64;
+
+    class read_guard {
+    public:
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+        ~read_guard() {
+            m_counter.fetch_sub(1, std::memory_order_release);
+        }
+    private:
+        friend class epoch;
+        explicit read_guard(std::atomic<uint32_t>& counter) noexcept : m_counter(counter) {}
+        std::atomic<uint32_t>& m_counter;
+    };
+
+    [[nodiscard]] read_guard enter() noexcept {
+        auto& s = m_slots[this_thread_slot() % num_slots];
+        while (true) {
+            const auto parity = m_epoch.load() & 1;
+            auto& counter = s.readers[parity];
+            counter.fetch_add(1);
+
+            // the epoch may have been flipped before we got to increment the counter
+            // in such case a writer could have already checked it and we must try again
+            if ((m_epoch.load() & 1) == parity) return read_guard(counter);
+
+            counter.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void synchronize() noexcept {
+        const auto old_parity = m_epoch.fetch_add(1) & 1;
+        for (auto& s : m_slots) {
+            while (s.readers[old_parity].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> m_epoch = {};
+
+    struct alignas(64) slot {
+        std::atomic<uint32_t> readers[2] = {};
+    };
+    slot m_slots[num_slots];
+};
+
+}
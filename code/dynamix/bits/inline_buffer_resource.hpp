@@ -0,0 +1,55 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../compat/pmr/memory_resource.hpp"
+#include <cstddef>
+
+namespace dynamix::bits {
+
+// a memory resource which serves one block at a time from an inline buffer
+// allocations which don't fit (or are made while the buffer is in use) go to the upstream resource
+// it's meant for a single container which is usually small:
+// reserving the buffer capacity after constructing the container makes its allocations free
+// unless it grows beyond that
+template <std::size_t Size, std::size_t Align = alignof(std::max_align_t)>
+class inline_buffer_resource final : public compat::pmr::memory_resource {
+public:
+    explicit inline_buffer_resource(compat::pmr::memory_resource* upstream) noexcept
+        : m_upstream(upstream)
+    {}
+
+    inline_buffer_resource(const inline_buffer_resource&) = delete;
+    inline_buffer_resource& operator=(const inline_buffer_resource&) = delete;
+
+    static constexpr std::size_t buffer_size = Size;
+
+    compat::pmr::memory_resource* upstream() const noexcept { return m_upstream; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (!m_in_use && bytes <= Size && alignment <= Align) {
+            m_in_use = true;
+            return m_buf;
+        }
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (p == m_buf) {
+            m_in_use = false;
+            return;
+        }
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const compat::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    compat::pmr::memory_resource* m_upstream;
+    bool m_in_use = false;
+    alignas(Align) std::byte m_buf[Size];
+};
+
+}
@@ -0,0 +1,18 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace dynamix {
+// hash of names of mixins, features, and type classes used by name indices (fnv-1a)
+inline size_t name_hash(std::string_view name) noexcept {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (auto c : name) {
+        h = (h ^ uint8_t(c)) * 0x100000001b3ull;
+    }
+    return size_t(h ^ (h >> 32));
+}
+}
@@ -0,0 +1,22 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <cstdint>
+
+namespace dynamix::bits {
+
+// std::popcount is C++20
+inline uint32_t popcount(uint64_t x) noexcept {
+#if defined(__GNUC__)
+    return uint32_t(__builtin_popcountll(x));
+#else
+    // msvc's __popcnt64 requires the instruction (and x64), so we don't use it
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return uint32_t((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+}
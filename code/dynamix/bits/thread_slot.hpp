@@ -0,0 +1,19 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace dynamix::bits {
+
+// index of the current thread which is used to spread threads over slots of per-thread data
+// (take it modulo the number of slots)
+// threads get consecutive indices as they first ask for one, so that the first threads don't share slots
+inline uint32_t this_thread_slot() noexcept {
+    static std::atomic<uint32_t> next_slot = {};
+    thread_local const uint32_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+}
@@ -95,7 +95,7 @@ void dbg_dmp_l(std::ostream& out, const type& t, uint32_t flags, domain_traverse
     if (tr && (flags & dnmx_type_dmp_matching_type_classes)) {
         out << NIND "matching type classes:";
         tr->traverse_type_classes([&](const type_class& tc) {
-            if (!tc.matches(&t)) return;
+            if (!t.is_of(tc)) return;
             out << NIND IND << tc.name.to_std();
         });
     }
@@ -103,9 +103,12 @@ void dbg_dmp_l(std::ostream& out, const type& t, uint32_t flags, domain_traverse
 
 void dbg_dmp_l(std::ostream& out, const type_class& tc, uint32_t flags, domain_traverse* tr) {
     out << "type class: '" << tc.name.to_std() << ", match: " << p(tc.matches);
-    if (tc.matches && tr && (flags & dnmx_tc_dmp_matching_types)) {
+    if (tc.declarative()) {
+        out << ", required: " << tc.num_required << ", forbidden: " << tc.num_forbidden;
+    }
+    if (tr && (flags & dnmx_tc_dmp_matching_types)) {
         tr->traverse_types([&](const type& t) {
-            if (!tc.matches(&t)) return;
+            if (!t.is_of(tc)) return;
             out << "match ";
             dbg_dmp(out, t, 0);
         });
@@ -141,6 +144,19 @@ void dbg_dmp(std::ostream& out, const domain& d, uint32_t flags) {
         out << NIND "canonicalize_types: " << s.canonicalize_types;
         out << NIND "allow_duplicate_feature_names: " << s.allow_duplicate_feature_names;
         out << NIND "allow_duplicate_mixin_names: " << s.allow_duplicate_mixin_names;
+        out << NIND "compact_types: " << s.compact_types;
+        out << '\n';
+    }
+    if (flags & dnmx_dom_dmp_stats) {
+        auto s = d.stats();
+        out << "## Stats";
+        out << NIND "type queries: " << s.type_query_hits << " hits, " << s.type_query_misses << " misses";
+        out << NIND "rules: " << s.rule_applications << " applications, " << s.rule_passes << " passes";
+        out << NIND "types: " << s.types_created << " created, " << s.types_discarded << " discarded, "
+            << s.type_builds_avoided << " builds avoided, " << s.type_bytes_allocated << " bytes allocated";
+        out << NIND "gc: " << s.gc_runs << " runs, " << s.types_collected << " types collected";
+        out << NIND "locks: " << s.shared_locks << " shared (" << s.shared_lock_wait_ns << " ns wait), "
+            << s.unique_locks << " unique (" << s.unique_lock_wait_ns << " ns wait)";
         out << '\n';
     }
     if (flags & dnmx_dom_dmp_features) {
@@ -279,6 +295,7 @@ void dbg_dmp(std::ostream& out, const feature_info& fi, uint32_t) {
 void dbg_dmp(std::ostream& out, const mutation_rule_info& mri, uint32_t) {
     out << "rule: '" << mri.name.to_std() << "', prio: " << mri.order_priority
         << ", ud: " << mri.user_data << ", apply: " << p(mri.apply);
+    if (mri.num_clauses) out << ", clauses: " << mri.num_clauses;
 }
 
 void dbg_dmp(std::ostream& out, const type& t, uint32_t flags) {
@@ -19,6 +19,7 @@ enum dnmx_dbg_dmp_flags {
     dnmx_dom_dmp_types = 0x10,
     dnmx_dom_dmp_type_queries = 0x20,
     dnmx_dom_dmp_settings = 0x40,
+    dnmx_dom_dmp_stats = 0x80,
     dnmx_dom_dmp_all = 0xFF,
 
     dnmx_mixin_dmp_ex = 0x100,
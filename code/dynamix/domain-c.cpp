@@ -55,6 +55,30 @@ void dnmx_unregister_mixin(dnmx_domain_handle hd, dnmx_mixin_info* info) {
     self->unregister_mixin(*info);
 }
 
+dnmx_error_return_t dnmx_register_features(dnmx_domain_handle hd, dnmx_feature_info* const* infos, uint32_t num_infos) {
+    try {
+        self->register_features({infos, num_infos});
+        return dnmx_result_success;
+    }
+    catch (std::exception&) {
+        return -1;
+    }
+}
+
+dnmx_error_return_t dnmx_register_mixins(dnmx_domain_handle hd, dnmx_mixin_info* const* infos, uint32_t num_infos) {
+    try {
+        self->register_mixins({infos, num_infos});
+        return dnmx_result_success;
+    }
+    catch (std::exception&) {
+        return -1;
+    }
+}
+
+void dnmx_unregister_mixins(dnmx_domain_handle hd, dnmx_mixin_info* const* infos, uint32_t num_infos) {
+    self->unregister_mixins({infos, num_infos});
+}
+
 const dnmx_feature_info* dnmx_get_feature_info_by_id(dnmx_domain_handle hd, dnmx_feature_id id) {
     return self->get_feature_info(id);
 }
@@ -71,7 +95,7 @@ const dnmx_mixin_info* dnmx_get_mixin_info_by_name(dnmx_domain_handle hd, dnmx_s
     return self->get_mixin_info(name.to_std());
 }
 
-dnmx_error_return_t dnmx_register_type_class(dnmx_domain_handle hd, const dnmx_type_class* tc) {
+dnmx_error_return_t dnmx_register_type_class(dnmx_domain_handle hd, dnmx_type_class* tc) {
     try {
         self->register_type_class(*tc);
         return dnmx_result_success;
@@ -81,7 +105,7 @@ dnmx_error_return_t dnmx_register_type_class(dnmx_domain_handle hd, const dnmx_t
     }
 }
 
-void dnmx_unregister_type_class(dnmx_domain_handle hd, const dnmx_type_class* tc) {
+void dnmx_unregister_type_class(dnmx_domain_handle hd, dnmx_type_class* tc) {
     self->unregister_type_class(*tc);
 }
 
@@ -89,6 +113,12 @@ const dnmx_type_class* dnmx_get_type_class_by_name(dnmx_domain_handle hd, dnmx_s
     return self->get_type_class(name.to_std());
 }
 
+void dnmx_for_each_type_of(dnmx_domain_handle hd, const dnmx_type_class* tc, dnmx_type_visit_func func, uintptr_t user_data) {
+    self->for_each_type_of(*tc, [&](const dynamix::type& t) {
+        func(&t, user_data);
+    });
+}
+
 dnmx_error_return_t dnmx_add_mutation_rule(dnmx_domain_handle hd, const dnmx_mutation_rule_info* info) {
     try {
         self->add_mutation_rule(*info);
@@ -129,9 +159,19 @@ dnmx_type_handle dnmx_get_empty_type(dnmx_domain_handle hd) {
 size_t dnmx_get_num_types(dnmx_domain_handle hd) {
     return self->num_types();
 }
+dnmx_domain_stats dnmx_get_domain_stats(dnmx_domain_handle hd) {
+    return self->stats();
+}
+void dnmx_set_domain_listener(dnmx_domain_handle hd, const dnmx_domain_listener* listener) {
+    self->set_listener(listener);
+}
 
 void dnmx_garbage_collect_types(dnmx_domain_handle hd) {
     self->garbage_collect_types();
 }
 
+size_t dnmx_garbage_collect_types_step(dnmx_domain_handle hd, uint32_t budget) {
+    return self->garbage_collect_types_step(budget);
+}
+
 }
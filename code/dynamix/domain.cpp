@@ -13,16 +13,30 @@
 #include "throw_exception.hpp"
 #include "domain_traverse.hpp"
 
+#include "bits/epoch.hpp"
+#include "bits/thread_slot.hpp"
+#include "bits/name_hash.hpp"
+#include "bits/inline_buffer_resource.hpp"
+
 #include <itlib/qalgorithm.hpp>
 #include <itlib/data_mutex.hpp>
+#include <itlib/atomic.hpp>
 #include <itlib/flat_map.hpp>
 
 #include "compat/pmr/vector.hpp"
-#include "compat/pmr/set.hpp"
-#include "compat/pmr/map.hpp"
 
 #include <memory>
+#include <algorithm>
+#include <functional>
 #include <limits>
+#include <atomic>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <exception>
+#include <chrono>
 #include <cassert>
 
 #if 0
@@ -62,16 +76,91 @@ using mixin_info_span = const itlib::span<const mixin_info* const>;
 template <typename T>
 using data_mutex = itlib::data_mutex<T, shared_mutex>;
 
-bool mixin_span_less(const mixin_info_span& a, const mixin_info_span& b) {
-    // first compare sizes, which greatly improves performance of searches
-    // (we don't actually care about the order of the types or queries)
-    size_t as = a.size(), bs = b.size();
-    if (as != bs) return as < bs;
-    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+// a shared mutex which adds the time spent waiting for it to counters
+// locks are first tried, so that uncontended ones don't read the clock
+class timed_shared_mutex {
+public:
+    std::atomic<uint64_t> shared_wait_ns = {};
+    std::atomic<uint64_t> unique_wait_ns = {};
+
+    void lock_shared() {
+        if (m_mutex.try_lock_shared()) return;
+        wait_timer timer{shared_wait_ns};
+        m_mutex.lock_shared();
+    }
+    bool try_lock_shared() { return m_mutex.try_lock_shared(); }
+    void unlock_shared() { m_mutex.unlock_shared(); }
+
+    void lock() {
+        if (m_mutex.try_lock()) return;
+        wait_timer timer{unique_wait_ns};
+        m_mutex.lock();
+    }
+    bool try_lock() { return m_mutex.try_lock(); }
+    void unlock() { m_mutex.unlock(); }
+private:
+    shared_mutex m_mutex;
+
+    struct wait_timer {
+        std::atomic<uint64_t>& ns;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ~wait_timer() {
+            auto d = std::chrono::steady_clock::now() - start;
+            ns.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()), std::memory_order_relaxed);
+        }
+    };
+};
+
+// data with a held lock of its mutex (as the locks of data_mutex)
+template <typename T, typename Lock>
+class registry_lock {
+public:
+    registry_lock(T& data, Lock lock) noexcept : m_data(&data), m_lock(std::move(lock)) {}
+    T* operator->() const noexcept { return m_data; }
+    T& operator*() const noexcept { return *m_data; }
+private:
+    T* m_data;
+    Lock m_lock;
+};
+
+bool mixin_span_equal(const mixin_info_span& a, const mixin_info_span& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+// add a value to a running hash
+// the value bits are mixed (splitmix64 finalizer), as pointers and small ints have low entropy
+uint64_t hash_add(uint64_t h, uint64_t x) noexcept {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return (h ^ x) * 0x100000001b3ull;
+}
+
+// serials of types (see type::serial)
+uint64_t next_type_serial() noexcept {
+    static std::atomic<uint64_t> last = 0;
+    return last.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+// hash of a sequence of mixin pointers (it depends on the order)
+size_t mixin_span_hash(const mixin_info_span& mixins) noexcept {
+    uint64_t h = 0xcbf29ce484222325ull ^ mixins.size();
+    for (auto m : mixins) {
+        h = hash_add(h, reinterpret_cast<uintptr_t>(m));
+    }
+    return size_t(h ^ (h >> 32));
+}
+
+// capacity for open-addressing tables with a load factor of at most 1/2
+uint32_t hash_table_capacity_for(size_t size) noexcept {
+    uint32_t capacity = 16;
+    while (capacity < size * 2) capacity *= 2;
+    return capacity;
+}
+
+int64_t gc_now() noexcept {
+    return int64_t(std::chrono::steady_clock::now().time_since_epoch().count());
 }
-//bool mixin_span_equal(const mixin_info_span& a, const mixin_info_span& b) {
-//    return std::equal(a.begin(), a.end(), b.begin(), b.end());
-//}
 }
 
 class domain::impl {
@@ -80,29 +169,334 @@ public:
 
     allocator m_allocator;
 
+    // open-addressing hash table of infos by name (linear probing)
+    // with duplicate names only one of the infos is indexed (the one which the user finds)
+    template <typename T>
+    class name_index {
+        struct slot {
+            size_t hash;
+            const T* info; // null for empty slots
+        };
+        compat::pmr::vector<slot> m_slots; // power of two size (or empty)
+        size_t m_size = 0;
+    public:
+        explicit name_index(allocator alloc) : m_slots(alloc) {}
+
+        size_t size() const noexcept { return m_size; }
+
+        void reserve(size_t size) {
+            if (size * 2 > m_slots.size()) rehash(hash_table_capacity_for(size));
+        }
+
+        const T* find(std::string_view name, size_t hash) const noexcept {
+            auto i = find_slot(name, hash);
+            if (i == m_slots.size()) return nullptr;
+            return m_slots[i].info;
+        }
+
+        // add info (no info with the same name must be indexed)
+        void insert(const T& info, size_t hash) {
+            if ((m_size + 1) * 2 > m_slots.size()) rehash(hash_table_capacity_for(m_size + 1));
+            place({hash, &info});
+            ++m_size;
+        }
+
+        // replace the indexed info with another one with the same name
+        void replace(const T& info, size_t hash) noexcept {
+            auto i = find_slot(info.name.to_std(), hash);
+            assert(i != m_slots.size());
+            m_slots[i].info = &info;
+        }
+
+        // erase the indexed info
+        // the others are shifted back to fill the hole in their probe sequence
+        void erase(const T& info, size_t hash) noexcept {
+            size_t hole = find_slot(info.name.to_std(), hash);
+            assert(hole != m_slots.size() && m_slots[hole].info == &info);
+            const size_t mask = m_slots.size() - 1;
+            m_slots[hole] = {};
+            --m_size;
+
+            for (size_t i = (hole + 1) & mask; m_slots[i].info; i = (i + 1) & mask) {
+                // an entry can be moved to the hole if its home slot is not in (hole, i]
+                const size_t home = m_slots[i].hash & mask;
+                const bool stays = hole < i ? (hole < home && home <= i) : (hole < home || home <= i);
+                if (stays) continue;
+                m_slots[hole] = m_slots[i];
+                m_slots[i] = {};
+                hole = i;
+            }
+        }
+    private:
+        // slot of the name or m_slots.size() if it's not in the index
+        size_t find_slot(std::string_view name, size_t hash) const noexcept {
+            if (m_slots.empty()) return 0;
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = hash & mask; m_slots[i].info; i = (i + 1) & mask) {
+                auto& s = m_slots[i];
+                if (s.hash == hash && s.info->name == name) return i;
+            }
+            return m_slots.size();
+        }
+
+        void place(const slot& s) noexcept {
+            const size_t mask = m_slots.size() - 1;
+            size_t i = s.hash & mask;
+            while (m_slots[i].info) i = (i + 1) & mask;
+            m_slots[i] = s;
+        }
+
+        void rehash(uint32_t capacity) {
+            compat::pmr::vector<slot> old(capacity, slot{}, m_slots.get_allocator());
+            old.swap(m_slots);
+            for (auto& s : old) {
+                if (s.info) place(s);
+            }
+        }
+    };
+
+    // append-only array of infos by id (null elements are free slots)
+    // it is modified under the element registry lock, but can be read by id without locking:
+    // chunks are never moved or freed and slots are published atomically, so reads are wait-free
+    // chunk k has first_chunk_size << k slots, thus a fixed number of chunks covers all ids
+    template <typename T>
+    class sparse_array {
+        using slot = std::atomic<const T*>;
+        static constexpr uint32_t first_chunk_size = 64;
+        static constexpr uint32_t max_chunks = 27;
+
+        allocator m_alloc;
+        std::atomic<slot*> m_chunks[max_chunks] = {};
+        uint32_t m_num_chunks = 0;
+        size_t m_capacity = 0;
+        std::atomic<uint32_t> m_size = {}; // published to readers with release
+
+        static size_t chunk_size(uint32_t k) noexcept { return size_t(first_chunk_size) << k; }
+
+        slot& at(uint32_t i) const noexcept {
+            // chunk k starts at first_chunk_size * (2^k - 1)
+            const uint32_t v = i / first_chunk_size + 1;
+            uint32_t k = 0;
+            while (v >> (k + 1)) ++k;
+            const uint32_t offset = i - first_chunk_size * ((1u << k) - 1);
+            return m_chunks[k].load(std::memory_order_acquire)[offset];
+        }
+    public:
+        explicit sparse_array(allocator alloc) : m_alloc(alloc) {}
+        sparse_array(const sparse_array&) = delete;
+        sparse_array& operator=(const sparse_array&) = delete;
+        ~sparse_array() {
+            for (uint32_t k = 0; k < m_num_chunks; ++k) {
+                m_alloc.deallocate_bytes(m_chunks[k].load(std::memory_order_relaxed), chunk_size(k) * sizeof(slot), alignof(slot));
+            }
+        }
+
+        // lock-free
+        const T* find(uint32_t i) const noexcept {
+            if (i >= m_size.load(std::memory_order_acquire)) return nullptr;
+            return at(i).load(std::memory_order_acquire);
+        }
+
+        // the following must be called under the lock
+
+        uint32_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+        const T* operator[](uint32_t i) const noexcept { return at(i).load(std::memory_order_relaxed); }
+
+        void reserve(size_t size) {
+            while (m_capacity < size) {
+                assert(m_num_chunks < max_chunks);
+                const auto csize = chunk_size(m_num_chunks);
+                auto chunk = static_cast<slot*>(m_alloc.allocate_bytes(csize * sizeof(slot), alignof(slot)));
+                for (size_t i = 0; i < csize; ++i) new (chunk + i) slot(nullptr);
+                m_chunks[m_num_chunks++].store(chunk, std::memory_order_release);
+                m_capacity += csize;
+            }
+        }
+
+        // space must be reserved
+        void push_back(const T* info) noexcept {
+            const auto size = this->size();
+            assert(size < m_capacity);
+            at(size).store(info, std::memory_order_relaxed);
+            m_size.store(size + 1, std::memory_order_release);
+        }
+
+        void set(uint32_t i, const T* info) noexcept {
+            assert(i < size());
+            at(i).store(info, std::memory_order_release);
+        }
+    };
+
+    // infos by id
+    // these are modified under the element registry lock, but are read without locking
+    sparse_array<feature_info> m_sparse_features;
+    sparse_array<mixin_info> m_sparse_mixins;
+    sparse_array<type_class> m_sparse_type_classes;
+
+    // a declarative type class compiled to bitsets of mixin ids (as type::mixin_id_bits)
+    // the struct is followed by the words of the required bitset, then by the ones of the forbidden
+    // trailing zero words are not stored
+    struct type_class_masks {
+        uint32_t num_required;
+        uint32_t num_forbidden;
+
+        itlib::span<const uint64_t> required() const noexcept {
+            return {reinterpret_cast<const uint64_t*>(this + 1), num_required};
+        }
+        itlib::span<const uint64_t> forbidden() const noexcept {
+            return {reinterpret_cast<const uint64_t*>(this + 1) + num_required, num_forbidden};
+        }
+        byte_size_t buf_size() const noexcept {
+            return byte_size_t(sizeof(type_class_masks) + (num_required + num_forbidden) * sizeof(uint64_t));
+        }
+
+        // whether the mixin with this id is required or forbidden
+        bool references(dnmx_id_int_t id) const noexcept {
+            const auto word = id / 64;
+            const auto bit = uint64_t(1) << (id % 64);
+            const auto req = required();
+            const auto forb = forbidden();
+            return (word < req.size() && (req[word] & bit)) || (word < forb.size() && (forb[word] & bit));
+        }
+
+        // written as reductions over all words, so that compilers can vectorize them
+        bool match(itlib::span<const uint64_t> bits) const noexcept {
+            const auto req = required();
+            if (req.size() > bits.size()) return false; // the type doesn't have mixins with such ids
+            uint64_t missing = 0;
+            for (size_t i = 0; i < req.size(); ++i) {
+                missing |= req[i] & ~bits[i];
+            }
+            const auto forb = forbidden();
+            const auto nf = std::min(forb.size(), bits.size());
+            uint64_t present = 0;
+            for (size_t i = 0; i < nf; ++i) {
+                present |= forb[i] & bits[i];
+            }
+            return !(missing | present);
+        }
+    };
+
+    // parallel to m_sparse_type_classes: null for the type classes which are not declarative
+    sparse_array<type_class_masks> m_sparse_type_class_masks;
+
     // registry of type elements
     // this is separate from the type registry because it can be locked independently
     // (and does get locked recursively when applying mutation rules)
     struct element_registry {
         element_registry(allocator alloc)
-            : sparse_features(alloc)
-            , sparse_mixins(alloc)
-            , sparse_type_classes(alloc)
+            : features_by_name(alloc)
+            , mixins_by_name(alloc)
+            , type_classes_by_name(alloc)
+            , free_feature_ids(alloc)
+            , free_mixin_ids(alloc)
         {}
 
-        // sparse arrays of info per id
-        // null elements have been unregistered and are free slots for future registers
-        compat::pmr::vector<const feature_info*> sparse_features;
-        compat::pmr::vector<const mixin_info*> sparse_mixins;
-        compat::pmr::vector<const type_class*> sparse_type_classes;
+        // name indices
+        // with duplicate names, the info with the lowest id is indexed
+        name_index<feature_info> features_by_name;
+        name_index<mixin_info> mixins_by_name;
+        name_index<type_class> type_classes_by_name;
+
+        // ids of null elements in m_sparse_* (min-heaps)
+        compat::pmr::vector<dnmx_id_int_t> free_feature_ids;
+        compat::pmr::vector<dnmx_id_int_t> free_mixin_ids;
     };
     data_mutex<element_registry> m_element_registry;
 
+    // the ftable of a type is allocated separately from the type buffer, so that it can be shared
+    // types with equal ftables (for example ones which differ only in mixins without features) share one
+    // the buffer is: this header, the entries, the payloads, and for compact ftables the hash keys and displacements
+    // the blocks are immutable once they're built
+    struct ftable_block {
+        size_t content_hash;
+        dnmx_ftable_hash ftable_hash; // keys are null for sparse ftables
+        uint32_t length; // number of entries
+        uint32_t num_payloads;
+        byte_size_t buf_size; // including this header
+
+        // number of types in the registry which use the block (see ftable_set)
+        // zero if the block is not interned and owned by a single type
+        uint32_t ref_count;
+
+        const type::ftable_entry* entries() const noexcept {
+            return reinterpret_cast<const type::ftable_entry*>(this + 1);
+        }
+        const type::ftable_payload* payloads() const noexcept {
+            return reinterpret_cast<const type::ftable_payload*>(entries() + length);
+        }
+
+        // null if the type has no ftable
+        static ftable_block* of(const type& t) noexcept {
+            if (!t.ftable) return nullptr;
+            auto ptr = reinterpret_cast<const byte_t*>(t.ftable) - sizeof(ftable_block);
+            return reinterpret_cast<ftable_block*>(const_cast<byte_t*>(ptr));
+        }
+
+        static void free(allocator& alloc, ftable_block* block) noexcept {
+            alloc.deallocate_bytes(block, block->buf_size, alignof(ftable_block));
+        }
+
+        // the content is compared position-independently (entry pointers are compared as offsets)
+        void calc_content_hash() noexcept {
+            auto pls = payloads();
+            uint64_t h = 0xcbf29ce484222325ull ^ length;
+            for (auto e = entries(); e != entries() + length; ++e) {
+                if (!*e) {
+                    h = hash_add(h, 0);
+                    continue;
+                }
+                h = hash_add(h, uint64_t(e->begin - pls) + 1);
+                h = hash_add(h, uint64_t(e->end - e->begin));
+            }
+            for (auto pl = pls; pl != pls + num_payloads; ++pl) {
+                h = hash_add(h, pl->mixin_index);
+                h = hash_add(h, reinterpret_cast<uintptr_t>(pl->data));
+            }
+            content_hash = size_t(h ^ (h >> 32));
+        }
+
+        bool content_equal(const ftable_block& other) const noexcept {
+            if (content_hash != other.content_hash) return false;
+            if (length != other.length || num_payloads != other.num_payloads) return false;
+
+            if (!ftable_hash.keys != !other.ftable_hash.keys) return false;
+            if (ftable_hash.keys) {
+                if (ftable_hash.seed != other.ftable_hash.seed || ftable_hash.num_buckets != other.ftable_hash.num_buckets) return false;
+                if (!std::equal(ftable_hash.keys, ftable_hash.keys + length, other.ftable_hash.keys)) return false;
+                if (!std::equal(ftable_hash.displacements, ftable_hash.displacements + ftable_hash.num_buckets, other.ftable_hash.displacements)) return false;
+            }
+
+            auto pls = payloads();
+            auto opls = other.payloads();
+            for (uint32_t i = 0; i < length; ++i) {
+                auto& e = entries()[i];
+                auto& oe = other.entries()[i];
+                if (!e != !oe) return false;
+                if (!e) continue;
+                if (e.begin - pls != oe.begin - opls) return false;
+                if (e.top_bid_back - e.begin != oe.top_bid_back - oe.begin) return false;
+                if (e.end - e.begin != oe.end - oe.begin) return false;
+            }
+            for (uint32_t i = 0; i < num_payloads; ++i) {
+                auto& pl = pls[i];
+                auto& opl = opls[i];
+                if (pl.mixin_index != opl.mixin_index || pl.payload != opl.payload || pl.data != opl.data) return false;
+            }
+            return true;
+        }
+    };
+    static_assert(sizeof(ftable_block) % alignof(type::ftable_entry) == 0, "fix ftable block");
+    static_assert(alignof(ftable_block) >= alignof(type::ftable_entry), "fix ftable block");
+
     struct deleter {
         void operator()(const type* ptr) {
+            auto& alloc = ptr->dom.m_impl->m_allocator;
+            auto block = ftable_block::of(*ptr);
+            if (block && block->ref_count == 0) ftable_block::free(alloc, block); // not shared
             const void* cvptr = ptr;
             auto vptr = const_cast<void*>(cvptr);
-            ptr->dom.m_impl->m_allocator.deallocate_bytes(vptr, ptr->buf_size, alignof(type));
+            alloc.deallocate_bytes(vptr, ptr->buf_size, alignof(type));
         }
     };
 
@@ -119,58 +513,545 @@ public:
     };
     using mutation_rule_map = itlib::flat_map<const mutation_rule_info*, uint32_t, rule_compare, compat::pmr::vector<std::pair<const mutation_rule_info*, uint32_t>>>;
 
-    struct type_compare {
-        bool operator()(const uptr<const type>& a, const uptr<const type>& b) const {
-            return mixin_span_less(a->mixins, b->mixins);
+    using type_query = compat::pmr::vector<const mixin_info*>;
+
+    // a clause of a declarative rule as compiled by the domain
+    // they are sorted by condition, then by the order of their rules, then by their order in the rule
+    struct compiled_clause {
+        const mixin_info* condition;
+        const mixin_info* target;
+        bool remove;
+        const mutation_rule_info* rule;
+        uint32_t index; // in rule
+    };
+
+    // set of mixins
+    // a bitset by id for the mixins registered in the domain and a list for the others (rare)
+    class mixin_set {
+        const domain& m_dom;
+        compat::pmr::vector<uint64_t> m_bits;
+        compat::pmr::vector<const mixin_info*> m_others;
+    public:
+        mixin_set(const domain& dom, allocator alloc) : m_dom(dom), m_bits(alloc), m_others(alloc) {}
+
+        bool contains(const mixin_info* m) const noexcept {
+            if (m->id == invalid_mixin_id || m->dom != &m_dom) return itlib::pfind(m_others, m);
+            const auto word = m->iid() / 64;
+            if (word >= m_bits.size()) return false;
+            return m_bits[word] & (uint64_t(1) << (m->iid() % 64));
         }
-        bool operator()(const uptr<const type>& a, mixin_info_span& b) const {
-            return mixin_span_less(a->mixins, b);
+
+        // return true if the mixin was inserted (not already in the set)
+        bool insert(const mixin_info* m) {
+            if (m->id == invalid_mixin_id || m->dom != &m_dom) {
+                if (itlib::pfind(m_others, m)) return false;
+                m_others.push_back(m);
+                return true;
+            }
+            const auto word = m->iid() / 64;
+            if (word >= m_bits.size()) m_bits.resize(word + 1, 0);
+            const auto bit = uint64_t(1) << (m->iid() % 64);
+            if (m_bits[word] & bit) return false;
+            m_bits[word] |= bit;
+            return true;
+        }
+
+        bool empty() const noexcept {
+            return m_others.empty() && std::all_of(m_bits.begin(), m_bits.end(), [](uint64_t w) { return w == 0; });
         }
-        bool operator()(mixin_info_span& a, const uptr<const type>& b) const {
-            return mixin_span_less(a, b->mixins);
+
+        void clear() noexcept {
+            std::fill(m_bits.begin(), m_bits.end(), 0);
+            m_others.clear();
         }
-        using is_transparent = void;
     };
-    using type_set = compat::pmr::set<uptr<const type>, type_compare>;
 
-    using type_query = compat::pmr::vector<const mixin_info*>;
-    struct type_query_compare {
-        bool operator()(const type_query& a, const type_query& b) const {
-            return mixin_span_less(a, b);
+    // open-addressing hash set of types (linear probing) which owns them
+    // the slots are types keyed by their cached mixins_hash
+    // it also indexes the types by mixin: a list per mixin id linked through type::m_mixin_links
+    class type_set {
+        compat::pmr::vector<const type*> m_slots; // power of two size (or empty)
+        size_t m_size = 0;
+        size_t m_bytes = 0; // sum of buf_size of types
+        compat::pmr::vector<const type*> m_first_by_mixin; // heads of the lists per mixin id
+    public:
+        explicit type_set(allocator alloc) : m_slots(alloc), m_first_by_mixin(alloc) {}
+        type_set(const type_set&) = delete;
+        type_set& operator=(const type_set&) = delete;
+        ~type_set() {
+            for (auto t : m_slots) {
+                if (t) deleter{}(t);
+            }
         }
-        bool operator()(const type_query& a, mixin_info_span& b) const {
-            return mixin_span_less(a, b);
+
+        size_t size() const noexcept { return m_size; }
+        size_t bytes() const noexcept { return m_bytes; }
+
+        template <typename F>
+        void for_each(F&& f) const {
+            for (auto t : m_slots) {
+                if (t) f(*t);
+            }
         }
-        bool operator()(mixin_info_span& a, const type_query& b) const {
-            return mixin_span_less(a, b);
+
+        // call f for at most budget types (all if zero) starting from the slot at cursor
+        // the cursor is updated to the slot after the last visited one
+        template <typename F>
+        void scan(size_t& cursor, uint32_t budget, F&& f) const {
+            if (m_size == 0) return;
+            const size_t mask = m_slots.size() - 1;
+            cursor &= mask;
+            uint32_t visited = 0;
+            for (size_t n = 0; n < m_slots.size(); ++n) {
+                auto t = m_slots[cursor];
+                cursor = (cursor + 1) & mask;
+                if (!t) continue;
+                f(*t);
+                if (++visited == budget) return;
+            }
+        }
+
+        // call f for each type which has the mixin
+        template <typename F>
+        void for_each_with(mixin_id id, F&& f) const {
+            if (id.i >= m_first_by_mixin.size()) return;
+            for (auto t = m_first_by_mixin[id.i]; t; ) {
+                auto next = t->m_mixin_links[t->index_of(id)].next; // f may erase t
+                f(*t);
+                t = next;
+            }
+        }
+
+        // check if the given type is in the set without touching it
+        // (it may have been freed if it's not)
+        bool contains(const type* t, size_t hash) const noexcept {
+            return find_slot(t, hash) != m_slots.size();
+        }
+
+        const type* find(mixin_info_span& mixins, size_t hash) const noexcept {
+            if (m_slots.empty()) return nullptr;
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+                auto t = m_slots[i];
+                if (!t) return nullptr;
+                if (t->mixins_hash == hash && mixin_span_equal(t->mixins, mixins)) return t;
+            }
+        }
+
+        // returns the type in the set
+        // if an equivalent type exists, the new one is dropped and the existing one is returned
+        const type* insert(uptr<const type> t) {
+            if (auto existing = find(t->mixins, t->mixins_hash)) return existing;
+            if ((m_size + 1) * 2 > m_slots.size()) rehash(hash_table_capacity_for(m_size + 1));
+            mixin_id::int_t max_id = 0;
+            for (auto m : t->mixins) max_id = std::max(max_id, m->iid());
+            if (max_id >= m_first_by_mixin.size()) m_first_by_mixin.resize(max_id + 1, nullptr);
+
+            auto ret = t.release();
+            place(ret);
+            ++m_size;
+            m_bytes += ret->buf_size;
+
+            for (mixin_index_t i = 0; i < ret->num_mixins(); ++i) {
+                const auto id = ret->mixins[i]->id;
+                auto& first = m_first_by_mixin[id.i];
+                ret->m_mixin_links[i] = {nullptr, first};
+                if (first) first->m_mixin_links[first->index_of(id)].prev = ret;
+                first = ret;
+            }
+            return ret;
+        }
+
+        // erase a type without freeing it
+        // the other types are shifted back to fill the hole in their probe sequence
+        void erase(const type* t) noexcept {
+            const size_t mask = m_slots.size() - 1;
+            size_t hole = find_slot(t, t->mixins_hash);
+            assert(hole != m_slots.size());
+            m_slots[hole] = nullptr;
+            --m_size;
+            m_bytes -= t->buf_size;
+
+            for (mixin_index_t i = 0; i < t->num_mixins(); ++i) {
+                const auto id = t->mixins[i]->id;
+                auto& link = t->m_mixin_links[i];
+                if (link.prev) link.prev->m_mixin_links[link.prev->index_of(id)].next = link.next;
+                else m_first_by_mixin[id.i] = link.next;
+                if (link.next) link.next->m_mixin_links[link.next->index_of(id)].prev = link.prev;
+            }
+
+            for (size_t i = (hole + 1) & mask; m_slots[i]; i = (i + 1) & mask) {
+                // an entry can be moved to the hole if its home slot is not in (hole, i]
+                const size_t home = m_slots[i]->mixins_hash & mask;
+                const bool stays = hole < i ? (hole < home && home <= i) : (hole < home || home <= i);
+                if (stays) continue;
+                m_slots[hole] = m_slots[i];
+                m_slots[i] = nullptr;
+                hole = i;
+            }
+        }
+
+    private:
+        // slot of the given type or m_slots.size() if it's not in the set
+        size_t find_slot(const type* t, size_t hash) const noexcept {
+            if (m_slots.empty()) return 0;
+            const size_t mask = m_slots.size() - 1;
+            for (size_t i = hash & mask; m_slots[i]; i = (i + 1) & mask) {
+                if (m_slots[i] == t) return i;
+            }
+            return m_slots.size();
+        }
+
+        void place(const type* t) noexcept {
+            const size_t mask = m_slots.size() - 1;
+            size_t i = t->mixins_hash & mask;
+            while (m_slots[i]) i = (i + 1) & mask;
+            m_slots[i] = t;
+        }
+
+        void rehash(uint32_t capacity) {
+            compat::pmr::vector<const type*> old(capacity, nullptr, m_slots.get_allocator());
+            old.swap(m_slots);
+            for (auto t : old) {
+                if (t) place(t);
+            }
+        }
+    };
+
+    // open-addressing hash set of interned ftable blocks (linear probing) keyed by their content hash
+    // the blocks are reference counted by the types which use them
+    // it owns the blocks, so it must outlive the type set (types don't free interned blocks)
+    class ftable_set {
+        compat::pmr::vector<ftable_block*> m_slots; // power of two size (or empty)
+        size_t m_size = 0;
+        size_t m_bytes = 0; // sum of buf_size of blocks
+        allocator m_alloc;
+    public:
+        explicit ftable_set(allocator alloc) : m_slots(alloc), m_alloc(alloc) {}
+        ftable_set(const ftable_set&) = delete;
+        ftable_set& operator=(const ftable_set&) = delete;
+        ~ftable_set() {
+            for (auto b : m_slots) {
+                if (b) ftable_block::free(m_alloc, b);
+            }
+        }
+
+        size_t size() const noexcept { return m_size; }
+        size_t bytes() const noexcept { return m_bytes; }
+
+        // make the type use the interned block with the same content as its own
+        // if there is no such block, the type's own block is interned
+        // the type must not be visible to other threads
+        void intern(type& t) {
+            auto block = ftable_block::of(t);
+            if (!block) return;
+            assert(block->ref_count == 0);
+
+            if (!m_slots.empty()) {
+                const size_t mask = m_slots.size() - 1;
+                for (size_t i = block->content_hash & mask; m_slots[i]; i = (i + 1) & mask) {
+                    auto b = m_slots[i];
+                    if (!b->content_equal(*block)) continue;
+                    ++b->ref_count;
+                    t.ftable = b->entries();
+                    t.ftable_hash = b->ftable_hash;
+                    ftable_block::free(m_alloc, block);
+                    return;
+                }
+            }
+
+            if ((m_size + 1) * 2 > m_slots.size()) rehash(hash_table_capacity_for(m_size + 1));
+            block->ref_count = 1;
+            place(block);
+            ++m_size;
+            m_bytes += block->buf_size;
+        }
+
+        // release the block of a type which is being removed
+        // if no other type uses the block, it's no longer interned and the type's deleter frees it
+        void release(const type& t) noexcept {
+            auto block = ftable_block::of(t);
+            if (!block) return;
+            assert(block->ref_count != 0);
+            if (--block->ref_count) return;
+
+            const size_t mask = m_slots.size() - 1;
+            size_t hole = block->content_hash & mask;
+            while (m_slots[hole] != block) hole = (hole + 1) & mask;
+            m_slots[hole] = nullptr;
+            --m_size;
+            m_bytes -= block->buf_size;
+
+            // shift back the next entries in the probe sequence (see type_set::erase)
+            for (size_t i = (hole + 1) & mask; m_slots[i]; i = (i + 1) & mask) {
+                const size_t home = m_slots[i]->content_hash & mask;
+                const bool stays = hole < i ? (hole < home && home <= i) : (hole < home || home <= i);
+                if (stays) continue;
+                m_slots[hole] = m_slots[i];
+                m_slots[i] = nullptr;
+                hole = i;
+            }
+        }
+
+    private:
+        void place(ftable_block* block) noexcept {
+            const size_t mask = m_slots.size() - 1;
+            size_t i = block->content_hash & mask;
+            while (m_slots[i]) i = (i + 1) & mask;
+            m_slots[i] = block;
+        }
+
+        void rehash(uint32_t capacity) {
+            compat::pmr::vector<ftable_block*> old(capacity, nullptr, m_slots.get_allocator());
+            old.swap(m_slots);
+            for (auto b : old) {
+                if (b) place(b);
+            }
         }
-        using is_transparent = void;
     };
-    using type_query_map = compat::pmr::map<type_query, const type*, type_query_compare>;
+
+    struct type_query_node;
 
     // registry of types and helpers
     // it independently locked from the element registry
     struct type_registry {
         type_registry(allocator alloc)
             : mutation_rules({}, alloc)
+            , rule_clauses(alloc)
+            , ftables(alloc)
             , types(alloc)
-            , type_queries(alloc)
+            , queries_without_mixin(alloc)
         {}
 
         // sorted rules with their refcounts
         mutation_rule_map mutation_rules;
 
+        // clauses of the declarative rules (see compiled_clause)
+        compat::pmr::vector<compiled_clause> rule_clauses;
+        uint32_t num_apply_rules = 0; // rules with an apply function
+
+        // ftables of the existing types (declared before them, as it owns the shared ftables)
+        ftable_set ftables;
+
         // existing types
         type_set types;
 
-        // stored type queries
-        // with them we avoid applying mutation rules for the same type query
-        type_query_map type_queries;
+        // memory occupied by the existing types along with their ftables
+        size_t types_bytes() const noexcept { return types.bytes() + ftables.bytes(); }
+
+        // stored queries by mixin id, which have the mixin, but lead to a type which doesn't
+        // (with mutation rules which remove mixins)
+        // the ones which lead to types with the mixin are found through types.for_each_with
+        // this way we find all queries which reference a mixin when it gets unregistered
+        compat::pmr::vector<compat::pmr::vector<const type_query_node*>> queries_without_mixin;
+
+        // stored type queries are not here, but in m_type_queries below
+        // they can be read without locking, but they must only be modified while holding this unique lock
+    };
+    type_registry m_type_registry;
+    mutable timed_shared_mutex m_type_registry_mutex; // only access the registry through lock_types_*
+
+    // stored type query: the query and the type it leads to
+    // it is allocated as a single buffer: the node, followed by the mixins of the query
+    // the nodes which lead to a type form a list starting from type::m_queries (a reverse index)
+    // so that the queries of collected types can be erased without going through all of them
+    struct type_query_node {
+        size_t hash;
+        const type* t;
+        itlib::span<const mixin_info* const> query;
+        mutable const type_query_node* next_for_type; // only touched by writers
+    };
+
+    // open-addressing hash table of stored type queries (linear probing)
+    // it is allocated as a single buffer: the table, followed by its slots
+    // readers search in it without locking the type registry
+    // writers (who hold the unique lock of the type registry) fill empty slots in place
+    // queries of collected types are erased in place by replacing them with a tombstone
+    // erasing other queries or growing the table publishes a new table instead (dropping the tombstones)
+    // nodes and tables which are no longer reachable are freed when no reader can observe them
+    struct type_query_table {
+        uint32_t capacity; // power of two
+        uint32_t size; // only touched by writers
+        uint32_t tombstones; // only touched by writers
+        itlib::span<std::atomic<const type_query_node*>> slots;
+
+        static inline const type_query_node tombstone = {};
+
+        template <typename F>
+        void for_each(F&& f) const {
+            for (auto& slot : slots) {
+                auto node = slot.load(std::memory_order_relaxed);
+                if (node && node != &tombstone) f(*node);
+            }
+        }
     };
-    data_mutex<type_registry> m_type_registry;
+
+    // stored type queries
+    // with them we avoid applying mutation rules for the same type query
+    std::atomic<type_query_table*> m_type_queries = {};
+    bits::epoch m_type_queries_epoch;
+
+    // generation of type edges
+    // it's incremented when edges may become invalid, which invalidates all cached edges
+    std::atomic<uint32_t> m_edge_generation = 1; // types are initialized with edges of generation 0
 
     type m_empty_type;
 
+    // single-flight type creation
+    // a thread which builds a new type registers the build here, so that other threads which need
+    // the same type wait for it instead of building it as well
+    // the mutex is a leaf: no other lock is taken while holding it
+    struct type_build {
+        itlib::span<const mixin_info* const> mixins; // of the builder's mutation
+        size_t hash;
+        const type* result = nullptr; // null if the build failed
+        bool done = false;
+        uint32_t waiters = 0;
+    };
+    std::mutex m_builds_mutex;
+    std::condition_variable m_builds_cv;
+    compat::pmr::vector<type_build*> m_builds; // in flight
+
+    // instrumentation (see domain_stats.hpp)
+    // the counters are relaxed: they don't order anything and are only read for diagnostics
+    // they are sharded per thread (in cache-line-sized shards, as the epoch slots), so that the readers
+    // which count hits on the lock-free paths don't contend with each other
+    // get_stats sums the shards
+    static constexpr uint32_t num_stats_shards = 16;
+    struct alignas(64) stats_counters {
+        using counter = std::atomic<uint64_t>;
+        counter type_query_hits = {};
+        counter type_query_misses = {};
+        counter rule_applications = {};
+        counter rule_passes = {};
+        counter types_created = {};
+        counter types_discarded = {};
+        counter type_builds_avoided = {};
+        counter gc_runs = {};
+        counter types_collected = {};
+        counter shared_locks = {};
+        counter unique_locks = {};
+        counter type_bytes_allocated = {};
+    };
+    stats_counters m_stats[num_stats_shards];
+    using stats_counter = std::atomic<uint64_t> stats_counters::*;
+
+    void count(stats_counter c, uint64_t n = 1) noexcept {
+        auto& shard = m_stats[bits::this_thread_slot() % num_stats_shards];
+        (shard.*c).fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t get_count(stats_counter c) const noexcept {
+        uint64_t ret = 0;
+        for (auto& shard : m_stats) ret += (shard.*c).load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    domain_stats get_stats() const noexcept {
+        domain_stats ret = {};
+        ret.type_query_hits = get_count(&stats_counters::type_query_hits);
+        ret.type_query_misses = get_count(&stats_counters::type_query_misses);
+        ret.rule_applications = get_count(&stats_counters::rule_applications);
+        ret.rule_passes = get_count(&stats_counters::rule_passes);
+        ret.types_created = get_count(&stats_counters::types_created);
+        ret.types_discarded = get_count(&stats_counters::types_discarded);
+        ret.type_builds_avoided = get_count(&stats_counters::type_builds_avoided);
+        ret.gc_runs = get_count(&stats_counters::gc_runs);
+        ret.types_collected = get_count(&stats_counters::types_collected);
+        ret.shared_locks = get_count(&stats_counters::shared_locks);
+        ret.shared_lock_wait_ns = m_type_registry_mutex.shared_wait_ns.load(std::memory_order_relaxed);
+        ret.unique_locks = get_count(&stats_counters::unique_locks);
+        ret.unique_lock_wait_ns = m_type_registry_mutex.unique_wait_ns.load(std::memory_order_relaxed);
+        ret.type_bytes_allocated = get_count(&stats_counters::type_bytes_allocated);
+        return ret;
+    }
+
+    // event listener
+    // it's loaded without locking, and the epoch makes sure that a replaced listener isn't called after
+    // set_listener returns
+    std::atomic<const domain_listener*> m_listener = {};
+    bits::epoch m_listener_epoch;
+    std::mutex m_listener_mutex; // serializes set_listener
+
+    void set_listener(const domain_listener* listener) noexcept {
+        std::lock_guard lock(m_listener_mutex);
+        m_listener.store(listener, std::memory_order_release);
+        m_listener_epoch.synchronize();
+    }
+
+    static uint64_t now_ns() noexcept {
+        auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+    }
+
+    // an event which is timed from its construction to its destruction, when it's sent to the listener
+    // when there's no listener, nothing is done
+    // the mixins of the event can be provided as a vector which is read when the event is sent
+    struct event_scope {
+        impl& self;
+        domain_event e = {};
+        const compat::pmr::vector<const mixin_info*>* mixins_vec = nullptr;
+
+        event_scope(impl& s, domain_event_type type) noexcept : self(s) {
+            if (!self.m_listener.load(std::memory_order_relaxed)) return;
+            e.type = type;
+            e.dom = self.m_domain.to_c_hanlde();
+            e.start_ns = now_ns();
+        }
+        event_scope(const event_scope&) = delete;
+        event_scope& operator=(const event_scope&) = delete;
+
+        explicit operator bool() const noexcept { return e.start_ns; }
+
+        void set_mixins(itlib::span<const mixin_info* const> mixins) noexcept {
+            e.mixins = mixins.data();
+            e.num_mixins = uint32_t(mixins.size());
+        }
+
+        ~event_scope() {
+            if (!e.start_ns) return;
+            e.duration_ns = now_ns() - e.start_ns;
+            if (mixins_vec) set_mixins(*mixins_vec);
+
+            auto g = self.m_listener_epoch.enter();
+            auto l = self.m_listener.load(std::memory_order_acquire);
+            if (l) l->on_event(&e, l->user_data);
+        }
+    };
+
+    // locks of the type registry which are counted in the stats
+    using type_registry_shared_lock = registry_lock<const type_registry, std::shared_lock<timed_shared_mutex>>;
+    using type_registry_unique_lock = registry_lock<type_registry, std::unique_lock<timed_shared_mutex>>;
+    type_registry_shared_lock lock_types_shared() {
+        count(&stats_counters::shared_locks);
+        return {m_type_registry, std::shared_lock(m_type_registry_mutex)};
+    }
+    type_registry_unique_lock lock_types_unique() {
+        count(&stats_counters::unique_locks);
+        return {m_type_registry, std::unique_lock(m_type_registry_mutex)};
+    }
+
+    // adds a built type to the registry
+    // if an equivalent type was added in the meantime, the built one is dropped and the existing one is returned
+    const type* insert_type_l(type_registry& reg, uptr<type> t) {
+        if (auto existing = reg.types.find(t->mixins, t->mixins_hash)) {
+            count(&stats_counters::types_discarded);
+            return existing;
+        }
+        reg.ftables.intern(*t);
+        count(&stats_counters::types_created);
+        return reg.types.insert(std::move(t));
+    }
+
+    // garbage collection
+    type_gc_policy m_gc_policy; // protected by the type registry lock
+    std::atomic<bool> m_gc_on_zero_objects = false; // the policy flag, checked without locking
+    size_t m_gc_cursor = 0; // slot of the type set from which the next step starts
+    int64_t m_gc_last_step = gc_now();
+    // types (with their hashes) which became unused before min_unused_time of the policy
+    // they are checked again when other types become unused
+    compat::pmr::vector<std::pair<const type*, size_t>> m_gc_pending;
+
     const mutation_rule_info m_canonicalize_rule = {
         dnmx_make_sv_lit("canonicalize types"),
         sort_by_canonical_order,
@@ -181,69 +1062,404 @@ public:
     impl(domain& domain, allocator alloc)
         : m_domain(domain)
         , m_allocator(std::move(alloc))
+        , m_sparse_features(m_allocator)
+        , m_sparse_mixins(m_allocator)
+        , m_sparse_type_classes(m_allocator)
+        , m_sparse_type_class_masks(m_allocator)
         , m_element_registry(m_allocator)
         , m_type_registry(m_allocator)
         , m_empty_type(domain, 0)
+        , m_builds(m_allocator)
+        , m_gc_pending(m_allocator)
     {
+        m_empty_type.serial = next_type_serial();
+
         if (m_domain.m_settings.canonicalize_types) {
             // we solve this requirement by adding a mutation rule which sorts the mixins of the new type
             add_mutation_rule(m_canonicalize_rule);
         }
     }
 
-    template <typename T>
-    void basic_register_l(T& info, compat::pmr::vector<const T*>& sparse, bool enforce_unique_names) {
-        using id_t = decltype(info.id);
-        constexpr id_t invalid = id_t{dnmx_invalid_id};
-        if (info.id != invalid) throw_exception::id_registered(m_domain, info);
-        if (enforce_unique_names && info.name.empty()) throw_exception::empty_name(m_domain, info);
-
-        id_t free_id = invalid;
-
-        if (enforce_unique_names) {
-            // search in reverse order while also checking for name clashes
-            // after this loop, the least free_id will be saved
-            for (dnmx_id_int_t i = dnmx_id_int_t(sparse.size()); i-- > 0; ) {
-                auto reg = sparse[i];
-                if (reg) {
-                    assert(reg->iid() == i); // sanity check
-                    if (reg->name == info.name) throw_exception::duplicate_name(m_domain, info);
-                }
-                else {
-                    free_id = id_t{i};
-                }
-            }
+    ~impl() {
+        // no readers can exist at this point
+        auto reg = lock_types_unique();
+        clear_queries_l(*reg);
+
+        auto& masks = m_sparse_type_class_masks;
+        for (uint32_t i = 0; i < masks.size(); ++i) {
+            free_type_class_masks(masks[i]);
         }
-        else {
-            // simply find first free id
-            for (dnmx_id_int_t i = 0; i < sparse.size(); ++i) {
-                if (!sparse[i]) {
-                    free_id = id_t{i};
-                    break;
-                }
+
+        // type classes which are still registered can be registered in other domains
+        auto& classes = m_sparse_type_classes;
+        for (uint32_t i = 0; i < classes.size(); ++i) {
+            if (auto tc = classes[i]) {
+                // they were registered through non-const references
+                const_cast<type_class*>(tc)->dom = nullptr;
             }
         }
+    }
+
+    type_query_table* make_query_table(uint32_t capacity) {
+        static_assert(std::is_trivially_destructible_v<type_query_table>);
+        static_assert(std::is_trivially_destructible_v<std::atomic<const type_query_node*>>);
+        static_assert(alignof(type_query_table) >= alignof(std::atomic<const type_query_node*>), "fix query table buffer");
+
+        const byte_size_t buf_size = byte_size_t(sizeof(type_query_table) + capacity * sizeof(std::atomic<const type_query_node*>));
+        auto bytes = reinterpret_cast<byte_t*>(m_allocator.allocate_bytes(buf_size, alignof(type_query_table)));
+        auto slots = reinterpret_cast<std::atomic<const type_query_node*>*>(bytes + sizeof(type_query_table));
+        for (uint32_t i = 0; i < capacity; ++i) {
+            new (slots + i) std::atomic<const type_query_node*>(nullptr);
+        }
+        return new (bytes) type_query_table{capacity, 0, 0, {slots, capacity}};
+    }
+
+    void free_query_table(const type_query_table* table) noexcept {
+        if (!table) return;
+        const byte_size_t buf_size = byte_size_t(sizeof(type_query_table) + table->capacity * sizeof(std::atomic<const type_query_node*>));
+        const void* cvptr = table;
+        m_allocator.deallocate_bytes(const_cast<void*>(cvptr), buf_size, alignof(type_query_table));
+    }
+
+    const type_query_node* make_query_node(mixin_info_span& query, size_t hash, const type* t) {
+        static_assert(std::is_trivially_destructible_v<type_query_node>);
+        static_assert(alignof(type_query_node) >= alignof(const mixin_info*), "fix query node buffer");
+
+        auto bytes = reinterpret_cast<byte_t*>(m_allocator.allocate_bytes(
+            sizeof(type_query_node) + query.size_bytes(),
+            alignof(type_query_node)
+        ));
+        auto mixins = reinterpret_cast<const mixin_info**>(bytes + sizeof(type_query_node));
+        std::copy(query.begin(), query.end(), mixins);
+        return new (bytes) type_query_node{hash, t, {mixins, query.size()}, nullptr};
+    }
+
+    void free_query_node(const type_query_node* node) noexcept {
+        const void* cvptr = node;
+        m_allocator.deallocate_bytes(const_cast<void*>(cvptr), sizeof(type_query_node) + node->query.size_bytes(), alignof(type_query_node));
+    }
+
+    // find the slot of a query or the empty slot where it should be
+    static std::atomic<const type_query_node*>& find_query_slot(const type_query_table& table, mixin_info_span& query, size_t hash) noexcept {
+        const uint32_t mask = table.capacity - 1;
+        for (uint32_t i = uint32_t(hash) & mask; ; i = (i + 1) & mask) {
+            // the load factor is at most 1/2, so there is always an empty slot
+            auto& slot = table.slots[i];
+            auto node = slot.load(std::memory_order_acquire);
+            if (!node) return slot;
+            if (node == &type_query_table::tombstone) continue;
+            if (node->hash == hash && mixin_span_equal(node->query, query)) return slot;
+        }
+    }
+
+    const type* find_query_lock_free(mixin_info_span& query, size_t hash) noexcept {
+        auto guard = m_type_queries_epoch.enter();
+        auto table = m_type_queries.load(std::memory_order_acquire);
+        if (!table) return nullptr;
+        auto node = find_query_slot(*table, query, hash).load(std::memory_order_acquire);
+        if (!node) return nullptr;
+        // pinned while in the critical section, so that a collection which has chosen the type
+        // can see it after it synchronizes (see collect_l)
+        hand_out(*node->t);
+        return node->t;
+    }
+
+    // types which are returned by get_type are pinned until an object is created with them (see type::m_hand_outs)
+    void hand_out(const type& t) noexcept {
+        if (&t == &m_empty_type) return; // never collected
+        t.m_hand_outs.fetch_add(type::hand_out_count + type::hand_out_pin, std::memory_order_relaxed);
+    }
+
+    // a reference to a type which keeps it from being collected (see type::m_refs)
+    // it must be acquired while holding a lock of the type registry
+    struct type_ref {
+        const type* t = nullptr;
+        type_ref() noexcept = default;
+        explicit type_ref(const type* rt) noexcept : t(rt) {
+            if (t) t->m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        type_ref(const type_ref&) = delete;
+        type_ref& operator=(type_ref&& other) noexcept {
+            std::swap(t, other.t);
+            return *this;
+        }
+        ~type_ref() {
+            // release, so that our reads of the type happen before a collection which sees the ref gone frees it
+            if (t) t->m_refs.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    // the following functions must be called while holding the unique lock of the type registry
+
+    static const type_query_node* first_query(const type& t) noexcept {
+        return static_cast<const type_query_node*>(t.m_queries);
+    }
+
+    static void link_query_l(const type_query_node& node) noexcept {
+        node.next_for_type = first_query(*node.t);
+        node.t->m_queries = &node;
+    }
+
+    static void unlink_query_l(const type_query_node& node) noexcept {
+        auto& t = *node.t;
+        if (t.m_queries == &node) {
+            t.m_queries = node.next_for_type;
+            return;
+        }
+        auto prev = first_query(t);
+        while (prev->next_for_type != &node) {
+            prev = prev->next_for_type;
+            assert(prev);
+        }
+        prev->next_for_type = node.next_for_type;
+    }
+
+    // publish a new query table and free the old one when no reader can see it
+    // as well as all nodes for which the predicate returns true
+    template <typename Pred>
+    void publish_query_table_l(type_query_table* table, Pred&& free_node) {
+        auto old = m_type_queries.exchange(table);
+        if (!old) return;
+
+        // wait for readers of the old table to leave
+        m_type_queries_epoch.synchronize();
+
+        old->for_each([&](const type_query_node& node) {
+            if (free_node(node)) free_query_node(&node);
+        });
+        free_query_table(old);
+    }
+
+    // rebuild the stored queries in a new table erasing those for which pred returns true
+    template <typename Pred>
+    void rebuild_queries_l(uint32_t capacity, Pred&& erase) {
+        auto old = m_type_queries.load(std::memory_order_relaxed);
+        if (!old) return;
+
+        auto table = make_query_table(capacity);
+        old->for_each([&](const type_query_node& node) {
+            if (erase(node)) return;
+            find_query_slot(*table, node.query, node.hash).store(&node, std::memory_order_relaxed);
+            ++table->size;
+        });
+
+        // the nodes which are not in the new table are the erased ones
+        publish_query_table_l(table, erase);
+    }
+
+    void clear_queries_l(type_registry& reg) noexcept {
+        if (auto table = m_type_queries.load(std::memory_order_relaxed)) {
+            table->for_each([](const type_query_node& node) {
+                node.t->m_queries = nullptr;
+            });
+        }
+        for (auto& q : reg.queries_without_mixin) {
+            q.clear();
+        }
+        publish_query_table_l(nullptr, [](const type_query_node&) { return true; });
+    }
+
+    // add a query to queries_without_mixin for each of its mixins which the type it leads to lacks
+    void index_query_l(type_registry& reg, const type_query_node& node) {
+        auto& index = reg.queries_without_mixin;
+        for (auto m : node.query) {
+            if (node.t->has(m->id)) continue;
+            if (m->iid() >= index.size()) index.resize(m->iid() + 1, compat::pmr::vector<const type_query_node*>(m_allocator));
+            index[m->iid()].push_back(&node);
+        }
+    }
+
+    static void unindex_query_l(type_registry& reg, const type_query_node& node) noexcept {
+        for (auto m : node.query) {
+            if (node.t->has(m->id)) continue;
+            auto& q = reg.queries_without_mixin[m->iid()];
+            auto f = itlib::qfind(q, &node);
+            assert(f != q.end());
+            *f = q.back();
+            q.pop_back();
+        }
+    }
+
+    // replace a stored query with a tombstone
+    // the node is not freed (nor unlinked from the reverse index)
+    static void tombstone_query_l(type_query_table& table, const type_query_node& node) noexcept {
+        auto& slot = find_query_slot(table, node.query, node.hash);
+        assert(slot.load(std::memory_order_relaxed) == &node);
+        slot.store(&type_query_table::tombstone, std::memory_order_release);
+        --table.size;
+        ++table.tombstones;
+    }
+
+    void store_query_l(type_registry& reg, mixin_info_span& query, size_t hash, const type* t) {
+        auto table = m_type_queries.load(std::memory_order_relaxed);
+        if (!table) {
+            table = make_query_table(hash_table_capacity_for(1));
+            publish_query_table_l(table, [](const type_query_node&) { return false; });
+        }
+
+        auto* slot = &find_query_slot(*table, query, hash);
+        if (auto node = slot->load(std::memory_order_relaxed)) {
+            // another thread has stored the same query
+            if (node->t == t) return;
+
+            // ... but it leads to a different type (restored queries may do this)
+            auto new_node = make_query_node(query, hash, t);
+            slot->store(new_node, std::memory_order_release);
+            unlink_query_l(*node);
+            unindex_query_l(reg, *node);
+            link_query_l(*new_node);
+            index_query_l(reg, *new_node);
+            m_type_queries_epoch.synchronize();
+            free_query_node(node);
+            return;
+        }
+
+        if ((table->size + table->tombstones + 1) * 2 > table->capacity) {
+            // grow or drop the tombstones (the nodes are preserved)
+            rebuild_queries_l(hash_table_capacity_for(table->size + 1), [](const type_query_node&) { return false; });
+            table = m_type_queries.load(std::memory_order_relaxed);
+            slot = &find_query_slot(*table, query, hash);
+        }
+
+        auto new_node = make_query_node(query, hash, t);
+        slot->store(new_node, std::memory_order_release);
+        ++table->size;
+        link_query_l(*new_node);
+        index_query_l(reg, *new_node);
+    }
+
+    void invalidate_edges_l() noexcept {
+        m_edge_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    size_t num_type_queries_l() const noexcept {
+        auto table = m_type_queries.load(std::memory_order_relaxed);
+        return table ? table->size : 0;
+    }
+
+    // reserve space for n more elements, preserving the amortized growth of push_back
+    template <typename Vec>
+    static void reserve_more(Vec& vec, size_t n) {
+        const auto size = vec.size() + n;
+        if (size <= vec.capacity()) return;
+        vec.reserve(std::max(size, vec.capacity() * 2));
+    }
+
+    // registering infos is done in three steps, so that many can be registered atomically
+    // validate: check that the infos can be registered (throws if they can't)
+    // reserve: allocate everything which the commit needs (can only throw bad_alloc)
+    // commit: register without failing
+
+    template <typename T>
+    void validate_register_l(itlib::span<T* const> infos, const name_index<T>& by_name, bool enforce_unique_names) {
+        name_index<T> batch_by_name(m_allocator); // names in infos
+        for (auto info : infos) {
+            if (info->id != decltype(info->id){dnmx_invalid_id}) throw_exception::id_registered(m_domain, *info);
+            if (!enforce_unique_names) continue;
+            if (info->name.empty()) throw_exception::empty_name(m_domain, *info);
+
+            const auto name = info->name.to_std();
+            const auto hash = name_hash(name);
+            if (by_name.find(name, hash) || batch_by_name.find(name, hash)) throw_exception::duplicate_name(m_domain, *info);
+            if (infos.size() > 1) batch_by_name.insert(*info, hash);
+        }
+
+        if (!enforce_unique_names && infos.size() > 1) {
+            // no names to tell us that the same info is in infos twice
+            compat::pmr::vector<const T*> sorted(infos.begin(), infos.end(), m_allocator);
+            std::sort(sorted.begin(), sorted.end());
+            auto dup = std::adjacent_find(sorted.begin(), sorted.end());
+            if (dup != sorted.end()) throw_exception::repeated_info(m_domain, **dup);
+        }
+    }
+
+    template <typename T>
+    static void reserve_register_l(size_t num_infos, sparse_array<T>& sparse, name_index<T>& by_name, const compat::pmr::vector<dnmx_id_int_t>& free_ids) {
+        by_name.reserve(by_name.size() + num_infos);
+        if (num_infos > free_ids.size()) sparse.reserve(sparse.size() + num_infos - free_ids.size());
+    }
 
-        if (free_id == invalid) {
-            free_id = id_t{dnmx_id_int_t(sparse.size())};
-            sparse.push_back(nullptr);
+    template <typename T>
+    static void commit_register_l(T& info, sparse_array<T>& sparse, name_index<T>& by_name, compat::pmr::vector<dnmx_id_int_t>& free_ids) noexcept {
+        // the free ids are a min-heap, so the lowest free id is reused first
+        dnmx_id_int_t id;
+        if (free_ids.empty()) {
+            id = dnmx_id_int_t(sparse.size());
+        }
+        else {
+            std::pop_heap(free_ids.begin(), free_ids.end(), std::greater<dnmx_id_int_t>{});
+            id = free_ids.back();
+            free_ids.pop_back();
         }
 
-        info.id = free_id;
-        sparse[info.iid()] = &info;
+        // with duplicate names, the one with the lowest id is indexed
+        const auto hash = name_hash(info.name.to_std());
+        auto indexed = by_name.find(info.name.to_std(), hash);
+        if (!indexed) by_name.insert(info, hash);
+        else if (id < indexed->iid()) by_name.replace(info, hash);
+
+        info.id = decltype(info.id){id};
+        if (id == sparse.size()) sparse.push_back(&info);
+        else sparse.set(id, &info);
+    }
+
+    // the lock must be held by the caller as a reservation for the id is needed when unregistering
+    static void release_id_l(compat::pmr::vector<dnmx_id_int_t>& free_ids, dnmx_id_int_t id) noexcept {
+        assert(free_ids.capacity() > free_ids.size());
+        free_ids.push_back(id);
+        std::push_heap(free_ids.begin(), free_ids.end(), std::greater<dnmx_id_int_t>{});
+    }
+
+    template <typename T>
+    void basic_register_l(T& info, sparse_array<T>& sparse, name_index<T>& by_name, compat::pmr::vector<dnmx_id_int_t>& free_ids, bool enforce_unique_names) {
+        T* infos[] = {&info};
+        validate_register_l<T>(infos, by_name, enforce_unique_names);
+        reserve_register_l(1, sparse, by_name, free_ids);
+        commit_register_l(info, sparse, by_name, free_ids);
+    }
+
+    // remove an info from a name index
+    // if there are other infos with the same name, the one with the lowest id takes its place
+    template <typename T>
+    static void unindex_name_l(const T& info, const sparse_array<T>& sparse, name_index<T>& by_name, bool may_have_duplicates) noexcept {
+        const auto hash = name_hash(info.name.to_std());
+        if (by_name.find(info.name.to_std(), hash) != &info) return; // a duplicate which wasn't indexed
+        if (may_have_duplicates) {
+            for (uint32_t i = 0; i < sparse.size(); ++i) {
+                auto other = sparse[i];
+                if (other && other != &info && other->name == info.name) {
+                    by_name.replace(*other, hash);
+                    return;
+                }
+            }
+        }
+        by_name.erase(info, hash);
     }
 
     template <typename T>
-    void basic_unregister_l(T& info, compat::pmr::vector<const T*>& sparse) {
+    void basic_unregister_l(T& info, sparse_array<T>& sparse, name_index<T>& by_name, compat::pmr::vector<dnmx_id_int_t>& free_ids, bool may_have_duplicates) {
         // info is not our own?
         if (info.iid() >= sparse.size() || sparse[info.iid()] != &info) throw_exception::unreg_foreign(m_domain, info);
 
-        sparse[info.iid()] = nullptr; // free slot
+        reserve_more(free_ids, 1);
+        unindex_name_l(info, sparse, by_name, may_have_duplicates);
+        sparse.set(info.iid(), nullptr); // free slot
+        release_id_l(free_ids, info.iid());
         info.id = decltype(info.id){dnmx_invalid_id}; // invalidate info
     }
 
     void register_feature(feature_info& info) {
-        basic_register_l(info, m_element_registry.unique_lock()->sparse_features, !m_domain.m_settings.allow_duplicate_feature_names);
+        auto reg = m_element_registry.unique_lock();
+        basic_register_l(info, m_sparse_features, reg->features_by_name, reg->free_feature_ids, !m_domain.m_settings.allow_duplicate_feature_names);
+    }
+
+    void register_features(itlib::span<feature_info* const> infos) {
+        auto reg = m_element_registry.unique_lock();
+        validate_register_l(infos, reg->features_by_name, !m_domain.m_settings.allow_duplicate_feature_names);
+        reserve_register_l(infos.size(), m_sparse_features, reg->features_by_name, reg->free_feature_ids);
+        for (auto info : infos) {
+            commit_register_l(*info, m_sparse_features, reg->features_by_name, reg->free_feature_ids);
+        }
     }
 
     // to be pedantic when we clear features we should clear all object types which
@@ -258,7 +1474,8 @@ public:
     // if something breaks because of this inconsitency, then this would have been a
     // break anyway - the mixins referencing this feature would keep on living??
     void unregister_feature(feature_info& info) {
-        basic_unregister_l(info, m_element_registry.unique_lock()->sparse_features);
+        auto reg = m_element_registry.unique_lock();
+        basic_unregister_l(info, m_sparse_features, reg->features_by_name, reg->free_feature_ids, m_domain.m_settings.allow_duplicate_feature_names);
     }
 
     void register_mixin(mixin_info& info) {
@@ -269,155 +1486,354 @@ public:
         for (auto& f : info.features_span()) {
             if (f.info->id != invalid_feature_id) {
                 // already registered
-                assert(reg->sparse_features[f.info->iid()] == f.info); // sanity
+                assert(m_sparse_features[f.info->iid()] == f.info); // sanity
                 continue;
             }
             // we need to const_cast. this is the price of lazy ops in C++
-            basic_register_l(*const_cast<feature_info*>(f.info), reg->sparse_features, !m_domain.m_settings.allow_duplicate_feature_names);
+            basic_register_l(*const_cast<feature_info*>(f.info), m_sparse_features, reg->features_by_name, reg->free_feature_ids, !m_domain.m_settings.allow_duplicate_feature_names);
 
             // note that if the registration fails, previously registered features are not rolled back
             // and they shouldnt: features are separate from mixins
         }
 
         // register mixin itself
-        basic_register_l(info, reg->sparse_mixins, !m_domain.m_settings.allow_duplicate_mixin_names);
+        basic_register_l(info, m_sparse_mixins, reg->mixins_by_name, reg->free_mixin_ids, !m_domain.m_settings.allow_duplicate_mixin_names);
         info.dom = &m_domain;
     }
 
-    void unregister_mixin(mixin_info& info) {
-        {
-            auto treg = m_type_registry.unique_lock();
-            // since this mixin is no longer valid
-            // remove all queries which contain it either as key or as value
-            auto& queries = treg->type_queries;
-            for (auto iq = queries.begin(); iq != queries.end(); ) {
-                if (iq->second->has(info.id)) {
-                    // query leads to a type which contains mixin
-                    iq = queries.erase(iq);
-                }
-                else if (itlib::pfind(iq->first, &info)) {
-                    // query references mixin
-                    iq = queries.erase(iq);
-                }
-                else {
-                    ++iq;
-                }
+    void register_mixins(itlib::span<mixin_info* const> infos) {
+        for (auto info : infos) {
+            if (info->dom != nullptr && info->dom != &m_domain) throw_exception::info_has_domain(m_domain, *info);
+        }
+
+        auto reg = m_element_registry.unique_lock();
+
+        // unregistered features of the mixins (each one once)
+        compat::pmr::vector<feature_info*> features(m_allocator);
+        for (auto info : infos) {
+            for (auto& f : info->features_span()) {
+                if (f.info->id != invalid_feature_id) continue;
+                // we need to const_cast. this is the price of lazy ops in C++
+                features.push_back(const_cast<feature_info*>(f.info));
             }
+        }
+        std::sort(features.begin(), features.end());
+        features.erase(std::unique(features.begin(), features.end()), features.end());
 
-            // ... and remove all types which reference it
-            auto& types = treg->types;
-            for (auto it = types.begin(); it != types.end(); ) {
-                auto& t = *it;
-                if (!t->has(info.id)) {
-                    // type does't have mixin
-                    ++it;
-                    continue;
-                }
+        // unlike register_mixin this is atomic: nothing is registered if anything fails
+        validate_register_l<feature_info>(features, reg->features_by_name, !m_domain.m_settings.allow_duplicate_feature_names);
+        validate_register_l(infos, reg->mixins_by_name, !m_domain.m_settings.allow_duplicate_mixin_names);
+        reserve_register_l(features.size(), m_sparse_features, reg->features_by_name, reg->free_feature_ids);
+        reserve_register_l(infos.size(), m_sparse_mixins, reg->mixins_by_name, reg->free_mixin_ids);
+
+        for (auto f : features) {
+            commit_register_l(*f, m_sparse_features, reg->features_by_name, reg->free_feature_ids);
+        }
+        for (auto info : infos) {
+            commit_register_l(*info, m_sparse_mixins, reg->mixins_by_name, reg->free_mixin_ids);
+            info->dom = &m_domain;
+        }
+    }
+
+    void unregister_mixins(itlib::span<mixin_info* const> infos) {
+        // the type registry is locked first, as elsewhere (the element registry is locked while applying rules)
+        auto treg = lock_types_unique();
+        auto ereg = m_element_registry.unique_lock();
+        auto& sparse_mixins = m_sparse_mixins;
+
+        // mixin is not our own?
+        // check them all before changing anything
+        for (auto info : infos) {
+            if (info->iid() >= sparse_mixins.size() || sparse_mixins[info->iid()] != info) throw_exception::unreg_foreign(m_domain, *info);
+        }
+
+        // declarative type classes are compiled to masks of mixin ids, which would be invalidated
+        // (and the ids may be reused), so their mixins can't be unregistered while they're registered
+        auto& sparse_masks = m_sparse_type_class_masks;
+        for (uint32_t i = 0; i < sparse_masks.size(); ++i) {
+            auto masks = sparse_masks[i];
+            if (!masks) continue;
+            for (auto info : infos) {
+                if (masks->references(info->iid())) throw_exception::unreg_referenced(m_domain, *info, *m_sparse_type_classes[i]);
+            }
+        }
 
+        // since these mixins are no longer valid, remove all types which have them
+        // as well as all queries which reference them
+        // the queries which lead to such types are linked to them, so we only need the others
+        compat::pmr::vector<dead_type> dead(m_allocator);
+        compat::pmr::vector<const type_query_node*> other_queries(m_allocator);
+        for (auto info : infos) {
+            treg->types.for_each_with(info->id, [&](const type& t) {
                 // removing a type with active objects?
                 // UB and crashes await
-                assert(t->num_objects() == 0);
-
-                it = types.erase(it);
+                assert(t.num_objects() == 0);
+                dead.push_back({&t, 0});
+            });
+            if (info->iid() < treg->queries_without_mixin.size()) {
+                auto& q = treg->queries_without_mixin[info->iid()];
+                other_queries.insert(other_queries.end(), q.begin(), q.end());
             }
         }
 
+        // types and queries may be reached through multiple mixins
+        auto dead_less = [](const dead_type& a, const dead_type& b) { return std::less<const type*>{}(a.t, b.t); };
+        std::sort(dead.begin(), dead.end(), dead_less);
+        dead.erase(std::unique(dead.begin(), dead.end(), [](const dead_type& a, const dead_type& b) { return a.t == b.t; }), dead.end());
+        std::sort(other_queries.begin(), other_queries.end());
+        other_queries.erase(std::unique(other_queries.begin(), other_queries.end()), other_queries.end());
+        other_queries.erase(std::remove_if(other_queries.begin(), other_queries.end(), [&](const type_query_node* node) {
+            return std::binary_search(dead.begin(), dead.end(), dead_type{node->t, 0}, dead_less);
+        }), other_queries.end());
+
+        reserve_more(ereg->free_mixin_ids, infos.size());
+
+        collect_l(*treg, dead, other_queries);
+
+        for (auto info : infos) {
+            if (info->id == invalid_mixin_id) continue; // duplicate in infos
+            unindex_name_l(*info, sparse_mixins, ereg->mixins_by_name, m_domain.m_settings.allow_duplicate_mixin_names);
+            sparse_mixins.set(info->iid(), nullptr); // free slot
+            release_id_l(ereg->free_mixin_ids, info->iid());
+
+            // invalidate info
+            info->id = invalid_mixin_id;
+            info->dom = nullptr;
+        }
+    }
+
+    void register_type_class(type_class& new_tc) {
+        if (new_tc.name.empty()) throw_exception::empty_name(m_domain, new_tc);
+        if (!new_tc.matches && !new_tc.num_required && !new_tc.num_forbidden) throw_exception::no_func(m_domain, new_tc);
+
         auto reg = m_element_registry.unique_lock();
-        auto& sparse_mixins = reg->sparse_mixins;
 
-        // mixin is not our own?
-        if (info.iid() >= sparse_mixins.size() || sparse_mixins[info.iid()] != &info) throw_exception::unreg_foreign(m_domain, info);
-        sparse_mixins[info.iid()] = nullptr; // free slot
+        if (new_tc.dom != nullptr && new_tc.dom != &m_domain) throw_exception::info_has_domain(m_domain, new_tc);
+
+        const auto hash = name_hash(new_tc.name.to_std());
+        if (reg->type_classes_by_name.find(new_tc.name.to_std(), hash)) throw_exception::duplicate_name(m_domain, new_tc);
+
+        auto& sparse = m_sparse_type_classes;
+        auto& sparse_masks = m_sparse_type_class_masks;
+        uint32_t free_slot = 0;
+        while (free_slot < sparse.size() && sparse[free_slot]) ++free_slot;
+        sparse.reserve(free_slot + 1);
+        sparse_masks.reserve(free_slot + 1);
+
+        const type_class_masks* masks = nullptr;
+        if (new_tc.declarative()) masks = compile_type_class_l(new_tc);
+
+        reg->type_classes_by_name.insert(new_tc, hash);
+
+        // the masks are published first, as they're looked up by the id of the type class
+        if (free_slot == sparse.size()) {
+            sparse_masks.push_back(masks);
+            sparse.push_back(&new_tc);
+        }
+        else {
+            sparse_masks.set(free_slot, masks);
+            sparse.set(free_slot, &new_tc);
+        }
 
-        // invalidate info
-        info.id = invalid_mixin_id;
-        info.dom = nullptr;
+        // the type caches for the slot were cleared when it was freed, so types can use them right away
+        new_tc.id = free_slot;
+        new_tc.dom = &m_domain;
     }
 
-    void register_type_class(const type_class& new_tc) {
-        if (new_tc.name.empty()) throw_exception::empty_name(m_domain, new_tc);
-        if (!new_tc.matches) throw_exception::no_func(m_domain, new_tc);
+    const type_class_masks* compile_type_class_l(const type_class& tc) {
+        auto words_for = [&](itlib::span<const mixin_info* const> mixins) {
+            uint32_t ret = 0;
+            for (auto m : mixins) {
+                if (m->dom != &m_domain || m->id == invalid_mixin_id || m_sparse_mixins[m->iid()] != m) {
+                    throw_exception::foreign_mixin(m_domain, tc, *m);
+                }
+                ret = std::max(ret, m->iid() / 64 + 1);
+            }
+            return ret;
+        };
+        const auto num_required = words_for(tc.required_span());
+        const auto num_forbidden = words_for(tc.forbidden_span());
+
+        static_assert(alignof(type_class_masks) <= alignof(uint64_t));
+        static_assert(sizeof(type_class_masks) % alignof(uint64_t) == 0);
+        const type_class_masks header = {num_required, num_forbidden};
+        auto bytes = m_allocator.allocate_bytes(header.buf_size(), alignof(uint64_t));
+        auto ret = new (bytes) type_class_masks(header);
+        auto words = reinterpret_cast<uint64_t*>(ret + 1);
+        std::fill(words, words + num_required + num_forbidden, uint64_t(0));
+        for (auto m : tc.required_span()) {
+            words[m->iid() / 64] |= uint64_t(1) << (m->iid() % 64);
+        }
+        words += num_required;
+        for (auto m : tc.forbidden_span()) {
+            words[m->iid() / 64] |= uint64_t(1) << (m->iid() % 64);
+        }
+        return ret;
+    }
 
+    void free_type_class_masks(const type_class_masks* masks) noexcept {
+        if (!masks) return;
+        const void* cvptr = masks;
+        m_allocator.deallocate_bytes(const_cast<void*>(cvptr), masks->buf_size(), alignof(uint64_t));
+    }
+
+    void unregister_type_class(type_class& tc) {
+        // the type registry is locked to reset the type class caches of the types
+        auto treg = lock_types_shared();
         auto reg = m_element_registry.unique_lock();
 
-        // search in reverse order while also checking for name clashes
-        const type_class** free_slot = nullptr;
-        for (auto i = reg->sparse_type_classes.rbegin(); i != reg->sparse_type_classes.rend(); ++i) {
-            auto tc = *i;
-            if (tc) {
-                if (tc->name == new_tc.name) throw_exception::duplicate_name(m_domain, new_tc);
-            }
-            else {
-                free_slot = &tc;
-            }
+        uint32_t slot;
+        if (!registered_id(tc, slot)) return;
+        m_sparse_type_classes.set(slot, nullptr);
+        reg->type_classes_by_name.erase(tc, name_hash(tc.name.to_std()));
+        tc.dom = nullptr;
+        tc.id = 0;
+
+        auto& sparse_masks = m_sparse_type_class_masks;
+        free_type_class_masks(sparse_masks[slot]);
+        sparse_masks.set(slot, nullptr);
+
+        // the slot may be reused by another type class, so forget the cached results for it
+        // cache misses store results under the shared lock of the element registry (see cached_is_of),
+        // so none can be stored for this type class after this
+        if (slot >= type::num_cached_type_classes) return;
+        const uint64_t keep = ~(uint64_t(1) << slot);
+        const auto reset = [&](const type& t) {
+            t.m_type_classes_known.fetch_and(keep, std::memory_order_relaxed);
+        };
+        reset(m_empty_type);
+        treg->types.for_each(reset);
+    }
+
+    // the id of a registered type class is its slot in the sparse array (stored in the type class)
+    bool registered_id(const type_class& tc, uint32_t& id) const noexcept {
+        if (tc.dom != &m_domain) return false;
+        if (m_sparse_type_classes.find(tc.id) != &tc) return false;
+        id = tc.id;
+        return true;
+    }
+
+    // match without the cache
+    // declarative type classes are evaluated through the masks if they're registered
+    static bool match_type_class(const type& t, const type_class& tc, const type_class_masks* masks) noexcept {
+        if (tc.matches) return tc.matches(&t);
+        if (masks) return masks->match(t.mixin_id_bits);
+        for (auto m : tc.required_span()) {
+            if (!t.has(*m)) return false;
+        }
+        for (auto m : tc.forbidden_span()) {
+            if (t.has(*m)) return false;
         }
+        return true;
+    }
 
-        if (!free_slot) {
-            free_slot = &reg->sparse_type_classes.emplace_back();
+    bool cached_is_of(const type& t, const type_class& tc, uint32_t id) const noexcept {
+        const auto masks = m_sparse_type_class_masks.find(id);
+        if (id >= type::num_cached_type_classes) return match_type_class(t, tc, masks);
+        const uint64_t bit = uint64_t(1) << id;
+        if (t.m_type_classes_known.load(std::memory_order_acquire) & bit) {
+            return t.m_type_classes_matching.load(std::memory_order_relaxed) & bit;
         }
+        const bool match = match_type_class(t, tc, masks);
+
+        // store the result only if the type class still has the slot
+        // unregister_type_class clears the bits of the slot under the unique lock
+        // so a result can't be stored for a slot which was freed (and maybe reused) after we got it
+        auto reg = m_element_registry.shared_lock();
+        if (m_sparse_type_classes[id] != &tc) return match;
+        if (match) t.m_type_classes_matching.fetch_or(bit, std::memory_order_relaxed);
+        else t.m_type_classes_matching.fetch_and(~bit, std::memory_order_relaxed);
+        t.m_type_classes_known.fetch_or(bit, std::memory_order_release);
+        return match;
+    }
 
-        *free_slot = &new_tc;
+    bool type_is_of(const type& t, const type_class& tc) const noexcept {
+        uint32_t id;
+        if (!registered_id(tc, id)) return match_type_class(t, tc, nullptr); // not registered
+        return cached_is_of(t, tc, id);
     }
 
-    void unregister_type_class(const type_class& tc) {
-        auto reg = m_element_registry.unique_lock();
+    void for_each_type_of(const type_class& tc, const std::function<void(const type&)>& func) {
+        auto reg = lock_types_shared();
 
-        for (auto& rtc : reg->sparse_type_classes) {
-            if (rtc == &tc) {
-                rtc = nullptr;
-                return;
-            }
+        uint32_t id;
+        if (!registered_id(tc, id)) {
+            // not registered
+            reg->types.for_each([&](const type& t) {
+                if (match_type_class(t, tc, nullptr)) func(t);
+            });
+            return;
         }
+
+        // evaluate the masks directly, as the types are likely not in the cache
+        if (auto masks = m_sparse_type_class_masks.find(id)) {
+            reg->types.for_each([&](const type& t) {
+                if (masks->match(t.mixin_id_bits)) func(t);
+            });
+            return;
+        }
+
+        reg->types.for_each([&](const type& t) {
+            if (cached_is_of(t, tc, id)) func(t);
+        });
     }
 
-    template <typename Id, typename T>
-    static const T* basic_get_by_id_l(Id id, const compat::pmr::vector<const T*>& sparse) noexcept {
-        if (id.i >= sparse.size()) return nullptr;
-        return sparse[id.i];
+    bool type_is_of(const type& t, std::string_view tc_name, bool& result) const noexcept {
+        auto tc = get_type_class(tc_name);
+        uint32_t id;
+        if (!tc || !registered_id(*tc, id)) return false;
+        result = cached_is_of(t, *tc, id);
+        return true;
     }
 
+
     template <typename T>
-    static const T* basic_get_by_name_l(std::string_view name, const compat::pmr::vector<const T*>& sparse) noexcept {
-        for (auto& info : sparse) {
-            if (info && info->name == name) return info;
-        }
-        return nullptr;
+    static const T* basic_get_by_name_l(std::string_view name, const name_index<T>& by_name) noexcept {
+        return by_name.find(name, name_hash(name));
     }
 
     const mixin_info* get_mixin_info(mixin_id id) noexcept {
-        return basic_get_by_id_l(id, m_element_registry.shared_lock()->sparse_mixins);
+        return m_sparse_mixins.find(id.i);
     }
     const mixin_info* get_mixin_info(std::string_view name) noexcept {
-        return basic_get_by_name_l(name, m_element_registry.shared_lock()->sparse_mixins);
+        return basic_get_by_name_l(name, m_element_registry.shared_lock()->mixins_by_name);
     }
 
     const feature_info* get_feature_info(feature_id id) noexcept {
-        return basic_get_by_id_l(id, m_element_registry.shared_lock()->sparse_features);
+        return m_sparse_features.find(id.i);
     }
     const feature_info* get_feature_info(std::string_view name) noexcept {
-        return basic_get_by_name_l(name, m_element_registry.shared_lock()->sparse_features);
+        return basic_get_by_name_l(name, m_element_registry.shared_lock()->features_by_name);
     }
 
-    const type_class* get_type_class(std::string_view name) noexcept {
-        return basic_get_by_name_l(name, m_element_registry.shared_lock()->sparse_type_classes);
+    const type_class* get_type_class(std::string_view name) const noexcept {
+        return basic_get_by_name_l(name, m_element_registry.shared_lock()->type_classes_by_name);
     }
 
     void add_mutation_rule(const mutation_rule_info& info) {
-        if (!info.apply) throw_exception::no_func(m_domain, info);
+        if (!info.apply && !info.num_clauses) throw_exception::no_func(m_domain, info);
 
-        auto reg = m_type_registry.unique_lock();
+        auto reg = lock_types_unique();
 
         auto& rc = reg->mutation_rules[&info];
         ++rc;
         if (rc != 1) return; // not first-time registering
 
         // first time registered
+        try {
+            add_rule_clauses_l(*reg, info);
+        }
+        catch (...) {
+            reg->mutation_rules.erase(&info);
+            throw;
+        }
+        if (info.apply) ++reg->num_apply_rules;
+
         // we need to invalidate stored type queries
-        // we can't tell which ones the rule affects, so we have to invalidate them all
-        reg->type_queries.clear();
+        invalidate_queries_for_rule_l(*reg, info);
     }
     void remove_mutation_rule(const mutation_rule_info& info) noexcept {
-        auto reg = m_type_registry.unique_lock();
+        auto reg = lock_types_unique();
         auto f = reg->mutation_rules.find(&info);
         if (f == reg->mutation_rules.end()) return; // not added
         assert(f->second > 0);
@@ -426,16 +1842,135 @@ public:
 
         // refs are zero, so remove rule and invalidate stored type queries
         reg->mutation_rules.erase(f);
+        itlib::erase_all_if(reg->rule_clauses, [&](const compiled_clause& c) { return c.rule == &info; });
+        if (info.apply) --reg->num_apply_rules;
+        invalidate_queries_for_rule_l(*reg, info);
+    }
+
+    // compile the clauses of a newly added rule
+    // the rule must be in the map already
+    static void add_rule_clauses_l(type_registry& reg, const mutation_rule_info& info) {
+        if (!info.num_clauses) return;
+        auto& clauses = reg.rule_clauses;
+        clauses.reserve(clauses.size() + info.num_clauses);
+        for (uint32_t i = 0; i < info.num_clauses; ++i) {
+            auto& c = info.clauses[i];
+            clauses.push_back({c.condition, c.target, c.remove, &info, i});
+        }
+        std::sort(clauses.begin(), clauses.end(), [](const compiled_clause& a, const compiled_clause& b) {
+            if (a.condition != b.condition) return std::less<const mixin_info*>{}(a.condition, b.condition);
+            if (a.rule != b.rule) return rule_compare{}(a.rule, b.rule);
+            return a.index < b.index;
+        });
+    }
+
+    // evaluate the clauses of declarative rules for a mutation
+    // additions are propagated with a worklist (the mixins of the mutation itself), so the result is a fixed point
+    // reached in a single pass: each clause is applied once, when its condition becomes a part of the mutation
+    void apply_rule_clauses_l(type_mutation& mutation, const type_registry& reg) {
+        auto& clauses = reg.rule_clauses;
+        if (clauses.empty()) return;
+
+        auto clauses_of = [&](const mixin_info* m) {
+            return std::equal_range(clauses.begin(), clauses.end(), m, clause_condition_less{});
+        };
+
+        auto& mixins = mutation.mixins;
+        const auto num_original = mixins.size();
+
+        mixin_set present(m_domain, m_allocator);
+        mixin_set removed(m_domain, m_allocator);
+        for (auto m : mixins) present.insert(m);
+
+        for (size_t i = 0; i < mixins.size(); ++i) {
+            auto [begin, end] = clauses_of(mixins[i]);
+            for (auto c = begin; c != end; ++c) {
+                if (c->remove) removed.insert(c->target);
+                else if (present.insert(c->target)) mixins.push_back(c->target);
+            }
+        }
+
+        if (removed.empty()) return;
+
+        // removals win
+        // propagate the additions again without the removed mixins, so that the ones they caused are dropped
+        mixins.resize(num_original);
+        itlib::erase_all_if(mixins, [&](const mixin_info* m) { return removed.contains(m); });
+        present.clear();
+        for (auto m : mixins) present.insert(m);
+
+        for (size_t i = 0; i < mixins.size(); ++i) {
+            auto [begin, end] = clauses_of(mixins[i]);
+            for (auto c = begin; c != end; ++c) {
+                if (c->remove || removed.contains(c->target)) continue;
+                if (present.insert(c->target)) mixins.push_back(c->target);
+            }
+        }
+
+        // the number of mixins may be the same as before, so the mutation doesn't know they changed
+        mutation.mixins_changed();
+    }
+
+    struct clause_condition_less {
+        bool operator()(const compiled_clause& c, const mixin_info* m) const noexcept {
+            return std::less<const mixin_info*>{}(c.condition, m);
+        }
+        bool operator()(const mixin_info* m, const compiled_clause& c) const noexcept {
+            return std::less<const mixin_info*>{}(m, c.condition);
+        }
+    };
+
+    // invalidate the stored type queries which a rule may affect
+    void invalidate_queries_for_rule_l(type_registry& reg, const mutation_rule_info& info) noexcept {
+        if (!info.is_opaque()) {
+            try {
+                compat::pmr::vector<const type_query_node*> affected(m_allocator);
+                queries_involving_l(reg, info.reacts_to_span(), affected);
+                queries_involving_l(reg, info.changes_span(), affected);
+                for (auto& c : info.clauses_span()) {
+                    const mixin_info* clause_mixins[] = {c.condition, c.target};
+                    queries_involving_l(reg, clause_mixins, affected);
+                }
+                std::sort(affected.begin(), affected.end());
+                affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+                collect_l(reg, {}, affected);
+                invalidate_edges_l();
+                return;
+            }
+            catch (std::bad_alloc&) {
+                // fallback to clearing all
+            }
+        }
+
         // we can't tell which ones the rule affects, so we have to invalidate them all
-        reg->type_queries.clear();
+        clear_queries_l(reg);
+        invalidate_edges_l();
     }
 
-    // applies mutation rules for mutation and returns the original query to be preserved
-    // this is also an optimization opportunity
-    // if the mutation doesn't change the query, we've wasted cpu to make this copy
-    // and this is likely the majority of the cases
-    // TODO: optimize: a better approach here would be to use CoW
-    type_query apply_mutation_rules_l(type_mutation& mutation, const mutation_rule_map& rules) {
+    // add the stored queries which involve any of the mixins to out
+    // these are the queries which have the mixins and the ones which lead to types which have them
+    void queries_involving_l(type_registry& reg, itlib::span<const mixin_info* const> mixins, compat::pmr::vector<const type_query_node*>& out) {
+        for (auto m : mixins) {
+            // mixins which are not registered with us can't be a part of any query
+            if (m->id == invalid_mixin_id || m->dom != &m_domain) continue;
+            reg.types.for_each_with(m->id, [&](const type& t) {
+                for (auto node = first_query(t); node; node = node->next_for_type) {
+                    out.push_back(node);
+                }
+            });
+            if (m->iid() < reg.queries_without_mixin.size()) {
+                auto& q = reg.queries_without_mixin[m->iid()];
+                out.insert(out.end(), q.begin(), q.end());
+            }
+        }
+    }
+
+    // applies mutation rules for mutation
+    // if they changed it, the original query (to be preserved) is copied to original_query and true is returned
+    // otherwise original_query is not touched and the mutation's mixins are the original query
+    // (rules change nothing in the majority of the cases, so we only copy the query when we must)
+    bool apply_mutation_rules_l(type_mutation& mutation, const type_registry& reg, type_query& original_query) {
+        auto& rules = reg.mutation_rules;
 
         // so, rules may have dependencies between themselves
         // it would be easy to say "users must take care of them by order_priority" and dynamix 1 did just that
@@ -445,6 +1980,8 @@ public:
         // we can't do a real topological sort, because rules are opaque
         // (and there is no obvious way to make them non-opaque, while keeping their power)
         // so, we run them again and again until applying them produces the same result as the previous apply
+        // (declarative rules are not opaque and are evaluated to a fixed point with a single pass in each application,
+        // so if there are no others, one application is enough)
         // but no more than...
         static constexpr int max_depenency_depth = 5; // somewhat arbitrary, but who needs more than 5? :)
         // ...times. It's true that deeper non-cycling dependencies may exist,
@@ -452,27 +1989,51 @@ public:
         // instead we give this arbitrary limit and say: "users must take care to sort rules with
         // deeper dependencies by order_priority": a much laxer restriction than the initial one
 
-        type_query original_query(m_allocator); // store original query here to return
-        type_query last_result(m_allocator); // store last rule application result here
-
         auto& nt_mixins = mutation.mixins;
-        last_result = nt_mixins;
+        const auto is_dep = [](const mixin_info* m) { return m->dependency; };
+
+        // without rules the only thing which can change the mutation is the erasure of deps
+        if (rules.empty() && !itlib::pfind_if(nt_mixins, is_dep)) return false;
+
+        count(&stats_counters::rule_applications);
+
+        event_scope applied(*this, dnmx_domain_event_rules_applied);
+        applied.mixins_vec = &nt_mixins;
+
+        // store last rule application result here
+        // it lives in an inline buffer, so that the common case of rules changing nothing doesn't allocate
+        bits::inline_buffer_resource<type_mutation::inline_capacity * sizeof(const mixin_info*), alignof(const mixin_info*)> last_result_buf(m_allocator.resource());
+        type_query last_result(&last_result_buf);
+        last_result.reserve(type_mutation::inline_capacity);
+        last_result.assign(nt_mixins.begin(), nt_mixins.end());
 
         // first erase all deps from mixins
-        itlib::erase_all_if(nt_mixins, [](const mixin_info* m) { return m->dependency; });
+        itlib::erase_all_if(nt_mixins, is_dep);
 
         for (int i = 0; ; ++i) {
+            count(&stats_counters::rule_passes);
+            applied.e.count = uint32_t(i + 1);
+
             // apply rules
+            apply_rule_clauses_l(mutation, reg);
+            if (reg.num_apply_rules == 0 && !rules.empty()) {
+                // declarative rules reach a fixed point in a single application
+                if (last_result == nt_mixins) return false;
+                original_query.assign(last_result.begin(), last_result.end());
+                return true;
+            }
+
             for (auto& r : rules) {
                 auto& info = *r.first;
+                if (!info.apply) continue;
                 if (auto err = info.apply(mutation.to_c_hanlde(), info.user_data)) {
                     throw_exception::mutation_rule_user_error(mutation, info, err);
                 }
             }
             if (last_result == nt_mixins) {
                 // rules changed nothing, so no need to apply them again
-                if (i == 0) return last_result; // first application changed nothing
-                return original_query;
+                // if this is the first application, nothing was changed at all
+                return i != 0;
             }
             if (i == max_depenency_depth || i == int(rules.size())) {
                 // again: this is not necessarily a real cycle but we treat it as such
@@ -480,40 +2041,96 @@ public:
             }
             if (i == 0) {
                 // first time running the loop and rules made changes, store original query to return
-                original_query.swap(last_result);
+                original_query.assign(last_result.begin(), last_result.end());
             }
-            last_result = nt_mixins;
+            last_result.assign(nt_mixins.begin(), nt_mixins.end());
         }
     }
 
-    const type& get_type(type_mutation& mutation) {
+    // base is optional: the type from which the mutation started
+    // if provided, it must be alive until the function returns
+    const type& get_type(type_mutation& mutation, const type* base = nullptr) {
         if (&mutation.dom != &m_domain) throw_exception::foreign_mutation(m_domain, mutation);
 
+        // search for stored query for this combo
+        // this doesn't lock the type registry
+        const auto query_hash = mixin_span_hash(mutation.mixins);
+        if (auto t = find_query_lock_free(mutation.mixins, query_hash)) {
+            count(&stats_counters::type_query_hits);
+            return *t;
+        }
+        count(&stats_counters::type_query_misses);
+
         type_query original_query(m_allocator); // prepare original query with our allocator
+        itlib::span<const mixin_info* const> query; // the query to store (original_query or the mixins of the mutation)
         const type* found = nullptr;
+        uptr<type> new_type;
+        size_t mixins_hash = 0;
+
+        type_build own_build;
+        type_build* other_build = nullptr;
+        build_guard guard{*this};
+        type_ref source_ref;
+
+        event_scope miss(*this, dnmx_domain_event_query_miss);
 
         {
-            // search for stored query for this combo
-            auto reg = m_type_registry.shared_lock();
-            {
-                auto f = reg->type_queries.find(mutation.mixins);
-                if (f != reg->type_queries.end()) return *f->second;
-            }
+            auto reg = lock_types_shared();
 
             // query is not available, so we need to apply mutation rules
             // we can do it while holding the shared lock
-            original_query = apply_mutation_rules_l(mutation, reg->mutation_rules);
+            if (apply_mutation_rules_l(mutation, *reg, original_query)) {
+                query = original_query;
+            }
+            else {
+                query = mutation.mixins;
+            }
+            miss.set_mixins(query);
 
             // now look for exact type
             if (mutation.mixins.empty()) {
                 found = &m_empty_type;
             }
             else {
-                auto f = reg->types.find(mutation.mixins);
-                if (f != reg->types.end()) found = f->get();
+                mixins_hash = mixin_span_hash(mutation.mixins);
+                found = reg->types.find(mutation.mixins, mixins_hash);
+            }
+
+            if (!found) {
+                // we will need to create a new type unless another thread is already doing it
+                own_build.mixins = mutation.mixins;
+                own_build.hash = mixins_hash;
+                other_build = join_build_l(own_build);
+                if (!other_build) guard.build = &own_build;
+            }
+
+            if (guard.build) {
+                // if there is a similar existing one, we can derive the new ftable from it
+                // most new types are an existing type plus a mixin (or a mixin plus its dependencies)
+                // so without a base we try the type without the last mixin
+                const type* source = base;
+                if (!source && mutation.mixins.size() > 1) {
+                    mixin_info_span prefix(mutation.mixins.data(), mutation.mixins.size() - 1);
+                    source = reg->types.find(prefix, mixin_span_hash(prefix));
+                }
+                // the source is referenced, so that it can't be collected while we build without locking
+                source_ref = type_ref(source);
             }
         }
 
+        if (source_ref.t) {
+            new_type = build_type(mutation, source_ref.t);
+            source_ref = {};
+        }
+
+        if (other_build) {
+            // the type is built by another thread, so we use its result
+            // it's null if the other build failed, in which case we try for ourselves
+            // (and likely fail in the same way)
+            found = wait_for_build(*other_build);
+            if (found) count(&stats_counters::type_builds_avoided);
+        }
+
         if (found) {
             // we found a type with this mutation, but don't have the query stored
             // store the query only and return the type
@@ -522,43 +2139,196 @@ public:
             // but the code below is safe
             // worst (and extremely rare) case we wasted cpu applying the same rules twice
 
-            auto reg = m_type_registry.unique_lock();
-            reg->type_queries[std::move(original_query)] = found;
-            return *found;
+            auto reg = lock_types_unique();
+
+            // the type could have been collected after we released the shared lock
+            // in such a case we create it again below
+            if (found == &m_empty_type || reg->types.contains(found, mixins_hash)) {
+                hand_out(*found);
+                store_query_l(*reg, query, query_hash, found);
+                miss.e.type_handle = found;
+                return *found;
+            }
         }
 
-        return create_type(mutation, std::move(original_query));
+        auto& ret = create_type(mutation, query, query_hash, std::move(new_type), base);
+        guard.result = &ret;
+        miss.e.type_handle = &ret;
+        return ret;
     }
 
+    // registers own as a build in flight, unless the same type is being built
+    // in such a case, returns the other build which must be waited for with wait_for_build
+    // (called with the type registry locked, so a build can't finish while a type is being looked up)
+    type_build* join_build_l(type_build& own) {
+        std::lock_guard lock(m_builds_mutex);
+        for (auto b : m_builds) {
+            if (b->hash == own.hash && std::equal(b->mixins.begin(), b->mixins.end(), own.mixins.begin(), own.mixins.end())) {
+                ++b->waiters;
+                return b;
+            }
+        }
+        m_builds.push_back(&own);
+        return nullptr;
+    }
+
+    const type* wait_for_build(type_build& b) noexcept {
+        std::unique_lock lock(m_builds_mutex);
+        m_builds_cv.wait(lock, [&]() { return b.done; });
+        auto ret = b.result;
+        if (--b.waiters == 0) m_builds_cv.notify_all();
+        return ret;
+    }
+
+    // publishes the result of own build (null on failure) to the waiters
+    void finish_build(type_build& own, const type* result) noexcept {
+        std::unique_lock lock(m_builds_mutex);
+        m_builds.erase(std::find(m_builds.begin(), m_builds.end(), &own));
+        own.result = result;
+        own.done = true;
+        m_builds_cv.notify_all();
+
+        // own lives on the stack, so we must wait for the waiters to pick up the result
+        m_builds_cv.wait(lock, [&]() { return own.waiters == 0; });
+    }
+
+    // finishes a build when get_type returns or throws
+    // it must be destroyed after the type registry lock is released as the waiters will lock it
+    struct build_guard {
+        impl& self;
+        type_build* build = nullptr;
+        const type* result = nullptr;
+        ~build_guard() {
+            if (build) self.finish_build(*build, result);
+        }
+    };
+
     const type& get_type(itlib::span<const mixin_info* const> mixins) {
+        // search for stored query for this combo
+        // (misses are counted by the get_type call below)
+        if (auto t = find_query_lock_free(mixins, mixin_span_hash(mixins))) {
+            count(&stats_counters::type_query_hits);
+            return *t;
+        }
+
+        // no stored query, so create a mutation and apply rules
+        // creating a mutation will run more or less the exact same as above again
+        // (this is cheap: the mutation doesn't allocate for small queries)
+        type_mutation mut(m_domain, m_allocator);
+        mut.mixins.assign(mixins.begin(), mixins.end());
+        return get_type(mut);
+    }
+
+    // edges are seqlocks
+    // the field loads are acquire, so that the seq recheck can't happen before them
+    // the field stores are release, so that a reader who sees any of them, also sees the odd seq
+    static const type* find_edge(const type::edge& e, const mixin_info& mixin, uint32_t generation) noexcept {
+        auto seq = e.seq.load(std::memory_order_acquire);
+        if (seq & 1) return nullptr; // being written
+        auto e_mixin = e.mixin.load(std::memory_order_acquire);
+        auto e_generation = e.generation.load(std::memory_order_acquire);
+        auto e_target = e.target.load(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != seq) return nullptr; // was written while we were reading
+        if (e_mixin != &mixin || e_generation != generation) return nullptr;
+        return e_target;
+    }
+
+    static void store_edge(type::edge& e, const mixin_info& mixin, const type& target, uint32_t generation) noexcept {
+        auto seq = e.seq.load(std::memory_order_relaxed);
+        if (seq & 1) return; // another thread is writing, we can just leave it be
+        if (!e.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+        e.mixin.store(&mixin, std::memory_order_release);
+        e.generation.store(generation, std::memory_order_release);
+        e.target.store(&target, std::memory_order_release);
+        e.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    template <typename Mutate>
+    const type& get_edge_type(const type& base, type::edge (&edges)[type::num_edges], const mixin_info& mixin, Mutate&& mutate) {
+        if (&base.dom != &m_domain) {
+            // edges of foreign types are meaningless to us
+            // just let get_type produce an error
+            type_mutation mut(base, m_allocator);
+            mutate(mut);
+            return get_type(mut);
+        }
+
+        // get the generation before getting the type
+        // if edges are invalidated in the meantime, the one we store will be invalid
+        // edge hits are in the same critical section as lock-free queries, so collections can see them
+        auto& e = edges[mixin.iid() % type::num_edges];
+        uint32_t generation;
         {
-            // search for stored query for this combo
-            auto reg = m_type_registry.shared_lock();
-            auto f = reg->type_queries.find(mixins);
-            if (f != reg->type_queries.end()) return *f->second;
+            auto guard = m_type_queries_epoch.enter();
+            generation = m_edge_generation.load(std::memory_order_acquire);
+            if (auto t = find_edge(e, mixin, generation)) {
+                hand_out(*t);
+                return *t;
+            }
         }
 
-        // no stored query, so create a mutation and apply rules
-        // creating a mutation will run more or less the exact same as above again
-        // TODO: optimize
-        type_mutation mut(m_domain, m_allocator);
-        mut.mixins.assign(mixins.begin(), mixins.end());
-        return get_type(mut);
+        type_mutation mut(base, m_allocator);
+        mutate(mut);
+        auto& ret = get_type(mut, &base);
+        store_edge(e, mixin, ret, generation);
+        return ret;
+    }
+
+    const type& get_type_with(const type& base, const mixin_info& mixin) {
+        return get_edge_type(base, base.m_add_edges, mixin, [&](type_mutation& mut) { mut.add(mixin); });
+    }
+
+    const type& get_type_without(const type& base, const mixin_info& mixin) {
+        return get_edge_type(base, base.m_remove_edges, mixin, [&](type_mutation& mut) { mut.remove(mixin); });
     }
 
     struct ftable_build_helper {
         const type_mutation& m_mut;
 
+        // if not null, the ftable is derived from the ftable of this type
+        // only entries touched by added or removed mixins are rebuilt
+        // the rest are copied (with fixed mixin indices)
+        const type* m_source = nullptr;
+
         // number of reachable payloads per feature id
         compat::pmr::vector<uint32_t> m_num_reachable_pls;
 
         // total number of ftable_payload-s to allocate
         uint32_t m_num_total_pls = 0;
 
-        ftable_build_helper(type_mutation& mutation)
+        // index in the new type of each mixin of the source (invalid if removed)
+        compat::pmr::vector<mixin_index_t> m_source_to_new;
+
+        // per feature id: whether added or removed mixins implement it
+        compat::pmr::vector<uint8_t> m_touched;
+
+        // compact ftables (see domain_settings::compact_types) have an entry per implemented feature
+        // the entries are placed by a perfect hash of the feature ids (see dnmx_ftable_hash)
+        bool m_compact = false;
+        uint32_t m_hash_length = 0; // number of entries in a compact ftable
+        uint32_t m_hash_seed = 0;
+        compat::pmr::vector<uint32_t> m_hash_displacements;
+        compat::pmr::vector<dnmx_id_int_t> m_hash_keys; // feature id per entry
+
+        ftable_build_helper(type_mutation& mutation, const type* source)
             : m_mut(mutation)
             , m_num_reachable_pls(m_mut.dom.get_allocator())
+            , m_source_to_new(m_mut.dom.get_allocator())
+            , m_touched(m_mut.dom.get_allocator())
+            , m_hash_displacements(m_mut.dom.get_allocator())
+            , m_hash_keys(m_mut.dom.get_allocator())
         {
+            init(source);
+            m_compact = m_mut.dom.settings().compact_types && !m_num_reachable_pls.empty();
+            if (m_compact) build_hash();
+        }
+
+        void init(const type* source) {
+            if (source && !source->mixins.empty() && init_from_source(*source)) {
+                m_source = source;
+                return;
+            }
+
             // first pass: find greatest feature_id in mixins to determine ftable size
             feature_id::int_t ftable_size = 0;
             for (const auto* mixin : m_mut.mixins) {
@@ -582,8 +2352,181 @@ public:
             }
         }
 
+        // returns false if the ftable can't be derived from the source
+        bool init_from_source(const type& source) {
+            // the mixins which remain from the source must preserve their relative order
+            // thus the order of their payloads in untouched entries is also preserved
+            m_source_to_new.assign(source.mixins.size(), invalid_mixin_index);
+            feature_id::int_t ftable_size = 0;
+            for (uint32_t s = 0; s < source.ftable_length; ++s) {
+                if (!source.ftable[s]) continue;
+                const auto size_with = source_feature_id(source, s) + 1;
+                if (size_with > ftable_size) {
+                    ftable_size = size_with;
+                }
+            }
+            int prev_source_index = -1;
+            for (mixin_index_t i = 0; i < m_mut.mixins.size(); ++i) {
+                const auto* mixin = m_mut.mixins[i];
+                auto source_index = source.index_of(mixin->id);
+                if (source_index == invalid_mixin_index) {
+                    // added
+                    for (auto& feature : mixin->features_span()) {
+                        const auto size_with = feature.info->iid() + 1;
+                        if (size_with > ftable_size) {
+                            ftable_size = size_with;
+                        }
+                    }
+                    continue;
+                }
+                if (int(source_index) <= prev_source_index) return false; // reordered
+                prev_source_index = int(source_index);
+                m_source_to_new[source_index] = i;
+            }
+
+            m_num_reachable_pls.assign(ftable_size, 0);
+            m_touched.assign(ftable_size, 0);
+            for (uint32_t s = 0; s < source.ftable_length; ++s) {
+                auto& entry = source.ftable[s];
+                if (!entry) continue;
+                m_num_reachable_pls[source_feature_id(source, s)] = uint32_t(entry.end - entry.begin);
+            }
+
+            for (mixin_index_t i = 0; i < source.mixins.size(); ++i) {
+                if (m_source_to_new[i] != invalid_mixin_index) continue;
+                // removed
+                for (auto& feature : source.mixins[i]->features_span()) {
+                    --m_num_reachable_pls[feature.info->iid()];
+                    m_touched[feature.info->iid()] = 1;
+                }
+            }
+            for (const auto* mixin : m_mut.mixins) {
+                if (source.has(mixin->id)) continue;
+                for (auto& feature : mixin->features_span()) {
+                    ++m_num_reachable_pls[feature.info->iid()];
+                    m_touched[feature.info->iid()] = 1;
+                }
+            }
+
+            // removed mixins may have been the only ones to implement the last features
+            while (!m_num_reachable_pls.empty() && m_num_reachable_pls.back() == 0) {
+                m_num_reachable_pls.pop_back();
+            }
+
+            for (auto n : m_num_reachable_pls) m_num_total_pls += n;
+            return true;
+        }
+
+        // feature id of an entry of the ftable of a type (which can be compact or not)
+        static feature_id::int_t source_feature_id(const type& source, uint32_t slot) noexcept {
+            return source.ftable_hash.keys ? source.ftable_hash.keys[slot] : slot;
+        }
+
+        // build a perfect hash of the implemented feature ids
+        // the ids are split into buckets with a seeded hash, then the buckets (largest first) are given
+        // displacements which place their ids in free slots of the table
+        // if some bucket can't be placed, we retry with a different seed and eventually with a bigger table
+        void build_hash() {
+            auto alloc = m_mut.dom.get_allocator();
+
+            compat::pmr::vector<dnmx_id_int_t> ids(alloc);
+            for (feature_id::int_t i = 0; i < m_num_reachable_pls.size(); ++i) {
+                if (m_num_reachable_pls[i]) ids.push_back(i);
+            }
+            const auto num_ids = uint32_t(ids.size());
+
+            const uint32_t num_buckets = num_ids / 4 + 1;
+            m_hash_length = num_ids + num_ids / 4 + 1; // load factor of ~0.8
+
+            compat::pmr::vector<uint32_t> bucket_offsets(alloc); // ids sorted by bucket
+            compat::pmr::vector<dnmx_id_int_t> bucket_ids(alloc);
+            compat::pmr::vector<uint32_t> buckets_by_size(alloc);
+            compat::pmr::vector<uint32_t> slots(alloc);
+
+            for (uint32_t attempt = 0; ; ++attempt) {
+                if (attempt != 0 && attempt % 4 == 0) {
+                    // the table is too tight
+                    m_hash_length += m_hash_length / 8 + 1;
+                }
+                m_hash_seed = attempt * 0x6A09E667u;
+
+                bucket_offsets.assign(num_buckets + 1, 0);
+                for (auto id : ids) {
+                    ++bucket_offsets[dnmx_ftable_hash_bucket(id, m_hash_seed, num_buckets) + 1];
+                }
+                for (uint32_t b = 0; b < num_buckets; ++b) {
+                    bucket_offsets[b + 1] += bucket_offsets[b];
+                }
+                bucket_ids.resize(num_ids);
+                {
+                    compat::pmr::vector<uint32_t> fill(bucket_offsets.begin(), bucket_offsets.end() - 1, alloc);
+                    for (auto id : ids) {
+                        bucket_ids[fill[dnmx_ftable_hash_bucket(id, m_hash_seed, num_buckets)]++] = id;
+                    }
+                }
+                auto bucket_size = [&](uint32_t b) { return bucket_offsets[b + 1] - bucket_offsets[b]; };
+
+                buckets_by_size.resize(num_buckets);
+                for (uint32_t b = 0; b < num_buckets; ++b) buckets_by_size[b] = b;
+                std::stable_sort(buckets_by_size.begin(), buckets_by_size.end(), [&](uint32_t a, uint32_t b) {
+                    return bucket_size(a) > bucket_size(b);
+                });
+
+                m_hash_displacements.assign(num_buckets, 0);
+                m_hash_keys.assign(m_hash_length, dnmx_invalid_id);
+                if (place_buckets(buckets_by_size, bucket_offsets, bucket_ids, slots)) return;
+            }
+        }
+
+        bool place_buckets(
+            const compat::pmr::vector<uint32_t>& buckets_by_size,
+            const compat::pmr::vector<uint32_t>& bucket_offsets,
+            const compat::pmr::vector<dnmx_id_int_t>& bucket_ids,
+            compat::pmr::vector<uint32_t>& slots
+        ) {
+            static constexpr uint32_t max_displacement = 1024;
+            for (auto b : buckets_by_size) {
+                const auto begin = bucket_ids.begin() + bucket_offsets[b];
+                const auto end = bucket_ids.begin() + bucket_offsets[b + 1];
+                if (begin == end) break; // the rest are empty
+
+                bool placed = false;
+                for (uint32_t d = 0; d < max_displacement && !placed; ++d) {
+                    slots.clear();
+                    placed = true;
+                    for (auto i = begin; i != end; ++i) {
+                        const auto slot = dnmx_ftable_hash_displaced_slot(*i, d, m_hash_length);
+                        if (m_hash_keys[slot] != dnmx_invalid_id || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                            placed = false;
+                            break;
+                        }
+                        slots.push_back(slot);
+                    }
+                    if (!placed) continue;
+                    for (size_t i = 0; i < slots.size(); ++i) {
+                        m_hash_keys[slots[i]] = begin[i];
+                    }
+                    m_hash_displacements[b] = d;
+                }
+                if (!placed) return false;
+            }
+            return true;
+        }
+
+        uint32_t ftable_length() const noexcept {
+            return m_compact ? m_hash_length : uint32_t(m_num_reachable_pls.size());
+        }
+
         byte_size_t calc_ftable_byte_size() const noexcept {
-            return byte_size_t(m_num_reachable_pls.size() * sizeof(type::ftable_entry) + m_num_total_pls * sizeof(type::ftable_payload));
+            auto ret = byte_size_t(ftable_length() * sizeof(type::ftable_entry) + m_num_total_pls * sizeof(type::ftable_payload));
+            if (m_compact) {
+                // keys and displacements are placed after the payloads
+                // keep the alignment for what comes next in the type buffer
+                ret += byte_size_t(util::next_multiple(
+                    m_hash_keys.size() * sizeof(dnmx_id_int_t) + m_hash_displacements.size() * sizeof(uint32_t),
+                    alignof(type::ftable_payload)));
+            }
+            return ret;
         }
 
         // we need a mutable entry while we build
@@ -606,31 +2549,66 @@ public:
             static_assert(offsetof(mutable_ftable_entry, end) == offsetof(type::ftable_entry, end));
         }
 
-        itlib::span<const type::ftable_entry> build_ftable(byte_t* const ptr) const {
+        // hash is filled for compact ftables
+        itlib::span<const type::ftable_entry> build_ftable(byte_t* const ptr, dnmx_ftable_hash& hash) const {
             std::fill(ptr, ptr + calc_ftable_byte_size(), byte_t{0});
-            itlib::span<mutable_ftable_entry> ftable(reinterpret_cast<mutable_ftable_entry*>(ptr), m_num_reachable_pls.size());
+            itlib::span<mutable_ftable_entry> ftable(reinterpret_cast<mutable_ftable_entry*>(ptr), ftable_length());
             auto ftable_pl_ptr = reinterpret_cast<type::ftable_payload*>(ptr + ftable.size_bytes());
 
+            if (m_compact) {
+                auto keys = reinterpret_cast<dnmx_id_int_t*>(ftable_pl_ptr + m_num_total_pls);
+                std::copy(m_hash_keys.begin(), m_hash_keys.end(), keys);
+                auto displacements = reinterpret_cast<uint32_t*>(keys + m_hash_keys.size());
+                std::copy(m_hash_displacements.begin(), m_hash_displacements.end(), displacements);
+                hash.keys = keys;
+                hash.displacements = displacements;
+                hash.num_buckets = uint32_t(m_hash_displacements.size());
+                hash.seed = m_hash_seed;
+            }
+            else {
+                hash = {nullptr, nullptr, 0, 0};
+            }
+
+            if (m_source) {
+                patch_ftable(ftable, ftable_pl_ptr);
+            }
+            else {
+                fill_ftable(ftable, ftable_pl_ptr);
+            }
+
+            return itlib::span<const type::ftable_entry>(reinterpret_cast<type::ftable_entry*>(ptr), ftable.size());
+        }
+
+        // entry of a feature id in the ftable being built
+        mutable_ftable_entry& entry_for(itlib::span<mutable_ftable_entry> ftable, feature_id::int_t id) const noexcept {
+            if (!m_compact) return ftable[id];
+            const auto bucket = dnmx_ftable_hash_bucket(id, m_hash_seed, uint32_t(m_hash_displacements.size()));
+            const auto slot = dnmx_ftable_hash_displaced_slot(id, m_hash_displacements[bucket], m_hash_length);
+            assert(m_hash_keys[slot] == id);
+            return ftable[slot];
+        }
+
+        void fill_ftable(itlib::span<mutable_ftable_entry> ftable, type::ftable_payload* ftable_pl_ptr) const {
             // third pass
-            // attach begin and end pointers of ftable entries and give them values
+            // attach begin and end pointers of ftable entries
+            // the payloads are laid out in feature id order (as in patch_ftable),
+            // so that equal ftables are equal byte for byte, regardless of how they're built
+            for (feature_id::int_t i = 0; i < m_num_reachable_pls.size(); ++i) {
+                const auto num_reachable = m_num_reachable_pls[i];
+                if (!num_reachable) continue; // not implemented
+
+                auto& entry = entry_for(ftable, i);
+                entry.begin = ftable_pl_ptr;
+                entry.top_bid_back = entry.begin;
+                entry.end = entry.begin;
+                ftable_pl_ptr += num_reachable;
+            }
+
+            // give them values
             for (mixin_index_t i = 0; i < m_mut.mixins.size(); ++i) {
                 const auto* mixin = m_mut.mixins[i];
                 for (auto& feature : mixin->features_span()) {
-                    auto& finfo = *feature.info;
-                    auto& entry = ftable[finfo.iid()];
-                    const auto num_reachable = m_num_reachable_pls[finfo.iid()];
-
-                    // there must be at least one
-                    // after all we're moving through provided features
-                    assert(num_reachable != 0);
-
-                    if (!entry) {
-                        entry.begin = ftable_pl_ptr;
-                        entry.top_bid_back = entry.begin;
-                        entry.end = entry.begin;
-                        ftable_pl_ptr += num_reachable;
-                    }
-
+                    auto& entry = entry_for(ftable, feature.info->iid());
                     entry.end->mixin_index = i;
                     entry.end->payload = feature.payload;
                     entry.end->data = &feature;
@@ -639,54 +2617,134 @@ public:
             }
 
             // fourth and final pass
-            // * sort ranges
-            // * check for clashes
-            // * fix top_bid_back pointers
             for (auto& entry : ftable) {
                 if (!entry) continue; // not implemented
+                finalize_entry(entry);
+            }
+        }
 
-                std::sort(entry.begin, entry.end, [&](const type::ftable_payload& a, const type::ftable_payload& b) {
-                    auto& adata = *a.data;
-                    auto& bdata = *b.data;
+        void patch_ftable(itlib::span<mutable_ftable_entry> ftable, type::ftable_payload* ftable_pl_ptr) const {
+            auto& source = *m_source;
 
-                    // first by bid
-                    if (adata.bid != bdata.bid) return adata.bid > bdata.bid;
+            // copy payloads of remaining mixins from the source
+            for (feature_id::int_t i = 0; i < m_num_reachable_pls.size(); ++i) {
+                const auto num_reachable = m_num_reachable_pls[i];
+                if (!num_reachable) continue; // not implemented
 
-                    // then by prio
-                    if (adata.priority != bdata.priority) return adata.priority < bdata.priority;
+                auto& entry = entry_for(ftable, i);
+                entry.begin = ftable_pl_ptr;
+                entry.top_bid_back = entry.begin;
+                entry.end = entry.begin;
+                ftable_pl_ptr += num_reachable;
 
-                    // then by mixin order such that the last mixin is first
-                    return a.mixin_index > b.mixin_index;
-                });
+                const auto source_entry = source.ftable_at(feature_id{i});
+                if (!source_entry) continue; // only provided by added mixins
 
-                // check for clashes
-                if (!entry.begin->data->info->allow_clashes) {
-                    for (auto ie = entry.begin; ie != entry.end - 1; ++ie) {
-                        const auto& cur = *ie;
-                        const auto& next = *(ie + 1);
-                        if (cur.data->bid == next.data->bid && cur.data->priority == next.data->priority) {
-                            // same bid and prio = clash
-                            throw_exception::feature_clash(m_mut, cur, next);
-                        }
-                    }
+                for (auto pl = source_entry.begin; pl != source_entry.end; ++pl) {
+                    const auto new_index = m_source_to_new[pl->mixin_index];
+                    if (new_index == invalid_mixin_index) continue; // removed
+                    *entry.end = *pl;
+                    entry.end->mixin_index = new_index;
+                    ++entry.end;
+                }
+
+                if (!m_touched[i]) {
+                    // same payloads in the same order
+                    entry.top_bid_back = entry.begin + (source_entry.top_bid_back - source_entry.begin);
+                }
+            }
+
+            // add payloads of added mixins
+            for (mixin_index_t i = 0; i < m_mut.mixins.size(); ++i) {
+                const auto* mixin = m_mut.mixins[i];
+                if (source.has(mixin->id)) continue;
+                for (auto& feature : mixin->features_span()) {
+                    auto& entry = entry_for(ftable, feature.info->iid());
+                    entry.end->mixin_index = i;
+                    entry.end->payload = feature.payload;
+                    entry.end->data = &feature;
+                    ++entry.end;
                 }
+            }
+
+            for (feature_id::int_t i = 0; i < m_num_reachable_pls.size(); ++i) {
+                if (!m_num_reachable_pls[i] || !m_touched[i]) continue;
+                finalize_entry(entry_for(ftable, i));
+            }
+        }
+
+        // * sort range
+        // * check for clashes
+        // * fix top_bid_back pointer
+        void finalize_entry(mutable_ftable_entry& entry) const {
+            std::sort(entry.begin, entry.end, [&](const type::ftable_payload& a, const type::ftable_payload& b) {
+                auto& adata = *a.data;
+                auto& bdata = *b.data;
+
+                // first by bid
+                if (adata.bid != bdata.bid) return adata.bid > bdata.bid;
+
+                // then by prio
+                if (adata.priority != bdata.priority) return adata.priority < bdata.priority;
+
+                // then by mixin order such that the last mixin is first
+                return a.mixin_index > b.mixin_index;
+            });
 
-                // set top_bid_back pointer (currently pointing to begin)
-                for (auto pl = entry.begin + 1; pl != entry.end; ++pl) {
-                    if (pl->data->bid != entry.top_bid_back->data->bid) {
-                        // top bid end reached
-                        break;
+            // check for clashes
+            if (!entry.begin->data->info->allow_clashes) {
+                for (auto ie = entry.begin; ie != entry.end - 1; ++ie) {
+                    const auto& cur = *ie;
+                    const auto& next = *(ie + 1);
+                    if (cur.data->bid == next.data->bid && cur.data->priority == next.data->priority) {
+                        // same bid and prio = clash
+                        throw_exception::feature_clash(m_mut, cur, next);
                     }
-                    entry.top_bid_back = pl;
                 }
             }
 
-            return itlib::span<const type::ftable_entry>(reinterpret_cast<type::ftable_entry*>(ptr), m_num_reachable_pls.size());
+            // set top_bid_back pointer (currently pointing to begin)
+            for (auto pl = entry.begin + 1; pl != entry.end; ++pl) {
+                if (pl->data->bid != entry.top_bid_back->data->bid) {
+                    // top bid end reached
+                    break;
+                }
+                entry.top_bid_back = pl;
+            }
         }
     };
 
     // create type for a given mutation requested by a given query
-    const type& create_type(type_mutation& mutation, type_query&& query) {
+    // new_type can be provided if it's already built
+    // keep is a type which the caller uses and which must not be collected by an automatic collection
+    const type& create_type(type_mutation& mutation, mixin_info_span& query, size_t query_hash, uptr<type> new_type = {}, const type* keep = nullptr) {
+        if (!new_type) {
+            new_type = build_type(mutation);
+        }
+
+        // finally add new type to types and return it
+        auto reg = lock_types_unique();
+        auto_collect_types_l(*reg, keep);
+        const type* reg_type = insert_type_l(*reg, std::move(new_type));
+        hand_out(*reg_type);
+
+        // note that the type may already be added
+        // concurrent get_type calls for the same type are single-flight, so this is rare
+        // (the other builder may have been one of prewarm_types, or the type of a wait could have been collected)
+        // in such a case we give up on our own
+        // in any case we can just register the query with the type in the set
+        // (the query may also be the same as the one from the previous thread,
+        // but the code below is safe in such a case)
+
+        store_query_l(*reg, query, query_hash, reg_type);
+        return *reg_type;
+    }
+
+    // build a new type for a given mutation (with applied rules)
+    // doesn't touch the registry, so it's safe to call without locking
+    // if source is provided, its ftable is used to derive the new one
+    // (the caller must make sure it's alive until the function returns)
+    uptr<type> build_type(type_mutation& mutation, const type* source = nullptr) {
         mixin_info_span mixins(mutation.mixins);
 
         // first check validity
@@ -699,6 +2757,9 @@ public:
             }
         }
 
+        event_scope created(*this, dnmx_domain_event_type_created);
+        created.set_mixins(mixins);
+
         // so, we need to create a new obj type...
 
         // we allocate a single buffer in the type
@@ -706,11 +2767,12 @@ public:
         // to avoid manually fixing the alignment, we check here that the alignments are in a non-increasing order
         // (ie they will be fixed by the compiler)
         static_assert(std::is_trivially_destructible_v<type>);
-        static_assert(alignof(type) >= alignof(typename type::ftable_entry), "fix type buffer");
-        static_assert(alignof(typename type::ftable_entry) >= alignof(typename type::ftable_payload), "fix type buffer");
-        static_assert(alignof(typename type::ftable_payload) >= alignof(void*), "fix type buffer");
-        static_assert(alignof(void*) >= alignof(uint32_t), "fix type buffer");
-        static_assert(alignof(uint32_t) >= alignof(mixin_index_t), "fix type buffer");
+        static_assert(alignof(type) >= alignof(uint64_t), "fix type buffer");
+        static_assert(alignof(uint64_t) >= alignof(void*), "fix type buffer");
+        static_assert(alignof(void*) >= alignof(type::mixin_link), "fix type buffer");
+        static_assert(alignof(type::mixin_link) >= alignof(uint32_t), "fix type buffer");
+        static_assert(alignof(uint32_t) >= alignof(type::name_entry), "fix type buffer");
+        static_assert(alignof(type::name_entry) >= alignof(mixin_index_t), "fix type buffer");
         static_assert(std::is_trivial_v<type::ftable_entry>, "fix type buffer");
 
         // prepare single buffer for type
@@ -718,43 +2780,96 @@ public:
         // calc buf components
         const byte_size_t type_size = sizeof(type);
 
-        const ftable_build_helper ftable_helper(mutation);
-        const byte_size_t ftable_size = ftable_helper.calc_ftable_byte_size();
+        const auto max_mixin_id = (*std::max_element(mixins.begin(), mixins.end(), [](const mixin_info* a, const mixin_info* b) {
+            return a->iid() < b->iid();
+        }))->iid();
+
+        const uint32_t num_id_words = max_mixin_id / 64 + 1;
+        const byte_size_t mixin_id_bits_buf_size = num_id_words * sizeof(uint64_t);
+
+        const ftable_build_helper ftable_helper(mutation, source);
 
         const byte_size_t mixins_buf_size = byte_size_t(mixins.size_bytes());
 
+        const byte_size_t mixin_links_buf_size = byte_size_t(mixins.size() * sizeof(type::mixin_link));
+
         const byte_size_t mixin_offsets_buf_size = byte_size_t(mixins.size() * sizeof(uint32_t));
 
-        const auto num_sparse = /*iile*/[&]() {
-            auto max_by_id = std::max_element(mixins.begin(), mixins.end(), [](const mixin_info* a, const mixin_info* b) {
-                return a->iid() < b->iid();
-            });
-            return (*max_by_id)->iid() + 1;
+        // names of mixins and features (features of different mixins may repeat, so this is an upper bound)
+        const uint32_t num_names = [&]() {
+            size_t ret = mixins.size();
+            for (auto m : mixins) ret += m->features_span().size();
+            uint32_t capacity = 1;
+            while (capacity < ret * 2) capacity *= 2;
+            return capacity;
         }();
+        const byte_size_t names_buf_size = num_names * sizeof(type::name_entry);
+
+        // compact types find mixin indices through mixin_id_bits instead (see type::compact_index_of)
+        const bool compact = m_domain.settings().compact_types;
+        const auto num_sparse = compact ? 0 : max_mixin_id + 1;
         const byte_size_t sparse_mixin_indices_buf_size = num_sparse * sizeof(mixin_index_t);
+        const byte_size_t id_word_ranks_buf_size = compact ? num_id_words * sizeof(uint32_t) : 0;
+        const byte_size_t rank_mixin_indices_buf_size = compact ? byte_size_t(mixins.size() * sizeof(mixin_index_t)) : 0;
 
         //const byte_size_t type_classes_buf_size = byte_size_t(m_domain.m_type_classes.size() * sizeof(bool));
 
         // alloc and fill buf
         const byte_size_t total_obj_type_buf_size =
             type_size
-            + ftable_size
+            + mixin_id_bits_buf_size
             + mixins_buf_size
+            + mixin_links_buf_size
             + mixin_offsets_buf_size
-            + sparse_mixin_indices_buf_size;
+            + names_buf_size
+            + sparse_mixin_indices_buf_size
+            + id_word_ranks_buf_size
+            + rank_mixin_indices_buf_size;
 
         auto new_type_bytes = reinterpret_cast<byte_t*>(m_allocator.allocate_bytes(
             total_obj_type_buf_size,
             alignof(type)
         ));
+        count(&stats_counters::type_bytes_allocated, total_obj_type_buf_size);
         uptr<type> new_type(new (new_type_bytes) type(m_domain, total_obj_type_buf_size));
         auto* bptr = new_type_bytes + sizeof(type);
 
+        new_type->mixins_hash = mixin_span_hash(mixins);
+        new_type->serial = next_type_serial();
+
+        // mixin id bits
+        itlib::span mixin_id_bits(reinterpret_cast<uint64_t*>(bptr), num_id_words);
+        bptr += mixin_id_bits_buf_size;
+        std::fill(mixin_id_bits.begin(), mixin_id_bits.end(), uint64_t(0));
+        for (auto m : mixins) {
+            mixin_id_bits[m->iid() / 64] |= uint64_t(1) << (m->iid() % 64);
+        }
+        new_type->mixin_id_bits = mixin_id_bits;
+
         // ftable
-        auto ftable = ftable_helper.build_ftable(bptr);
-        bptr += ftable_size;
-        new_type->ftable = ftable.data();
-        new_type->ftable_length = uint32_t(ftable.size());
+        // it's in a separate buffer (see ftable_block) which is interned when the type is added to the registry
+        itlib::span<const type::ftable_entry> ftable;
+        if (ftable_helper.ftable_length()) {
+            static_assert(alignof(ftable_block) >= alignof(typename type::ftable_entry), "fix ftable block");
+            static_assert(alignof(typename type::ftable_entry) >= alignof(typename type::ftable_payload), "fix ftable block");
+            static_assert(alignof(typename type::ftable_payload) >= alignof(dnmx_id_int_t), "fix ftable block");
+            static_assert(alignof(dnmx_id_int_t) >= alignof(uint32_t), "fix ftable block");
+
+            const byte_size_t block_size = byte_size_t(sizeof(ftable_block) + ftable_helper.calc_ftable_byte_size());
+            auto block = new (m_allocator.allocate_bytes(block_size, alignof(ftable_block))) ftable_block{};
+            count(&stats_counters::type_bytes_allocated, block_size);
+            block->buf_size = block_size;
+            new_type->ftable = block->entries(); // the type owns the block from here on
+
+            auto block_data = reinterpret_cast<byte_t*>(block + 1);
+            ftable = ftable_helper.build_ftable(block_data, block->ftable_hash);
+            block->length = uint32_t(ftable.size());
+            block->num_payloads = ftable_helper.m_num_total_pls;
+            block->calc_content_hash();
+
+            new_type->ftable_length = block->length;
+            new_type->ftable_hash = block->ftable_hash;
+        }
 
         // mixins
         itlib::span new_type_mixins(reinterpret_cast<const mixin_info**>(bptr), mixins.size());
@@ -762,6 +2877,12 @@ public:
         std::copy(mixins.begin(), mixins.end(), new_type_mixins.begin());
         new_type->mixins = new_type_mixins;
 
+        // mixin links (they're filled when the type is added to the registry)
+        itlib::span mixin_links(reinterpret_cast<type::mixin_link*>(bptr), mixins.size());
+        bptr += mixin_links_buf_size;
+        std::fill(mixin_links.begin(), mixin_links.end(), type::mixin_link{nullptr, nullptr});
+        new_type->m_mixin_links = mixin_links;
+
         // object buffer data
 
         // the single buffer is structured as follows
@@ -805,70 +2926,389 @@ public:
         new_type->object_buffer_size = obj_buf_size;
         new_type->object_buffer_alignment = obj_buf_alignment;
 
+        // name index
+        itlib::span names(reinterpret_cast<type::name_entry*>(bptr), num_names);
+        bptr += names_buf_size;
+        std::fill(names.begin(), names.end(), type::name_entry{0, type::empty_name_entry});
+        new_type->m_names = names;
+        auto add_name = [&](const dnmx_sv& name, uint32_t value, uint32_t kind) {
+            const auto hash = name_hash(name.to_std());
+            const uint32_t mask = num_names - 1;
+            for (uint32_t i = uint32_t(hash) & mask; ; i = (i + 1) & mask) {
+                auto& e = names[i];
+                if (e.value == type::empty_name_entry) {
+                    e = {uint32_t(hash), value | kind};
+                    return;
+                }
+                if (e.hash != uint32_t(hash) || (e.value & type::feature_name_flag) != kind) continue;
+                const auto v = e.value & ~type::feature_name_flag;
+                const auto& entry_name = kind ? ftable[v].begin->data->info->name : mixins[v]->name;
+                if (entry_name == name) return; // with duplicate names only the first one is indexed
+            }
+        };
+        for (uint32_t i = 0; i < mixins.size(); ++i) {
+            add_name(mixins[i]->name, i, 0);
+        }
+        for (uint32_t i = 0; i < ftable.size(); ++i) {
+            if (!ftable[i]) continue;
+            add_name(ftable[i].begin->data->info->name, i, type::feature_name_flag);
+        }
+
         // sparse indices
         itlib::span sparse_mixin_indices(reinterpret_cast<mixin_index_t*>(bptr), num_sparse);
         bptr += sparse_mixin_indices_buf_size;
         std::fill(sparse_mixin_indices.begin(), sparse_mixin_indices.end(), invalid_mixin_index);
-        for (mixin_index_t i = 0; i < mixins.size(); ++i) {
+        for (mixin_index_t i = 0; i < mixins.size() && num_sparse; ++i) {
             sparse_mixin_indices[mixins[i]->iid()] = i;
         }
         new_type->sparse_mixin_indices = sparse_mixin_indices;
 
-        // finally add new type to types and return it
-        auto reg = m_type_registry.unique_lock();
-        auto res = reg->types.emplace(std::move(new_type));
+        // compact indices
+        itlib::span id_word_ranks(reinterpret_cast<uint32_t*>(bptr), id_word_ranks_buf_size / sizeof(uint32_t));
+        bptr += id_word_ranks_buf_size;
+        uint32_t rank = 0;
+        for (uint32_t w = 0; w < id_word_ranks.size(); ++w) {
+            id_word_ranks[w] = rank;
+            rank += bits::popcount(mixin_id_bits[w]);
+        }
+        new_type->m_id_word_ranks = id_word_ranks;
+        itlib::span rank_mixin_indices(reinterpret_cast<mixin_index_t*>(bptr), rank_mixin_indices_buf_size / sizeof(mixin_index_t));
+        bptr += rank_mixin_indices_buf_size;
+        for (mixin_index_t i = 0; i < rank_mixin_indices.size(); ++i) {
+            const auto id = mixins[i]->iid();
+            const auto word_bits = mixin_id_bits[id / 64];
+            rank_mixin_indices[id_word_ranks[id / 64] + bits::popcount(word_bits & ((uint64_t(1) << (id % 64)) - 1))] = i;
+        }
+        new_type->m_rank_mixin_indices = rank_mixin_indices;
 
-        // note that the type may already be added
-        // could be more than one thread waited at the mutex above for the exact same type
-        // in which case we give up on our own
-        // it may seem like a waste to have more than one thread create the exact same type
-        // before waiting on the unique_lock
-        // it may seem to be a good idea to lock earlier, but this should be very very rare
-        // we're willing to risk dropping materialized types every once in a blue moon
-        // for the benefit of holding the unique_lock for as short amount of time as possible
-        // in any case we can disregard res.second and just register the query
-        // (the query may also be the same as the one from the previous thread,
-        // but the code below is safe in such a case)
+        created.e.type_handle = new_type.get();
+        return new_type;
+    }
 
-        const type* reg_type = res.first->get();
-        reg->type_queries[std::move(query)] = reg_type;
-        return *reg_type;
+    struct prewarmed_type {
+        prewarmed_type(const allocator& alloc) : query(alloc), mixins(alloc) {}
+        type_query query; // original query to store
+        size_t query_hash = 0;
+        bool stored = false; // query is already stored
+        type_query mixins; // mixins of the type (after applying rules)
+        size_t mixins_hash = 0;
+        uptr<type> built; // new type (if no such type existed)
+        std::exception_ptr error;
+    };
+
+    void prewarm_type(mixin_info_span& query, prewarmed_type& p) noexcept {
+        p.query_hash = mixin_span_hash(query);
+        if (find_query_lock_free(query, p.query_hash)) {
+            count(&stats_counters::type_query_hits);
+            p.stored = true;
+            return;
+        }
+        count(&stats_counters::type_query_misses);
+
+        try {
+            // same as get_type, but instead of creating the type, we only build it
+            type_mutation mutation(m_domain, m_allocator);
+            mutation.mixins.assign(query.begin(), query.end());
+            const type* found = nullptr;
+            {
+                auto reg = lock_types_shared();
+                if (!apply_mutation_rules_l(mutation, *reg, p.query)) {
+                    p.query.assign(mutation.mixins.begin(), mutation.mixins.end());
+                }
+                p.mixins_hash = mixin_span_hash(mutation.mixins);
+                if (!mutation.mixins.empty()) {
+                    found = reg->types.find(mutation.mixins, p.mixins_hash);
+                }
+            }
+            if (!found && !mutation.mixins.empty()) {
+                p.built = build_type(mutation);
+            }
+            p.mixins.assign(mutation.mixins.begin(), mutation.mixins.end());
+        }
+        catch (...) {
+            p.error = std::current_exception();
+        }
+    }
+
+    void prewarm_types(itlib::span<const itlib::span<const mixin_info* const>> queries, const domain::prewarm_executor& executor) {
+        compat::pmr::vector<prewarmed_type> prewarmed(m_allocator);
+        prewarmed.reserve(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            prewarmed.emplace_back(m_allocator);
+        }
+
+        // apply rules and build types in parallel
+        // they only take shared locks (if any)
+        auto job = [&](size_t i) {
+            mixin_info_span query = queries[i];
+            prewarm_type(query, prewarmed[i]);
+        };
+
+        if (executor) {
+            executor(queries.size(), job);
+        }
+        else {
+            const size_t num_threads = std::min(queries.size(), size_t(std::max(1u, std::thread::hardware_concurrency())));
+            std::atomic<size_t> next = 0;
+            auto work = [&]() {
+                for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < queries.size(); ) {
+                    job(i);
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < num_threads; ++i) {
+                workers.emplace_back(work);
+            }
+            work(); // this thread is a worker, too
+            for (auto& w : workers) {
+                w.join();
+            }
+        }
+
+        for (auto& p : prewarmed) {
+            if (p.error) std::rethrow_exception(p.error); // built types are dropped
+        }
+
+        // add all to the registry at once
+        // types are looked up again as the registry may have changed while we were building
+        // as in create_type, some types may have been added by other threads in the meantime
+        // in which case ours are dropped
+        auto reg = lock_types_unique();
+        for (auto& p : prewarmed) {
+            if (p.stored) continue;
+            const type* t = nullptr;
+            if (p.mixins.empty()) t = &m_empty_type;
+            else t = reg->types.find(p.mixins, p.mixins_hash);
+            if (!t) {
+                // existing type could have been collected in the meantime
+                // in such a case we just skip it (it will be created when requested)
+                if (!p.built) continue;
+                t = insert_type_l(*reg, std::move(p.built));
+            }
+            else if (p.built) {
+                count(&stats_counters::types_discarded);
+            }
+            store_query_l(*reg, p.query, p.query_hash, t);
+        }
+    }
+
+    void restore_types(itlib::span<const itlib::span<const mixin_info* const>> types, itlib::span<const domain::restored_query> queries) {
+        // build all types before locking
+        compat::pmr::vector<uptr<type>> built(m_allocator);
+        built.reserve(types.size());
+        for (auto& mixins : types) {
+            if (mixins.empty()) {
+                built.emplace_back(); // empty type
+                continue;
+            }
+            type_mutation mutation(m_domain, m_allocator);
+            mutation.mixins.assign(mixins.begin(), mixins.end());
+            built.push_back(build_type(mutation));
+        }
+
+        auto reg = lock_types_unique();
+        compat::pmr::vector<const type*> reg_types(m_allocator);
+        reg_types.reserve(built.size());
+        for (auto& t : built) {
+            if (t) reg_types.push_back(insert_type_l(*reg, std::move(t)));
+            else reg_types.push_back(&m_empty_type);
+        }
+        for (auto& q : queries) {
+            assert(q.type_index < reg_types.size());
+            store_query_l(*reg, q.query, mixin_span_hash(q.query), reg_types[q.type_index]);
+        }
+
+        // restored queries may replace existing ones which lead elsewhere
+        invalidate_edges_l();
+    }
+
+    // a type chosen for collection with its number of hand-outs at the time
+    struct dead_type {
+        const type* t;
+        uint32_t hand_outs;
+    };
+
+    static uint32_t hand_outs_of(const type& t) noexcept {
+        return uint32_t(t.m_hand_outs.load(std::memory_order_acquire) / type::hand_out_count);
+    }
+
+    // check whether a type can be collected now, updating the time since which it's unused
+    // automatic collections also skip types which are pinned by hand-outs
+    bool can_collect_l(const type& t, int64_t now, bool automatic, dead_type& dead) const noexcept {
+        // hand-outs first: an object which releases a pin is counted before it
+        const auto h = t.m_hand_outs.load(std::memory_order_acquire);
+        dead = {&t, uint32_t(h / type::hand_out_count)};
+        if (t.num_objects() != 0) {
+            t.m_unused_since.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        if (t.m_refs.load(std::memory_order_relaxed)) return false;
+        if (automatic && (h & type::hand_out_pins_mask)) return false;
+        auto since = t.m_unused_since.load(std::memory_order_relaxed);
+        if (since == 0) {
+            since = now;
+            t.m_unused_since.store(now, std::memory_order_relaxed);
+        }
+        return now - since >= int64_t(m_gc_policy.min_unused_time.count());
     }
 
-    void garbage_collect_types() noexcept {
-        auto l = m_type_registry.unique_lock();
-        auto& types = l->types;
-        auto& queries = l->type_queries;
-        for (auto it = types.begin(); it != types.end(); ) {
-            auto& t = *it;
-            if (t->num_objects() > 0) {
-                // objects of this type still exist
-                ++it;
+    // erase dead types along with the queries which lead to them and free them
+    // other_queries are additional queries to erase (they must not lead to dead types)
+    // with revive, types which were handed out while being collected survive (only their queries are erased)
+    // without it (when the mixins of the types are unregistered), the types are freed regardless
+    // returns the number of freed types
+    size_t collect_l(type_registry& reg, itlib::span<const dead_type> dead, itlib::span<const type_query_node* const> other_queries = {}, bool revive = false) noexcept {
+        if (dead.empty() && other_queries.empty()) return 0;
+
+        // erase the queries first, so that lock-free lookups can't find the types
+        // they are found through the reverse index and replaced with tombstones in place
+        auto table = m_type_queries.load(std::memory_order_relaxed);
+        for (auto& d : dead) {
+            for (auto node = first_query(*d.t); node; node = node->next_for_type) {
+                tombstone_query_l(*table, *node);
+                unindex_query_l(reg, *node);
+            }
+        }
+        for (auto node : other_queries) {
+            tombstone_query_l(*table, *node);
+            unindex_query_l(reg, *node);
+            unlink_query_l(*node);
+        }
+        invalidate_edges_l(); // edges may lead to dead types
+
+        // wait for readers which may have found the nodes or followed the edges
+        // after this their hand-outs of the dead types are visible
+        m_type_queries_epoch.synchronize();
+
+        size_t num_freed = 0;
+        for (auto& d : dead) {
+            auto t = d.t;
+            for (auto node = first_query(*t); node; ) {
+                auto next = node->next_for_type;
+                free_query_node(node);
+                node = next;
+            }
+            t->m_queries = nullptr;
+            if (revive && (hand_outs_of(*t) != d.hand_outs || t->num_objects() != 0)) {
+                // a reader got it in the meantime
                 continue;
             }
 
-            // erase queries which lead to this type
-            for (auto iq = queries.begin(); iq != queries.end(); ) {
-                if (iq->second == it->get()) {
-                    iq = queries.erase(iq);
+            // the types which are chosen by collections aren't referenced, but the ones with unregistered mixins may be
+            // references are only taken briefly (while building a type), so we can wait for them
+            while (t->m_refs.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            reg.types.erase(t);
+            reg.ftables.release(*t);
+            deleter{}(t);
+            ++num_freed;
+        }
+        for (auto node : other_queries) {
+            free_query_node(node);
+        }
+        return num_freed;
+    }
+
+    // collect unused types examining at most budget types (all if zero)
+    // keep is a type which must not be collected (can be null)
+    // automatic collections skip pinned types
+    size_t collect_types_l(type_registry& reg, uint32_t budget, const type* keep, bool automatic) noexcept {
+        event_scope gc(*this, dnmx_domain_event_gc);
+        const auto now = gc_now();
+        m_gc_last_step = now;
+
+        compat::pmr::vector<dead_type> dead(m_allocator);
+        reg.types.scan(m_gc_cursor, budget, [&](const type& t) {
+            dead_type d;
+            if (&t != keep && can_collect_l(t, now, automatic, d)) dead.push_back(d);
+        });
+        auto num_freed = collect_l(reg, dead, {}, true);
+        count(&stats_counters::gc_runs);
+        count(&stats_counters::types_collected, num_freed);
+        gc.e.count = uint32_t(num_freed);
+        return num_freed;
+    }
+
+    // automatic collection which happens when new types are created
+    void auto_collect_types_l(type_registry& reg, const type* keep) noexcept {
+        auto& p = m_gc_policy;
+        if (p.memory_threshold && reg.types_bytes() > p.memory_threshold) {
+            collect_types_l(reg, p.step_budget, keep, true);
+        }
+        else if (p.idle_interval.count() && gc_now() - m_gc_last_step >= int64_t(p.idle_interval.count())) {
+            collect_types_l(reg, p.step_budget, keep, true);
+        }
+    }
+
+    void on_type_unused(const type* t, size_t hash) noexcept {
+        if (!m_gc_on_zero_objects.load(std::memory_order_relaxed)) return;
+
+        auto reg = lock_types_unique();
+        const auto now = gc_now();
+
+        compat::pmr::vector<dead_type> dead(m_allocator);
+        dead_type d;
+
+        // check the pending types first
+        // the ones which were collected by other means, got objects, or were pinned in the meantime are dropped
+        // (pinned types become unused again after their objects are destroyed)
+        auto pending_end = std::remove_if(m_gc_pending.begin(), m_gc_pending.end(), [&](const std::pair<const type*, size_t>& p) {
+            if (p.first == t) return true; // checked below
+            if (!reg->types.contains(p.first, p.second)) return true;
+            if (p.first->num_objects() != 0) return true;
+            if (can_collect_l(*p.first, now, true, d)) {
+                dead.push_back(d);
+                return true;
+            }
+            return !!(p.first->m_hand_outs.load(std::memory_order_relaxed) & type::hand_out_pins_mask);
+        });
+        m_gc_pending.erase(pending_end, m_gc_pending.end());
+
+        // another thread may have collected the type already
+        if (reg->types.contains(t, hash)) {
+            if (can_collect_l(*t, now, true, d)) {
+                dead.push_back(d);
+            }
+            else if (t->num_objects() == 0 && !(t->m_hand_outs.load(std::memory_order_relaxed) & type::hand_out_pins_mask)) {
+                try {
+                    m_gc_pending.emplace_back(t, hash);
                 }
-                else {
-                    ++iq;
+                catch (...) {
+                    // the type will just be left for explicit collections
                 }
             }
-            it = types.erase(it);
         }
+
+        if (dead.empty()) return;
+        event_scope gc(*this, dnmx_domain_event_gc);
+        auto num_freed = collect_l(*reg, dead, {}, true);
+        gc.e.count = uint32_t(num_freed);
+        count(&stats_counters::gc_runs);
+        count(&stats_counters::types_collected, num_freed);
+    }
+
+    size_t garbage_collect_types(uint32_t budget) noexcept {
+        auto l = lock_types_unique();
+        return collect_types_l(*l, budget, nullptr, false);
+    }
+
+    void set_type_gc_policy(const type_gc_policy& policy) noexcept {
+        auto l = lock_types_unique();
+        m_gc_policy = policy;
+        m_gc_on_zero_objects.store(policy.on_zero_objects, std::memory_order_relaxed);
     }
 };
 
 struct domain_traverse::impl {
-    data_mutex<domain::impl::type_registry>::shared_lock_t tr;
+    const domain::impl& dom;
+    domain::impl::type_registry_shared_lock tr;
     data_mutex<domain::impl::element_registry>::shared_lock_t er;
 };
 
 domain_traverse::domain_traverse(const domain& d) noexcept {
     m_impl = new impl{
-        d.m_impl->m_type_registry.shared_lock(),
+        *d.m_impl,
+        d.m_impl->lock_types_shared(),
         d.m_impl->m_element_registry.shared_lock()
     };
 }
@@ -877,13 +3317,15 @@ domain_traverse::~domain_traverse() {
 }
 
 void domain_traverse::traverse_mixins(std::function<void(const mixin_info&)> func) const {
-    for (auto* m : m_impl->er->sparse_mixins) {
-        if (m) func(*m);
+    auto& sparse = m_impl->dom.m_sparse_mixins;
+    for (uint32_t i = 0; i < sparse.size(); ++i) {
+        if (auto m = sparse[i]) func(*m);
     }
 }
 void domain_traverse::traverse_features(std::function<void(const feature_info&)> func) const {
-    for (auto* f : m_impl->er->sparse_features) {
-        if (f) func(*f);
+    auto& sparse = m_impl->dom.m_sparse_features;
+    for (uint32_t i = 0; i < sparse.size(); ++i) {
+        if (auto f = sparse[i]) func(*f);
     }
 }
 void domain_traverse::traverse_mutation_rules(std::function<void(const mutation_rule_info&, uint32_t)> func) const {
@@ -892,18 +3334,20 @@ void domain_traverse::traverse_mutation_rules(std::function<void(const mutation_
     }
 }
 void domain_traverse::traverse_type_classes(std::function<void(const type_class&)> func) const {
-    for (auto* tc : m_impl->er->sparse_type_classes) {
-        if (tc) func(*tc);
+    auto& sparse = m_impl->dom.m_sparse_type_classes;
+    for (uint32_t i = 0; i < sparse.size(); ++i) {
+        if (auto tc = sparse[i]) func(*tc);
     }
 }
 void domain_traverse::traverse_types(std::function<void(const type&)> func) const {
-    for (auto& t : m_impl->tr->types) {
-        func(*t);
-    }
+    m_impl->tr->types.for_each(func);
 }
 void domain_traverse::traverse_type_queries(std::function<void(itlib::span<const mixin_info* const>, const type&)> func) const {
-    for (auto& tc : m_impl->tr->type_queries) {
-        func(tc.first, *tc.second);
+    // we hold the shared lock, so no writers can change the queries
+    if (auto table = m_impl->dom.m_type_queries.load(std::memory_order_relaxed)) {
+        table->for_each([&](const domain::impl::type_query_node& node) {
+            func(node.query, *node.t);
+        });
     }
 }
 
@@ -923,7 +3367,16 @@ void domain::register_mixin(mixin_info& info) {
 
 
 void domain::unregister_mixin(mixin_info& info) {
-    m_impl->unregister_mixin(info);
+    mixin_info* infos[] = {&info};
+    m_impl->unregister_mixins(infos);
+}
+
+void domain::unregister_mixins(itlib::span<mixin_info* const> infos) {
+    m_impl->unregister_mixins(infos);
+}
+
+void domain::register_mixins(itlib::span<mixin_info* const> infos) {
+    m_impl->register_mixins(infos);
 }
 
 const mixin_info* domain::get_mixin_info(mixin_id id) noexcept {
@@ -942,6 +3395,10 @@ void domain::unregister_feature(feature_info& info) {
     m_impl->unregister_feature(info);
 }
 
+void domain::register_features(itlib::span<feature_info* const> infos) {
+    m_impl->register_features(infos);
+}
+
 const feature_info* domain::get_feature_info(feature_id id) noexcept {
     return m_impl->get_feature_info(id);
 }
@@ -950,11 +3407,11 @@ const feature_info* domain::get_feature_info(std::string_view name) noexcept {
     return m_impl->get_feature_info(name);
 }
 
-void domain::register_type_class(const type_class& tc) {
+void domain::register_type_class(type_class& tc) {
     m_impl->register_type_class(tc);
 }
 
-void domain::unregister_type_class(const type_class& tc) {
+void domain::unregister_type_class(type_class& tc) {
     m_impl->unregister_type_class(tc);
 }
 
@@ -962,6 +3419,18 @@ const type_class* domain::get_type_class(std::string_view name) noexcept {
     return m_impl->get_type_class(name);
 }
 
+void domain::for_each_type_of(const type_class& tc, const std::function<void(const type&)>& func) {
+    m_impl->for_each_type_of(tc, func);
+}
+
+bool domain::type_is_of(const type& t, const type_class& tc) noexcept {
+    return m_impl->type_is_of(t, tc);
+}
+
+bool domain::type_is_of(const type& t, std::string_view tc_name, bool& result) noexcept {
+    return m_impl->type_is_of(t, tc_name, result);
+}
+
 void domain::add_mutation_rule(const mutation_rule_info& info) {
     m_impl->add_mutation_rule(info);
 }
@@ -977,6 +3446,22 @@ const type& domain::get_type(itlib::span<const mixin_info* const> mixins) {
     return m_impl->get_type(mixins);
 }
 
+void domain::prewarm_types(itlib::span<const itlib::span<const mixin_info* const>> queries, const prewarm_executor& executor) {
+    m_impl->prewarm_types(queries, executor);
+}
+
+void domain::restore_types(itlib::span<const itlib::span<const mixin_info* const>> types, itlib::span<const restored_query> queries) {
+    m_impl->restore_types(types, queries);
+}
+
+const type& domain::get_type_with(const type& base, const mixin_info& mixin) {
+    return m_impl->get_type_with(base, mixin);
+}
+
+const type& domain::get_type_without(const type& base, const mixin_info& mixin) {
+    return m_impl->get_type_without(base, mixin);
+}
+
 allocator domain::get_allocator() const noexcept {
     return m_impl->m_allocator;
 }
@@ -986,20 +3471,54 @@ const type& domain::get_empty_type() const noexcept {
 }
 
 size_t domain::num_types() const noexcept {
-    return m_impl->m_type_registry.shared_lock()->types.size();
+    return m_impl->lock_types_shared()->types.size();
+}
+
+domain_stats domain::stats() const noexcept {
+    return m_impl->get_stats();
+}
+
+void domain::set_listener(const domain_listener* listener) noexcept {
+    m_impl->set_listener(listener);
+}
+
+size_t domain::num_avoided_type_builds() const noexcept {
+    return size_t(m_impl->get_count(&domain::impl::stats_counters::type_builds_avoided));
 }
 
 // performs garbage collection removing object types with zero objects
 void domain::garbage_collect_types() noexcept {
-    return m_impl->garbage_collect_types();
+    m_impl->garbage_collect_types(0);
+}
+
+size_t domain::garbage_collect_types_step(uint32_t budget) noexcept {
+    return m_impl->garbage_collect_types(budget);
+}
+
+void domain::set_type_gc_policy(const type_gc_policy& policy) noexcept {
+    m_impl->set_type_gc_policy(policy);
+}
+
+type_gc_policy domain::get_type_gc_policy() const noexcept {
+    auto l = m_impl->lock_types_shared();
+    return m_impl->m_gc_policy;
+}
+
+size_t domain::types_memory() const noexcept {
+    return m_impl->lock_types_shared()->types_bytes();
+}
+
+void domain::on_type_unused(const type* t, size_t mixins_hash) noexcept {
+    m_impl->on_type_unused(t, mixins_hash);
 }
 
 size_t domain::num_type_queries() const noexcept {
-    return m_impl->m_type_registry.shared_lock()->type_queries.size();
+    auto l = m_impl->lock_types_shared();
+    return m_impl->num_type_queries_l();
 }
 
 size_t domain::num_mutation_rules() const noexcept {
-    return m_impl->m_type_registry.shared_lock()->mutation_rules.size();
+    return m_impl->lock_types_shared()->mutation_rules.size();
 }
 
 }
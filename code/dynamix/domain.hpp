@@ -7,6 +7,8 @@
 #include "../dnmx/basic_domain.h"
 
 #include "domain_settings.hpp"
+#include "domain_stats.hpp"
+#include "domain_listener.hpp"
 #include "feature_info_fwd.hpp"
 
 #include "feature_id.hpp"
@@ -14,12 +16,14 @@
 #include "mixin_info_fwd.hpp"
 #include "mutation_rule_info_fwd.hpp"
 #include "type_class.hpp"
+#include "type_gc_policy.hpp"
 
 #include "allocator.hpp"
 
 #include <itlib/span.hpp>
 
 #include <string_view>
+#include <functional>
 
 namespace dynamix {
 
@@ -52,6 +56,12 @@ public:
     void register_feature(feature_info& info); // explicitly registering features is optional
     void register_mixin(mixin_info& info); // also register mixin's features
 
+    // register many infos at once under a single lock
+    // unlike the single registrators, these are atomic: if any info fails to register, nothing is registered
+    // register_mixins also registers the mixins' features
+    void register_features(itlib::span<feature_info* const> infos);
+    void register_mixins(itlib::span<mixin_info* const> infos);
+
     // unregistrators
     // optionally unregister infos (they must have been registered sucessfully before that)
     // unregistrators also remove all object types which use such an info
@@ -60,14 +70,30 @@ public:
     void unregister_mixin(mixin_info& info);
     void unregister_feature(feature_info& info);
 
+    // unregister many mixins at once
+    // the affected types and queries are found through indices and removed in one go
+    // if any of the mixins is not registered, nothing is unregistered
+    // (as is the case if any of them is referenced by a registered declarative type class)
+    void unregister_mixins(itlib::span<mixin_info* const> infos);
+
     // type classes don't have to be registered, but if they are, they can be queried by name
-    void register_type_class(const type_class& tc);
-    void unregister_type_class(const type_class& tc);
+    // and the types cache their results for them
+    // a type class must not be unregistered while types are being checked against it
+    // registering sets the domain and id of the type class (it can be registered in a single domain)
+    void register_type_class(type_class& tc);
+    void unregister_type_class(type_class& tc);
+
+    // call func for each existing type which is of a type class (the empty type is not included)
+    // declarative type classes which are registered are evaluated in batch through their bitsets
+    // the types are visited under a lock, so func must not call functions of the domain which lock
+    // (checking type classes through types is fine)
+    void for_each_type_of(const type_class& tc, const std::function<void(const type&)>& func);
 
     // get registered infos
     // return nullptr if nothing matches the arg
     // these functions are not const, as they are not safe to use where a const domain
     // would be available for the risk of recursive mutex locks
+    // getting infos by id doesn't lock (it's wait-free)
     const mixin_info* get_mixin_info(mixin_id id) noexcept;
     const mixin_info* get_mixin_info(std::string_view name) noexcept;
     const feature_info* get_feature_info(feature_id id) noexcept;
@@ -94,9 +120,54 @@ public:
     // then return the requested (potentially new) type
     const type& get_type(itlib::span<const mixin_info* const> query);
 
+    // shorthands for getting a type which is the result of adding or removing a single mixin to/from base
+    // they produce the same result as get_type with a mutation of base which adds/removes the mixin
+    // the results are cached in the base type, so they don't look up the domain's registry when repeated
+    // (the cache is invalidated when mutation rules are added or removed, types are collected,
+    // or mixins are unregistered)
+    const type& get_type_with(const type& base, const mixin_info& mixin);
+    const type& get_type_without(const type& base, const mixin_info& mixin);
+
+    // get or create the types for many queries at once
+    // mutation rules are applied and new types are built in parallel,
+    // then they are all added to the registry under a single lock
+    // if provided, the executor must call job(i) for each i in [0, num_jobs) (in parallel or not) and return
+    // when they're all done, otherwise internal worker threads are used
+    // if any query fails, its error is rethrown and no types are added
+    using prewarm_executor = std::function<void(size_t num_jobs, const std::function<void(size_t)>& job)>;
+    void prewarm_types(itlib::span<const itlib::span<const mixin_info* const>> queries, const prewarm_executor& executor = {});
+
+    // add types and stored queries which lead to them *without* applying mutation rules
+    // each query is given with the index of its resulting type in types
+    // the user is responsible for the queries leading to the types which the mutation rules would produce
+    // this is used to restore types from a persisted manifest (see type_manifest.hpp)
+    // if any type is invalid, the error is thrown and nothing is added
+    struct restored_query {
+        itlib::span<const mixin_info* const> query;
+        uint32_t type_index;
+    };
+    void restore_types(itlib::span<const itlib::span<const mixin_info* const>> types, itlib::span<const restored_query> queries);
+
     // performs garbage collection removing object types with zero objects
+    // types which are kept by the hysteresis of the gc policy (min_unused_time) are not removed
+    // unlike automatic collections, it also removes types which were returned but never got objects,
+    // so it must not run while other threads hold such types
     void garbage_collect_types() noexcept;
 
+    // performs a step of incremental garbage collection
+    // it examines at most budget types (0 means all), continuing from where the previous step stopped,
+    // and removes those with zero objects
+    // returns the number of removed types
+    size_t garbage_collect_types_step(uint32_t budget) noexcept;
+
+    // garbage collection policy (see type_gc_policy.hpp)
+    // by default types are only collected when garbage_collect_types* is called
+    void set_type_gc_policy(const type_gc_policy& policy) noexcept;
+    [[nodiscard]] type_gc_policy get_type_gc_policy() const noexcept;
+
+    // memory in bytes occupied by the existing types (ftables shared by several types are counted once)
+    [[nodiscard]] size_t types_memory() const noexcept;
+
     // get the domain's empty type
     // this type implements default implementations and has no mixins
     // disgregards mutation rules, so
@@ -107,6 +178,21 @@ public:
     // get number of existing types
     [[nodiscard]] size_t num_types() const noexcept;
 
+    // concurrent requests for the same new type are single-flight: one thread builds it and the others wait
+    // this is the number of builds avoided this way
+    [[nodiscard]] size_t num_avoided_type_builds() const noexcept;
+
+    // instrumentation counters (see domain_stats.hpp)
+    // reading them doesn't lock
+    [[nodiscard]] domain_stats stats() const noexcept;
+
+    // set a listener for the events of the domain (see domain_listener.hpp), or null to remove it
+    // the listener is referenced by address: the user is responsible for preserving its lifetime
+    // when this function returns, the previous listener is not being called and won't be called again
+    // (so it must not be called from a listener)
+    // events are only timed when there is a listener
+    void set_listener(const domain_listener* listener) noexcept;
+
     allocator get_allocator() const noexcept;
 
     using dnmx_basic_domain::user_data;
@@ -123,6 +209,18 @@ private:
     class impl;
     impl* m_impl;
     friend class domain_traverse;
+
+    // called by types when the number of their objects drops to zero
+    // the type must not be touched after the count is decremented (it may be collected by another thread),
+    // so it's identified by pointer and hash
+    friend class type;
+    void on_type_unused(const type* t, size_t mixins_hash) noexcept;
+
+    // type class checks of types which use the types' caches for registered type classes
+    // they don't lock
+    // the one by name returns false if no such type class is registered
+    bool type_is_of(const type& t, const type_class& tc) noexcept;
+    bool type_is_of(const type& t, std::string_view tc_name, bool& result) noexcept;
 };
 
 }
@@ -0,0 +1,11 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../dnmx/domain_listener.h"
+
+namespace dynamix {
+using domain_event_type = dnmx_domain_event_type;
+using domain_event = dnmx_domain_event;
+using domain_listener = dnmx_domain_listener;
+}
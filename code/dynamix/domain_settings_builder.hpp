@@ -20,6 +20,10 @@ struct domain_settings_builder {
         settings.allow_duplicate_mixin_names = val;
         return *this;
     }
+    domain_settings_builder& compact_types(bool val = true) noexcept {
+        settings.compact_types = val;
+        return *this;
+    }
     // intentionally implicit
     operator domain_settings() const noexcept { return settings; }
 };
@@ -0,0 +1,9 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../dnmx/domain_stats.h"
+
+namespace dynamix {
+using domain_stats = dnmx_domain_stats;
+}
@@ -12,6 +12,7 @@
 #include "mixin_allocator.hpp"
 #include "any.hpp"
 #include "mixin_info_data_literals.hpp"
+#include "throw_exception.hpp"
 
 #include <splat/warnings.h>
 
@@ -172,6 +173,25 @@ public:
         return implements_with_payload(finfo, pl, perks_a, perks_b);
     }
 
+    // add a batch payload for a feature which is already implemented by the mixin
+    // (the batch payload is called instead of the regular one for groups of objects of the same type in batched calls)
+    self& implements_batch_with_payload(const feature_info& info, any batch_payload) {
+        for (auto i = m_data.feature_payloads.rbegin(); i != m_data.feature_payloads.rend(); ++i) {
+            if (i->info != &info) continue;
+            i->batch_payload = m_data.feature_payload_storage.emplace_back(std::move(batch_payload)).get();
+            return *this;
+        }
+        throw_exception::batch_without_payload(m_data.info, info);
+    }
+
+    template <typename Feature, typename Payload>
+    self& implements_batch_by(const Payload& tpl) {
+        using traits = typename Feature::traits;
+        any pl = traits::make_batch_payload_by(get_allocator(), impl::make_nullptr<Mixin>(), tpl);
+        const feature_info& finfo = g::get_feature_info_safe<Feature>();
+        return implements_batch_with_payload(finfo, pl);
+    }
+
     // add rules
     // WARNING: adds_mutation_rule implicitly makes the mixin a dependency
     // if you don't want this, you must add .dependency(false) after all adds_mutation_rule calls
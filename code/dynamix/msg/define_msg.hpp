@@ -3,6 +3,7 @@
 //
 #pragma once
 #include "msg_traits.hpp"
+#include "msg_inline_cache.hpp"
 #include "msg_macros.hpp"
 #include "../common_feature_info.hpp"
 
@@ -25,3 +26,19 @@
 
 #define DYNAMIX_DEFINE_MSG(msg_name, mechanism, func_name, return_type, args) \
     DYNAMIX_DEFINE_MSG_EX(msg_name, mechanism, true, nullptr, func_name, return_type, args)
+
+// messages whose functions have a per-thread inline cache of the payloads for the types they were last called with
+// (see msg_inline_cache.hpp)
+// the cache is per message (and thread), not per call site: it's shared by all calls of the function
+// this speeds up messages which are called with objects of one or a few types
+// but call sites with different types evict each other's entries (use DYNAMIX_CALL_SITE_CACHED for them)
+// cache_size is the number of cached types (1 is a monomorphic cache)
+#define DYNAMIX_DEFINE_CACHED_MSG_EX(msg_name, mechanism, clash, default_impl, cache_size, func_name, return_type, args) \
+    return_type func_name(I_DNMX_DECL_ARGS args) { \
+        static thread_local ::dynamix::msg_inline_cache<cache_size> cache; \
+        return msg_name::traits::caller::I_DNMX_PP_CAT(I_DNMX_PP_CAT(call_, mechanism), _cached)(msg_name::info, cache, I_DNMX_FWD_ARGS args); \
+    } \
+    DYNAMIX_DEFINE_SIMPLE_MSG_EX(msg_name, mechanism, clash, default_impl)
+
+#define DYNAMIX_DEFINE_CACHED_MSG(msg_name, mechanism, cache_size, func_name, return_type, args) \
+    DYNAMIX_DEFINE_CACHED_MSG_EX(msg_name, mechanism, true, nullptr, cache_size, func_name, return_type, args)
@@ -6,14 +6,22 @@
 #include "../feature_payload.hpp"
 #include "../throw_exception.hpp"
 #include "../type.hpp"
+#include "msg_inline_cache.hpp"
+#include "../bits/q_const.hpp"
 #include "../../dnmx/bits/no_sanitize.h"
+#include "../../dnmx/bits/prefetch.h"
+
+#include <itlib/span.hpp>
+
+#include <type_traits>
 
 namespace dynamix {
 // caller for a specific signature
 // also templated by object to preserve const-ness
 template <typename Object, typename Ret, typename... Args>
 struct msg_caller {
-    static Ret try_default_payload(const feature_info& info, Object& obj, Args&&... args) {
+    template <typename... CallArgs> // different arguments to allow lvalues in batches
+    static Ret try_default_payload(const feature_info& info, Object& obj, CallArgs&&... args) {
         if (!info.default_payload) {
             throw_exception::generic_feature_error(obj.get_type(), "does not implement", "dynamix msg", info);
         }
@@ -21,7 +29,7 @@ struct msg_caller {
         // we have a default payload
         // note that it has a different signature (obj first instead of mixin)
         auto func = reinterpret_cast<Ret(*)(Object&, Args...)>(info.default_payload);
-        return func(obj, std::forward<Args>(args)...);
+        return func(obj, std::forward<CallArgs>(args)...);
     }
 
     using func_t = Ret(*)(const void*, Args...);
@@ -61,24 +69,210 @@ struct msg_caller {
         return try_default_payload(info, obj, std::forward<Args>(args)...);
     }
 
+    // call the payloads of the top bid
+    template <typename... CallArgs>
+    static Ret call_top_bid(const type::ftable_payload* begin, const type::ftable_payload* top_bid_back, Object& obj, CallArgs&&... args) {
+        // reverse order of execution:
+        // this way the same-prio multicast execution order follows the mixins order
+        // and prio messages will higher prio be executed first
+        for (auto i = top_bid_back; i != begin; --i) {
+            call(*i, obj, args...); // args are copied! return value is ignored
+        }
+        // return first (top) result
+        return call(*begin, obj, std::forward<CallArgs>(args)...);
+    }
+
     static Ret call_multicast(const feature_info& info, Object& obj, Args&&... args) {
         const type& t = obj.get_type();
 
         auto fe = t.ftable_at(info.id); // ftable entry
         if /*likely*/ (fe) {
-            // reverse order of execution:
-            // this way the same-prio multicast execution order follows the mixins order
-            // and prio messages will higher prio be executed first
-            for (auto i = fe.top_bid_back; i != fe.begin; --i) {
-                call(*i, obj, args...); // args are copied! return value is ignored
-            }
-            // return first (top) result
+            return call_top_bid(fe.begin, fe.top_bid_back, obj, std::forward<Args>(args)...);
+        }
+
+        return try_default_payload(info, obj, std::forward<Args>(args)...);
+    }
+
+    // calls through a call site cache (see msg_inline_cache.hpp)
+    // on a hit the ftable is not touched
+    // the misses are separate functions to keep the hits small enough to be inlined
+    // default payloads are not cached
+    template <typename Cache>
+    static Ret call_unicast_cached(const feature_info& info, Cache& cache, Object& obj, Args&&... args) {
+        if /*likely*/ (auto e = cache.find(obj.get_type())) {
+            return call(e->top, obj, std::forward<Args>(args)...);
+        }
+        return call_unicast_cache_miss(info, cache, obj, std::forward<Args>(args)...);
+    }
+
+    template <typename Cache>
+    static Ret call_unicast_cache_miss(const feature_info& info, Cache& cache, Object& obj, Args&&... args) {
+        const type& t = obj.get_type();
+
+        auto fe = t.ftable_at(info.id); // ftable entry
+        if (fe) {
+            cache.add(t, fe);
             return call(*fe.begin, obj, std::forward<Args>(args)...);
         }
 
         return try_default_payload(info, obj, std::forward<Args>(args)...);
     }
 
+    template <typename Cache>
+    static Ret call_multicast_cached(const feature_info& info, Cache& cache, Object& obj, Args&&... args) {
+        if /*likely*/ (auto e = cache.find(obj.get_type())) {
+            return call_top_bid(e->begin, e->top_bid_back, obj, std::forward<Args>(args)...);
+        }
+        return call_multicast_cache_miss(info, cache, obj, std::forward<Args>(args)...);
+    }
+
+    template <typename Cache>
+    static Ret call_multicast_cache_miss(const feature_info& info, Cache& cache, Object& obj, Args&&... args) {
+        const type& t = obj.get_type();
+
+        auto fe = t.ftable_at(info.id); // ftable entry
+        if (fe) {
+            cache.add(t, fe);
+            return call_top_bid(fe.begin, fe.top_bid_back, obj, std::forward<Args>(args)...);
+        }
+
+        return try_default_payload(info, obj, std::forward<Args>(args)...);
+    }
+
+    // batched calls for a span of objects or of pointers to objects
+    // consecutive objects of the same type are grouped and the ftable is looked up once per group
+    // the result for objs[i] is written to results[i] unless results is null
+    // (results of messages which return references are not collected)
+    // when results are not collected, unicasts call the batch payloads of mixins which have them
+    // once for each group (see feature_for_mixin::batch_payload)
+    // the same args are passed to every call, so they are never moved from
+    // if a call throws, the objects after it are not called
+    using batch_results_t = std::conditional_t<std::is_void_v<Ret> || std::is_reference_v<Ret>, std::nullptr_t, Ret*>;
+
+    template <typename T, typename... CallArgs>
+    static void call_unicast_batch(const feature_info& info, itlib::span<T> objs, batch_results_t results, CallArgs&&... args) {
+        const size_t size = objs.size();
+        size_t i = 0;
+        while (i < size) {
+            Object& first = batch_object(objs[i]);
+            const type& t = first.get_type();
+
+            auto fe = t.ftable_at(info.id); // ftable entry
+            if (!fe) {
+                batch_invoke(results, i, [&]() -> Ret { return try_default_payload(info, first, args...); });
+                ++i;
+                continue;
+            }
+
+            const auto top = *fe.begin;
+            if (top.data->batch_payload && !batch_collects(results)) {
+                i = call_batch_payload(objs, i, t, top, args...);
+                continue;
+            }
+
+            do {
+                batch_prefetch(objs, i, t, top.mixin_index);
+                Object& obj = batch_object(objs[i]);
+                batch_invoke(results, i, [&]() -> Ret { return call(top, obj, args...); });
+            } while (++i < size && &batch_object(objs[i]).get_type() == &t);
+        }
+    }
+
+    // batch payloads get the mixins of a group in chunks of at most this many
+    static constexpr size_t batch_chunk_size = 64;
+
+    // a batch payload points to this struct (see msg_traits::make_batch_payload_by)
+    // the function gets the struct itself, so that the adapters which are stored with it can reach their data
+    // and the mixins of a chunk of the group (as they are stored in the objects, so there are no casts to do)
+    using batch_void_t = q_const<std::is_const_v<std::remove_reference_t<Object>>, void>*;
+    struct batch_payload {
+        using func_t = void(*)(const batch_payload& self, const batch_void_t* mixins, size_t num_mixins, Args...);
+        func_t func;
+    };
+
+    // call the batch payload for the group of objects of type t starting at i
+    // returns the end of the group
+    template <typename T, typename... CallArgs>
+    static size_t call_batch_payload(itlib::span<T> objs, size_t i, const type& t, const type::ftable_payload& pl, CallArgs&... args) {
+        auto& bpl = *static_cast<const batch_payload*>(pl.data->batch_payload);
+        batch_void_t mixins[batch_chunk_size];
+        size_t num = 0;
+        do {
+            batch_prefetch(objs, i, t, pl.mixin_index);
+            mixins[num++] = batch_object(objs[i]).unchecked_get_at(pl.mixin_index);
+            if (num == batch_chunk_size) {
+                bpl.func(bpl, mixins, num, args...);
+                num = 0;
+            }
+        } while (++i < objs.size() && &batch_object(objs[i]).get_type() == &t);
+        if (num) bpl.func(bpl, mixins, num, args...);
+        return i;
+    }
+
+    template <typename T, typename... CallArgs>
+    static void call_multicast_batch(const feature_info& info, itlib::span<T> objs, batch_results_t results, CallArgs&&... args) {
+        const size_t size = objs.size();
+        size_t i = 0;
+        while (i < size) {
+            Object& first = batch_object(objs[i]);
+            const type& t = first.get_type();
+
+            auto fe = t.ftable_at(info.id); // ftable entry
+            if (!fe) {
+                batch_invoke(results, i, [&]() -> Ret { return try_default_payload(info, first, args...); });
+                ++i;
+                continue;
+            }
+
+            do {
+                batch_prefetch(objs, i, t, fe.begin->mixin_index);
+                Object& obj = batch_object(objs[i]);
+                batch_invoke(results, i, [&]() -> Ret { return call_top_bid(fe.begin, fe.top_bid_back, obj, args...); });
+            } while (++i < size && &batch_object(objs[i]).get_type() == &t);
+        }
+    }
+
+    template <typename T>
+    static Object& batch_object(T& elem) noexcept {
+        if constexpr (std::is_pointer_v<std::remove_cv_t<T>>) return *elem;
+        else return elem;
+    }
+
+    static bool batch_collects(batch_results_t results) noexcept {
+        if constexpr (std::is_same_v<batch_results_t, std::nullptr_t>) return false;
+        else return !!results;
+    }
+
+    template <typename F>
+    static void batch_invoke(batch_results_t results, size_t i, F&& f) {
+        if constexpr (std::is_same_v<batch_results_t, std::nullptr_t>) {
+            f();
+        }
+        else {
+            if (results) results[i] = f();
+            else f();
+        }
+    }
+
+    // the objects are prefetched far ahead (if they're not contiguous), so that their types can be checked
+    // when they get nearer, where the mixins of the ones of the current type are prefetched
+    static constexpr size_t batch_prefetch_distance = 8;
+
+    template <typename T>
+    static void batch_prefetch(itlib::span<T> objs, size_t i, const type& t, mixin_index_t index) noexcept {
+        if constexpr (std::is_pointer_v<std::remove_cv_t<T>>) {
+            if (i + 2 * batch_prefetch_distance < objs.size()) {
+                I_DYNAMIX_PREFETCH(objs[i + 2 * batch_prefetch_distance]);
+            }
+        }
+        if (i + batch_prefetch_distance < objs.size()) {
+            auto& obj = batch_object(objs[i + batch_prefetch_distance]);
+            if (&obj.get_type() == &t) {
+                I_DYNAMIX_PREFETCH(obj.unchecked_get_at(index));
+            }
+        }
+    }
+
     template <typename V1Combinator>
     static void call_with_v1_combinator(const feature_info& info, V1Combinator& combinator, Object& obj, Args&&... args) {
         const type& t = obj.get_type();
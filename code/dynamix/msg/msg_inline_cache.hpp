@@ -0,0 +1,66 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../type.hpp"
+#include "../../dnmx/bits/pp.h"
+
+#include <cstdint>
+
+namespace dynamix {
+// a cache of the ftable lookups of a message call site
+// with one entry it's monomorphic, with more it's a small polymorphic cache with round-robin replacement
+//
+// there are two ways to use it:
+// * DYNAMIX_DEFINE_CACHED_MSG: the message function has a cache, which is shared by all of its call sites
+//   (this requires no changes to the call sites, but ones with different types evict each other's entries)
+// * DYNAMIX_CALL_SITE_CACHED (or msg_traits::call_*_cached with a cache owned by the caller): a cache per call site
+//
+// entries are matched by the serial of the type
+// the serials are never reused, so if a type is collected and another one is created at the same address,
+// the stale entry won't be matched (its payload is never called)
+//
+// caches are not synchronized: they are meant to be thread_local
+template <uint32_t N>
+class msg_inline_cache {
+public:
+    static_assert(N > 0, "empty msg cache");
+
+    struct entry {
+        uint64_t serial = 0; // zero for unused entries (no type has it)
+        type::ftable_payload top = {}; // copy of the top payload (for unicasts)
+        const type::ftable_payload* begin = nullptr; // top bid range (for multicasts)
+        const type::ftable_payload* top_bid_back = nullptr;
+    };
+
+    const entry* find(const type& t) const noexcept {
+        const auto serial = t.serial;
+        for (auto& e : m_entries) {
+            if (e.serial == serial) return &e;
+        }
+        return nullptr;
+    }
+
+    // fe must not be empty
+    const entry& add(const type& t, const type::ftable_entry& fe) noexcept {
+        auto& e = m_entries[m_next];
+        m_next = (m_next + 1) % N;
+        e = {t.serial, *fe.begin, fe.begin, fe.top_bid_back};
+        return e;
+    }
+
+private:
+    entry m_entries[N] = {};
+    uint32_t m_next = 0; // next entry to replace
+};
+}
+
+// call a message through a cache of this call site
+// each expansion has its own thread_local cache
+// mechanism is unicast or multicast and the message traits must be complete
+// for example: DYNAMIX_CALL_SITE_CACHED(update_msg, unicast, 2, obj, dt)
+#define DYNAMIX_CALL_SITE_CACHED(msg_name, mechanism, cache_size, ...) \
+    ([&]() -> decltype(auto) { \
+        static thread_local ::dynamix::msg_inline_cache<cache_size> i_dnmx_site_cache; \
+        return msg_name::traits::I_DNMX_PP_CAT(I_DNMX_PP_CAT(call_, mechanism), _cached)(i_dnmx_site_cache, __VA_ARGS__); \
+    }())
@@ -29,6 +29,28 @@ struct basic_msg_traits<Msg, Ret(Obj, Args...)> {
         return caller::call_multicast(Msg::info, obj, std::forward<Args>(args)...);
     }
 
+    // calls through a cache owned by the caller (see msg_inline_cache.hpp)
+    template <uint32_t N>
+    static Ret call_unicast_cached(msg_inline_cache<N>& cache, Obj obj, Args... args) {
+        return caller::call_unicast_cached(Msg::info, cache, obj, std::forward<Args>(args)...);
+    }
+    template <uint32_t N>
+    static Ret call_multicast_cached(msg_inline_cache<N>& cache, Obj obj, Args... args) {
+        return caller::call_multicast_cached(Msg::info, cache, obj, std::forward<Args>(args)...);
+    }
+
+    // batched calls (see msg_caller)
+    // objs is a span of objects or of pointers to objects
+    using batch_results_t = typename caller::batch_results_t;
+    template <typename T>
+    static void call_unicast_batch(itlib::span<T> objs, batch_results_t results, Args... args) {
+        caller::call_unicast_batch(Msg::info, objs, results, args...);
+    }
+    template <typename T>
+    static void call_multicast_batch(itlib::span<T> objs, batch_results_t results, Args... args) {
+        caller::call_multicast_batch(Msg::info, objs, results, args...);
+    }
+
     using void_t = q_const<is_const, void>*;
     using func_t = Ret(*)(void_t, Args...);
 
@@ -42,6 +64,39 @@ struct basic_msg_traits<Msg, Ret(Obj, Args...)> {
         Ret(*pf)(q_const<is_const, Mixin>*, Args...) = f;
         return fwd_any(reinterpret_cast<feature_payload>(pf));
     }
+
+    // batch payloads are called for chunks of groups of objects of the same type (see msg_caller)
+    // they are stored as msg_caller::batch_payload followed by the user function
+    // the generated adapter in the header casts the mixins to the types which the user function takes
+    using batch_payload_t = typename caller::batch_payload;
+    using batch_void_t = typename caller::batch_void_t;
+    using batch_func_t = void(*)(const batch_void_t* mixins, size_t num_mixins, Args...);
+
+    template <typename Func>
+    struct batch_payload_with {
+        batch_payload_t header; // first, so that the payload can be used as the header
+        Func user_func;
+    };
+
+    static any make_batch_payload_by(allocator alloc, void*, batch_func_t func) {
+        using pl_t = batch_payload_with<batch_func_t>;
+        pl_t pl = {{[](const batch_payload_t& self, const batch_void_t* mixins, size_t num, Args... args) {
+            reinterpret_cast<const pl_t&>(self).user_func(mixins, num, std::forward<Args>(args)...);
+        }}, func};
+        return make_any(alloc, pl);
+    }
+
+    template <typename Mixin, typename Func>
+    static any make_batch_payload_by(allocator alloc, Mixin*, Func f) {
+        using mixin_t = q_const<is_const, Mixin>;
+        using pl_t = batch_payload_with<void(*)(itlib::span<mixin_t*>, Args...)>;
+        pl_t pl = {{[](const batch_payload_t& self, const batch_void_t* mixins, size_t num, Args... args) {
+            mixin_t* typed[caller::batch_chunk_size];
+            for (size_t i = 0; i < num; ++i) typed[i] = static_cast<mixin_t*>(mixins[i]);
+            reinterpret_cast<const pl_t&>(self).user_func(itlib::span<mixin_t*>(typed, num), std::forward<Args>(args)...);
+        }}, f};
+        return make_any(alloc, pl);
+    }
 };
 
 template <typename Msg>
@@ -6,17 +6,33 @@
 #include "mutate_to.hpp"
 #include "domain.hpp"
 
+#include <type_traits>
+
 namespace dynamix {
+namespace impl {
+// ops which add or remove a single mixin by info can get their type through the type edge cache
+template <typename Op, typename = void>
+struct is_edge_op : std::false_type {};
+template <typename Op>
+struct is_edge_op<Op, std::void_t<decltype(std::declval<Op&>().get_edge_type(std::declval<domain&>(), std::declval<const type&>()))>> : std::true_type {};
+}
+
 // regular mutate with ops as arguments
 template <typename... Ops>
 void mutate(object& obj, Ops&&... ops) {
-    type_mutation type_mut(obj.get_type());
+    if constexpr (sizeof...(Ops) == 1 && (impl::is_edge_op<std::decay_t<Ops>>::value && ...)) {
+        auto& type = (ops.get_edge_type(obj.get_domain(), obj.get_type()), ...);
+        mutate_to(obj, type, std::forward<Ops>(ops)...);
+    }
+    else {
+        type_mutation type_mut(obj.get_type());
 
-    (ops.apply_to_type_mutation(type_mut), ...);
+        (ops.apply_to_type_mutation(type_mut), ...);
 
-    auto& type = obj.get_domain().get_type(std::move(type_mut));
+        auto& type = obj.get_domain().get_type(std::move(type_mut));
 
-    mutate_to(obj, type, std::forward<Ops>(ops)...);
+        mutate_to(obj, type, std::forward<Ops>(ops)...);
+    }
 }
 
 // v1 comaptible mutate which only works with mixins with default init functions
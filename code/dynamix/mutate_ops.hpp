@@ -5,6 +5,7 @@
 #include "object_mutate_ops.hpp"
 #include "mixin_info.hpp"
 #include "type_mutation.hpp"
+#include "domain.hpp"
 
 namespace dynamix {
 struct simple_mutate_op {
@@ -25,6 +26,7 @@ struct mutate_op_by_name {
 struct mutate_op_remove_by_info : public mutate_op_by_info, public simple_mutate_op {
     using mutate_op_by_info::mutate_op_by_info;
     void apply_to_type_mutation(type_mutation& mut) { mut.remove(info); }
+    const type& get_edge_type(domain& dom, const type& base) { return dom.get_type_without(base, info); }
 };
 
 struct mutate_op_remove_by_name : public mutate_op_by_name, public simple_mutate_op {
@@ -35,6 +37,7 @@ struct mutate_op_remove_by_name : public mutate_op_by_name, public simple_mutate
 struct mutate_op_just_add_by_info : public mutate_op_by_info, public simple_mutate_op {
     using mutate_op_by_info::mutate_op_by_info;
     void apply_to_type_mutation(type_mutation& mut) { mut.add(info); }
+    const type& get_edge_type(domain& dom, const type& base) { return dom.get_type_with(base, info); }
 };
 
 struct mutate_op_just_add_by_name : public mutate_op_by_name, public simple_mutate_op {
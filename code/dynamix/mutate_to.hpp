@@ -19,6 +19,9 @@ template <typename... Ops>
 void mutate_to(object& obj, const type& type, Ops&&... ops) {
     if (obj.get_type() == type) return; // noop
 
+    // no mixins to init (and object_mutation can't complete without any)
+    if (type.num_mixins() == 0) return obj.reset_type(type);
+
     // here we need to:
     // * filter out ops that are not applicable for the object mutation which is to come
     // * sort the applicable ones by index in the new type
@@ -5,3 +5,7 @@
 #include "../dnmx/mutation_rule_info.h"
 #include "mutation_rule_info_fwd.hpp"
 #include "error_return.hpp"
+
+namespace dynamix {
+using mutation_rule_clause = dnmx_mutation_rule_clause;
+}
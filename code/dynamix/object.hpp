@@ -12,6 +12,7 @@
 #include "object_mixin_data.hpp"
 #include "mixin_info_fwd.hpp"
 #include "type_class.hpp"
+#include "type.hpp"
 #include "globals.hpp"
 
 #include <splat/inline.h>
@@ -113,13 +114,11 @@ public:
 
     const type& get_type() const noexcept;
 
-    bool is_of(const type_class& tc) const noexcept {
-        return tc.matches(m_type);
-    }
+    bool is_of(const type_class& tc) const noexcept { return type::from_c_handle(m_type)->is_of(tc); }
     bool is_of(std::string_view name) const; // will throw if type class is not registered
     template <typename TypeClass>
     bool is_of() const noexcept {
-        return TypeClass::m_dynamix_type_class.matches(m_type);
+        return is_of(TypeClass::m_dynamix_type_class);
     }
 
     //////////////////////////
@@ -116,9 +116,10 @@ void object_mutation::allocate_mixin_data() {
         else {
             // zero offset means an external mixin
             const auto& info = *m_target_type.mixins[ti];
-            if (m_old_mixin_data && m_old_type->has(info.id)) {
+            const auto oi = m_old_mixin_data ? m_old_type->index_of(info.id) : invalid_mixin_index;
+            if (oi != invalid_mixin_index) {
                 // we have that external mixin, so just redirect buffer
-                data = m_old_mixin_data[m_old_type->sparse_mixin_indices[info.iid()]];
+                data = m_old_mixin_data[oi];
             }
             else {
                 if (auto m_alloc = info.allocator) {
@@ -212,12 +213,13 @@ void object_mutation::finalize() noexcept {
             const auto& info = *m_old_type->mixins[oi];
             auto& old_data = m_old_mixin_data[oi];
 
-            if (m_target_type.has(info.id)) {
+            const auto ni = m_target_type.index_of(info.id);
+            if (ni != invalid_mixin_index) {
                 // common mixin
                 if (old_data.buf) continue; // external: already in new buf
 
                 // common internal mixin: move to new buf
-                auto* new_mixin = m_target_mixin_data[m_target_type.sparse_mixin_indices[info.iid()]].mixin;
+                auto* new_mixin = m_target_mixin_data[ni].mixin;
                 info.move_init(&info, new_mixin, old_data.mixin);
 
                 // desroy the one we moved-out from
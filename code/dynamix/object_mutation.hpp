@@ -39,9 +39,9 @@ public:
         if (m_complete) return;
         auto ti = m_updated_upto;
         const auto& info = *m_target_type.mixins[ti];
-        if (m_old_mixin_data && m_old_type->has(info.id)) {
+        const auto oi = m_old_mixin_data ? m_old_type->index_of(info.id) : invalid_mixin_index;
+        if (oi != invalid_mixin_index) {
             // matching
-            auto oi = m_old_type->sparse_mixin_indices[info.iid()];
             auto mixin = m_old_mixin_data[oi].mixin;
             update_common(update_common_args{{info, mixin, m_target_type, ti}, *m_old_type, oi});
         }
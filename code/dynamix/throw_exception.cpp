@@ -19,6 +19,7 @@ template <typename Exception>
 class e {
     std::ostringstream out;
 public:
+    e() = default;
     e(const domain& dom) {
         *this << dom << ": ";
     }
@@ -98,6 +99,14 @@ void id_registered(const domain& dom, const mixin_info& info) {
     e<domain_error>(dom) << "register mixin " << info << " with a valid id " << info.iid() << do_throw;
 }
 
+void repeated_info(const domain& dom, const feature_info& info) {
+    e<domain_error>(dom) << "register feature " << info << " more than once" << do_throw;
+}
+
+void repeated_info(const domain& dom, const mixin_info& info) {
+    e<domain_error>(dom) << "register mixin " << info << " more than once" << do_throw;
+}
+
 void empty_name(const domain& dom, const feature_info&) {
     e<domain_error>(dom) << "register feature with empty name" << do_throw;
 }
@@ -126,6 +135,10 @@ void info_has_domain(const domain& dom, const mixin_info& info) {
     e<domain_error>(dom) << "register mixin " << info << " which has a domain = " << *domain::from_c_handle(info.dom) << do_throw;
 }
 
+void info_has_domain(const domain& dom, const type_class& tc) {
+    e<domain_error>(dom) << "register type class " << tc << " which has a domain = " << *domain::from_c_handle(tc.dom) << do_throw;
+}
+
 void unreg_foreign(const domain& dom, const feature_info& info) {
     e<domain_error>(dom) << "unregister foreign feature " << info << ", id = " << info.iid() << do_throw;
 }
@@ -153,6 +166,18 @@ void foreign_mutation(const domain& dom, const type_mutation& mut) {
     e<domain_error>(dom) << "requested type with foreign mutation " << mut << " of domain '" << mut.dom << '\'' << do_throw;
 }
 
+void foreign_mixin(const domain& dom, const type_class& tc, const mixin_info& m) {
+    e<domain_error>(dom) << "register type class " << tc << " with mixin " << m << " which is not registered in the domain" << do_throw;
+}
+
+void unreg_referenced(const domain& dom, const mixin_info& m, const type_class& tc) {
+    e<domain_error>(dom) << "unregister mixin " << m << " which is referenced by type class " << tc << do_throw;
+}
+
+void bad_type_manifest(const domain& dom, size_t offset) {
+    e<domain_error>(dom) << "bad type manifest at byte " << offset << do_throw;
+}
+
 void foreign_mixin(const type_mutation& mut, const mixin_info& m) {
     e<domain_error> out(mut.dom);
     out << "foreign mixin " << m << " from ";
@@ -207,6 +232,11 @@ void obj_error(const type& t, std::string_view op) {
     e<object_error>(t.dom) << op << " object of type " << t << do_throw;
 }
 
+void batch_without_payload(const mixin_info& m, const feature_info& f) {
+    // mixins are built before they are registered in a domain
+    e<feature_error>() << m << ": batch payload for " << f << " which is not implemented" << do_throw;
+}
+
 void generic_feature_error(const type& t, std::string_view err, std::string_view feature_type, const feature_info& f) {
     e<feature_error>(t.dom) << t << ' ' << err << ' ' << feature_type << ' ' << f << do_throw;
 }
@@ -20,6 +20,8 @@ namespace throw_exception {
 // domain_error
 [[noreturn]] void id_registered(const domain& dom, const feature_info& info);
 [[noreturn]] void id_registered(const domain& dom, const mixin_info& info);
+[[noreturn]] void repeated_info(const domain& dom, const feature_info& info);
+[[noreturn]] void repeated_info(const domain& dom, const mixin_info& info);
 [[noreturn]] void empty_name(const domain& dom, const feature_info& info);
 [[noreturn]] void empty_name(const domain& dom, const mixin_info& info);
 [[noreturn]] void empty_name(const domain& dom, const type_class& tc);
@@ -27,12 +29,16 @@ namespace throw_exception {
 [[noreturn]] void duplicate_name(const domain& dom, const mixin_info& info);
 [[noreturn]] void duplicate_name(const domain& dom, const type_class& tc);
 [[noreturn]] void info_has_domain(const domain& dom, const mixin_info& info);
+[[noreturn]] void info_has_domain(const domain& dom, const type_class& tc);
 [[noreturn]] void unreg_foreign(const domain& dom, const feature_info& info);
 [[noreturn]] void unreg_foreign(const domain& dom, const mixin_info& info);
 [[noreturn]] void no_func(const domain& dom, const mutation_rule_info& info);
 [[noreturn]] void no_func(const domain& dom, const type_class& tc);
 [[noreturn]] void foreign_mutation(const domain& dom, const type_mutation& mut);
 [[noreturn]] void foreign_mixin(const type_mutation& mut, const mixin_info& m);
+[[noreturn]] void foreign_mixin(const domain& dom, const type_class& tc, const mixin_info& m);
+[[noreturn]] void unreg_referenced(const domain& dom, const mixin_info& m, const type_class& tc);
+[[noreturn]] void bad_type_manifest(const domain& dom, size_t offset);
 
 // type_error
 [[noreturn]] void mutation_rule_user_error(const type_mutation& mut, const mutation_rule_info& info, error_return_t error);
@@ -49,6 +55,7 @@ namespace throw_exception {
 [[noreturn]] void obj_error(const type& t, std::string_view op);
 
 // feature_error
+[[noreturn]] DYNAMIX_API void batch_without_payload(const mixin_info& m, const feature_info& f);
 [[noreturn]] DYNAMIX_API void generic_feature_error(const type& t, std::string_view err, std::string_view feature_type, const feature_info& f);
 [[noreturn]] DYNAMIX_API void generic_feature_error(const type& t, std::string_view err, std::string_view feature_type, const feature_info& f, const mixin_info& m);
 }
@@ -0,0 +1,119 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "trace_recorder.hpp"
+#include "mixin_info.hpp"
+#include "../dnmx/basic_domain.h"
+
+#include <ostream>
+#include <fstream>
+#include <thread>
+#include <functional>
+#include <new>
+
+namespace dynamix::util {
+
+namespace {
+const char* event_name(domain_event_type type) {
+    switch (type) {
+    case dnmx_domain_event_query_miss: return "query miss";
+    case dnmx_domain_event_type_created: return "type created";
+    case dnmx_domain_event_rules_applied: return "rules applied";
+    case dnmx_domain_event_gc: return "gc";
+    }
+    return "unknown";
+}
+
+void output_json_str(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (uint8_t(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+// chrome traces are in microseconds
+void output_us(std::ostream& out, uint64_t ns) {
+    auto frac = ns % 1000;
+    out << ns / 1000 << '.' << char('0' + frac / 100) << char('0' + frac / 10 % 10) << char('0' + frac % 10);
+}
+}
+
+trace_recorder::trace_recorder(size_t capacity)
+    : m_listener{on_event, reinterpret_cast<uintptr_t>(this)}
+    , m_records(capacity ? capacity : 1)
+{}
+
+void trace_recorder::on_event(const domain_event* e, uintptr_t user_data) noexcept {
+    auto self = reinterpret_cast<trace_recorder*>(user_data);
+
+    std::lock_guard lock(self->m_mutex);
+    auto& r = self->m_records[self->m_next];
+    self->m_next = (self->m_next + 1) % self->m_records.size();
+    if (self->m_size < self->m_records.size()) ++self->m_size;
+
+    r.type = e->type;
+    r.start_ns = e->start_ns;
+    r.duration_ns = e->duration_ns;
+    r.count = e->count;
+    r.tid = uint32_t(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    try {
+        r.domain = e->dom->m_name.to_std();
+        r.mixins.clear();
+        for (auto m : e->mixins_span()) {
+            if (!r.mixins.empty()) r.mixins += ", ";
+            r.mixins += m->name.to_std();
+        }
+    }
+    catch (std::bad_alloc&) {
+        // record the event without names
+        r.domain.clear();
+        r.mixins.clear();
+    }
+}
+
+size_t trace_recorder::size() const {
+    std::lock_guard lock(m_mutex);
+    return m_size;
+}
+
+void trace_recorder::clear() {
+    std::lock_guard lock(m_mutex);
+    m_next = 0;
+    m_size = 0;
+}
+
+void trace_recorder::dump(std::ostream& out) const {
+    std::lock_guard lock(m_mutex);
+    out << "{\"traceEvents\":[";
+    const auto cap = m_records.size();
+    const auto first = m_size < cap ? 0 : m_next;
+    for (size_t i = 0; i < m_size; ++i) {
+        auto& r = m_records[(first + i) % cap];
+        if (i) out << ',';
+        out << "\n{\"name\":\"" << event_name(r.type) << "\",\"cat\":\"dynamix\",\"ph\":\"X\",\"ts\":";
+        output_us(out, r.start_ns);
+        out << ",\"dur\":";
+        output_us(out, r.duration_ns);
+        out << ",\"pid\":0,\"tid\":" << r.tid << ",\"args\":{\"domain\":";
+        output_json_str(out, r.domain);
+        out << ",\"mixins\":";
+        output_json_str(out, r.mixins);
+        if (r.type == dnmx_domain_event_rules_applied) out << ",\"passes\":" << r.count;
+        else if (r.type == dnmx_domain_event_gc) out << ",\"collected\":" << r.count;
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
+
+bool trace_recorder::dump(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    dump(out);
+    return !!out;
+}
+
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../dnmx/api.h"
+#include "domain_listener.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <iosfwd>
+
+namespace dynamix::util {
+
+// records domain events in a ring buffer (when it's full the oldest events are overwritten)
+// and dumps them in the chrome trace format (for chrome://tracing, perfetto, and similar)
+// usage: dom.set_listener(&recorder.listener())
+// the same recorder can listen to multiple domains
+// it must outlive the domains which it listens to or be removed from them before it's destroyed
+class DYNAMIX_API trace_recorder {
+public:
+    explicit trace_recorder(size_t capacity = 4096);
+    trace_recorder(const trace_recorder&) = delete;
+    trace_recorder& operator=(const trace_recorder&) = delete;
+
+    const domain_listener& listener() const noexcept { return m_listener; }
+
+    // number of recorded events (at most capacity)
+    size_t size() const;
+    size_t capacity() const noexcept { return m_records.size(); }
+    void clear();
+
+    // write the recorded events as chrome trace json (oldest first)
+    void dump(std::ostream& out) const;
+
+    // returns false if the file can't be written
+    bool dump(const std::string& path) const;
+
+private:
+    static void on_event(const domain_event* e, uintptr_t user_data) noexcept;
+
+    struct record {
+        domain_event_type type;
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        uint32_t count;
+        uint32_t tid;
+        std::string domain;
+        std::string mixins; // names separated by commas
+    };
+
+    domain_listener m_listener;
+
+    mutable std::mutex m_mutex;
+    std::vector<record> m_records; // the ring
+    size_t m_next = 0; // where the next event will be recorded
+    size_t m_size = 0;
+};
+
+}
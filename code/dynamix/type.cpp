@@ -9,15 +9,38 @@
 #include "type_class.hpp"
 #include "throw_exception.hpp"
 
+#include "bits/name_hash.hpp"
+
 #include <itlib/qalgorithm.hpp>
 
 namespace dynamix {
 
-mixin_index_t type::index_of(std::string_view name) const noexcept {
-    for (mixin_index_t i = 0; i < mixins.size(); ++i) {
-        if (mixins[i]->name == name) return i;
+type::type(domain& d, byte_size_t bsize) noexcept
+    : dnmx_basic_type({nullptr, 0, {nullptr, nullptr, 0, 0}})
+    , dom(d)
+    , buf_size(bsize)
+    , m_dom_handle(d.to_c_hanlde())
+{}
+
+uint32_t type::find_name(std::string_view name, uint32_t kind) const noexcept {
+    if (m_names.empty()) return empty_name_entry;
+    const auto hash = name_hash(name);
+    const size_t mask = m_names.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        // the load factor is at most 1/2, so there is always an empty slot
+        const auto& e = m_names[i];
+        if (e.value == empty_name_entry) return empty_name_entry;
+        if (e.hash != uint32_t(hash) || (e.value & feature_name_flag) != kind) continue;
+        const auto v = e.value & ~feature_name_flag;
+        const auto& entry_name = kind ? ftable[v].begin->data->info->name : mixins[v]->name;
+        if (entry_name == name) return v;
     }
-    return invalid_mixin_index;
+}
+
+mixin_index_t type::index_of(std::string_view name) const noexcept {
+    auto v = find_name(name, 0);
+    if (v == empty_name_entry) return invalid_mixin_index;
+    return mixin_index_t(v);
 }
 
 bool type::has(const mixin_info& info) const noexcept {
@@ -30,12 +53,7 @@ bool type::implements_strong(feature_id id) const noexcept {
     return !!ftable_at(id);
 }
 bool type::implements_strong(std::string_view name) const noexcept {
-    for (uint32_t i = 0; i < ftable_length; ++i) {
-        auto& e = ftable[i];
-        if (!e) continue;
-        if (e.begin->data->info->name == name) return true;
-    }
-    return false;
+    return find_name(name, feature_name_flag) != empty_name_entry;
 }
 bool type::implements(const feature_info& info) const noexcept {
     if (info.default_payload) return true;
@@ -80,10 +98,14 @@ itlib::span<const type::ftable_payload> type::find_next_bidder_set(const feature
     return {begin, end};
 }
 
+bool type::is_of_uncached(const type_class& tc) const noexcept {
+    return dom.type_is_of(*this, tc);
+}
+
 bool type::is_of(std::string_view name) const {
-    auto tc = dom.get_type_class(name);
-    if (!tc) throw_exception::unknown_type_class(*this, name);
-    return is_of(*tc);
+    bool result;
+    if (!dom.type_is_of(*this, name, result)) throw_exception::unknown_type_class(*this, name);
+    return result;
 }
 
 int type::compare(const type& other) const noexcept {
@@ -135,13 +157,24 @@ bool type::comparable() const noexcept {
 
 byte_t* type::allocate_object_buffer(allocator& alloc) const {
     auto ret = alloc.allocate_bytes(object_buffer_size, object_buffer_alignment);
-    ++m_num_objects;
+    m_num_objects.fetch_add(1, std::memory_order_relaxed);
+
+    // release a pin of a hand-out (see m_hand_outs)
+    // it's released after the count is increased, so that collections which see it also see the object
+    auto h = m_hand_outs.load(std::memory_order_relaxed);
+    while ((h & hand_out_pins_mask) && !m_hand_outs.compare_exchange_weak(h, h - hand_out_pin, std::memory_order_release, std::memory_order_relaxed));
+
     return static_cast<byte_t*>(ret);
 }
 
 void type::deallocate_object_buffer(allocator& alloc, void* ptr) const noexcept {
     alloc.deallocate_bytes(ptr, object_buffer_size, object_buffer_alignment);
-    --m_num_objects;
+
+    // once the count drops to zero the type may be collected by another thread,
+    // so don't touch it after that
+    auto& d = dom;
+    const auto hash = mixins_hash;
+    if (m_num_objects.fetch_sub(1, std::memory_order_release) == 1) d.on_type_unused(this, hash);
 }
 
 }
@@ -17,9 +17,11 @@
 #include "mixin_info_fwd.hpp"
 #include "globals.hpp"
 
+#include "bits/popcount.hpp"
+
 #include <itlib/span.hpp>
-#include <itlib/atomic.hpp>
 
+#include <atomic>
 #include <cstdint>
 #include <string_view>
 
@@ -29,11 +31,7 @@ class domain;
 
 class DYNAMIX_API type : public dnmx_basic_type {
     friend class domain;
-    type(domain& dom, byte_size_t buf_size) noexcept
-        : dnmx_basic_type({nullptr, 0})
-        , dom(dom)
-        , buf_size(buf_size)
-    {}
+    type(domain& dom, byte_size_t buf_size) noexcept;
 public:
     type(const type&) = delete;
     type& operator=(const type&) = delete;
@@ -46,6 +44,14 @@ public:
     // compact array of mixins infos of this type, no null items
     itlib::span<const mixin_info* const> mixins;
 
+    // hash of the mixins (as a sequence of pointers)
+    // the domain uses it to look up types
+    size_t mixins_hash = 0;
+
+    // unique among all types created in the process (it's never reused, unlike the address of a type)
+    // never zero
+    uint64_t serial = 0;
+
     // size of mixin buffer for objects of this type
     byte_size_t object_buffer_size = 0;
 
@@ -58,25 +64,33 @@ public:
 
     // indices of mixins in m_mixins per mixin_id
     // if an index is invalid_mixin_index, it is not a part of this type
+    // empty in domains with compact_types (the indices are found through mixin_id_bits)
     itlib::span<const mixin_index_t> sparse_mixin_indices;
 
+    // bitset of the ids of the mixins of this type in 64-bit words
+    // it has as many words as are needed for the greatest id
+    itlib::span<const uint64_t> mixin_id_bits;
+
     // number of objects of this type
     // more precisely this is the number of active (living-allocated) object buffers
-    size_t num_objects() const noexcept { return m_num_objects.load(); }
+    // (acquire: a zero means that the destroyed objects are done with the type)
+    size_t num_objects() const noexcept { return m_num_objects.load(std::memory_order_acquire); }
 
     mixin_index_t num_mixins() const noexcept {
         return mixin_index_t(mixins.size());
     }
 
     [[nodiscard]] FORCE_INLINE mixin_index_t index_of(mixin_id id) const noexcept {
-        if (id.i >= sparse_mixin_indices.size()) return invalid_mixin_index;
-        return sparse_mixin_indices[id.i];
+        if (id.i < sparse_mixin_indices.size()) return sparse_mixin_indices[id.i];
+        if (sparse_mixin_indices.empty()) return compact_index_of(id);
+        return invalid_mixin_index;
     }
     [[nodiscard]] mixin_index_t index_of(std::string_view name) const noexcept;
 
     [[nodiscard]] bool has(const mixin_info& info) const noexcept;
     [[nodiscard]] FORCE_INLINE bool has(mixin_id id) const noexcept {
-        return index_of(id) != invalid_mixin_index;
+        const auto word = id.i / 64;
+        return word < mixin_id_bits.size() && (mixin_id_bits[word] >> (id.i % 64)) & 1;
     }
     [[nodiscard]] bool has(std::string_view name) const noexcept {
         return index_of(name) != invalid_mixin_index;
@@ -119,11 +133,25 @@ public:
     itlib::span<const ftable_payload> find_next_bidder_set(const feature_info& feature, const mixin_info& mixin) const noexcept;
 
     // type class
+    // the results for type classes registered in the type's domain are cached in the type,
+    // so the match function is called only once per type class
+    // cached results are checked inline, as are the match functions of type classes which aren't registered
     [[nodiscard]] bool is_of(const type_class& tc) const noexcept {
-        return tc.matches(this);
+        if (tc.dom == m_dom_handle) {
+            if (tc.id < num_cached_type_classes) {
+                const uint64_t bit = uint64_t(1) << tc.id;
+                if (m_type_classes_known.load(std::memory_order_acquire) & bit) {
+                    return m_type_classes_matching.load(std::memory_order_relaxed) & bit;
+                }
+            }
+        }
+        else if (!tc.dom && tc.matches) {
+            return tc.matches(this);
+        }
+        return is_of_uncached(tc);
     }
     // check by registered type class from domain
-    // will throw domain_error if no such type class is registered
+    // will throw type_error if no such type class is registered
     [[nodiscard]] bool is_of(std::string_view name) const;
     template <typename TypeClass>
     [[nodiscard]] bool is_of() const noexcept {
@@ -171,7 +199,86 @@ public:
     // this is the buffer size (it's used when deallocating)
     byte_size_t buf_size;
 private:
-    mutable itlib::atomic_relaxed_counter<size_t> m_num_objects = {};
+    mutable std::atomic<size_t> m_num_objects = {};
+
+    // index_of for types without sparse mixin indices
+    // the rank of the id among the ids of the mixins (a popcount in mixin_id_bits) is mapped to the index
+    // ranks are the number of set bits in the preceding words plus the ones before the id in its word
+    itlib::span<const uint32_t> m_id_word_ranks; // per word of mixin_id_bits
+    itlib::span<const mixin_index_t> m_rank_mixin_indices; // per mixin
+    FORCE_INLINE mixin_index_t compact_index_of(mixin_id id) const noexcept {
+        const auto word = id.i / 64;
+        if (word >= mixin_id_bits.size()) return invalid_mixin_index;
+        const auto word_bits = mixin_id_bits[word];
+        const auto bit = uint64_t(1) << (id.i % 64);
+        if (!(word_bits & bit)) return invalid_mixin_index;
+        return m_rank_mixin_indices[m_id_word_ranks[word] + bits::popcount(word_bits & (bit - 1))];
+    }
+
+    // cache of the types which result from adding or removing a single mixin to/from this one
+    // it is managed by the domain (see domain::get_type_with and domain::get_type_without)
+    // edges are slots per mixin id (with collisions evicting each other)
+    // each one is a seqlock which allows concurrent reads and writes without locking
+    struct edge {
+        std::atomic<uint32_t> seq = {}; // odd while being written
+        std::atomic<uint32_t> generation = {}; // edges from previous generations of the domain are invalid
+        std::atomic<const mixin_info*> mixin = {};
+        std::atomic<const type*> target = {};
+    };
+    static constexpr uint32_t num_edges = 4;
+    mutable edge m_add_edges[num_edges];
+    mutable edge m_remove_edges[num_edges];
+
+    // cache of type class matches, managed by the domain
+    // bits are per id of registered type class (type classes with greater ids are not cached)
+    // a known bit is set (with release) after the result is stored in the same bit of matching
+    // (the bits of a type class are cleared when it's unregistered)
+    static constexpr uint32_t num_cached_type_classes = 64;
+    mutable std::atomic<uint64_t> m_type_classes_known = {};
+    mutable std::atomic<uint64_t> m_type_classes_matching = {};
+    dnmx_domain_handle m_dom_handle; // to check whether type classes are registered in our domain
+    bool is_of_uncached(const type_class& tc) const noexcept; // cache misses and unregistered type classes
+
+    // links of the lists of types per mixin in the domain's registry (one per mixin of this type)
+    // the lists are managed by the domain (only while holding its type registry lock)
+    struct mixin_link {
+        const type* prev;
+        const type* next;
+    };
+    itlib::span<mixin_link> m_mixin_links;
+
+    // index of the names of mixins and implemented features for by-name queries
+    // open-addressing hash table (linear probing) which is a part of the type buffer built by the domain
+    struct name_entry {
+        uint32_t hash; // low bits of name_hash
+        uint32_t value; // mixin index, or feature id | feature_name_flag, or empty_name_entry
+    };
+    static constexpr uint32_t empty_name_entry = ~uint32_t(0);
+    static constexpr uint32_t feature_name_flag = 0x80000000;
+    itlib::span<const name_entry> m_names;
+
+    // value of the entry for the name or empty_name_entry if there is none
+    uint32_t find_name(std::string_view name, uint32_t kind) const noexcept;
+
+    // garbage collection data managed by the domain (only touched while holding its type registry lock)
+    // head of the list of stored queries which lead to this type (a reverse index in the domain)
+    mutable const void* m_queries = nullptr;
+    // steady clock ticks when the type was first seen without objects (0 if it wasn't)
+    mutable std::atomic<int64_t> m_unused_since = 0;
+
+    // pins of the type by get_type (and the other functions of the domain which return types)
+    // the lower half is the number of pins: each hand-out adds one and each new object releases one
+    // automatic collections skip pinned types, so a type can't be collected before its first object is created
+    // the upper half is the number of hand-outs: collections keep types which were handed out while being collected
+    // (hand-outs from lock-free lookups are not ordered with the collection before it synchronizes)
+    static constexpr uint64_t hand_out_pin = 1;
+    static constexpr uint64_t hand_out_count = uint64_t(1) << 32;
+    static constexpr uint64_t hand_out_pins_mask = hand_out_count - 1;
+    mutable std::atomic<uint64_t> m_hand_outs = {};
+
+    // references by the domain itself (to the source of a type which is being built without locking)
+    // no collection frees a referenced type
+    mutable std::atomic<uint32_t> m_refs = {};
 };
 
 }
@@ -0,0 +1,46 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace dynamix {
+
+// policy for the garbage collection of object types in a domain
+// (see domain::set_type_gc_policy)
+struct type_gc_policy {
+    // max number of types examined by an automatic collection step (0 means all)
+    uint32_t step_budget = 0;
+
+    // hysteresis: a type is collected only after it has been without objects for at least this long
+    // this keeps alive types which are recreated soon after their last object is destroyed
+    // the time is counted from the moment the collector first sees the type without objects
+    // (with on_zero_objects this is when the last object is destroyed)
+    std::chrono::steady_clock::duration min_unused_time = {};
+
+    // automatic collection triggers (all are disabled by default)
+    //
+    // a type returned by domain::get_type is pinned until an object is created with it
+    // automatic collections don't remove pinned types, so types which are returned but never get objects
+    // are only removed by explicit collections (domain::garbage_collect_types)
+    // explicit collections ignore pins, thus they must not run while other threads hold types without objects
+
+    // collect a type when the number of its objects drops to zero
+    // this locks the type registry of the domain when the last object of a type is destroyed,
+    // so objects must not be destroyed from mutation rules with this policy
+    // types which are younger than min_unused_time when this happens are collected when the last object
+    // of another type is destroyed after the time passes
+    bool on_zero_objects = false;
+
+    // perform a collection step when a new type is created if the last step was at least this long ago
+    // (zero means disabled)
+    std::chrono::steady_clock::duration idle_interval = {};
+
+    // perform a collection step when a new type is created if the types of the domain occupy
+    // more than this many bytes (see domain::types_memory) (zero means disabled)
+    size_t memory_threshold = 0;
+};
+
+}
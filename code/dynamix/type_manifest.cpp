@@ -0,0 +1,193 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "type_manifest.hpp"
+#include "domain.hpp"
+#include "domain_traverse.hpp"
+#include "mixin_info.hpp"
+#include "type.hpp"
+#include "throw_exception.hpp"
+
+#include <unordered_map>
+#include <string_view>
+#include <cstring>
+
+namespace dynamix::util {
+namespace {
+// format (all integers are 32-bit in native byte order):
+// - magic
+// - num_names, names: size, chars
+// - num_types, types: num_mixins, name indices
+// - num_queries, queries: num_mixins, name indices, type index
+constexpr uint32_t manifest_magic = 0x4D54'4E44; // "DNTM"
+
+struct writer {
+    std::vector<byte_t> out;
+    void u32(uint32_t i) {
+        auto bytes = reinterpret_cast<const byte_t*>(&i);
+        out.insert(out.end(), bytes, bytes + sizeof(i));
+    }
+    void str(std::string_view s) {
+        u32(uint32_t(s.size()));
+        out.insert(out.end(), s.begin(), s.end());
+    }
+};
+
+struct name_table {
+    std::unordered_map<const mixin_info*, uint32_t> indices;
+    std::vector<std::string_view> names;
+    uint32_t index_of(const mixin_info* m) {
+        auto [i, inserted] = indices.try_emplace(m, uint32_t(names.size()));
+        if (inserted) names.push_back(m->name.to_std());
+        return i->second;
+    }
+};
+
+struct reader {
+    const domain& dom;
+    itlib::span<const byte_t> in;
+    size_t pos = 0;
+
+    [[noreturn]] void bad() const {
+        throw_exception::bad_type_manifest(dom, pos);
+    }
+    uint32_t u32() {
+        uint32_t ret;
+        if (in.size() - pos < sizeof(ret)) bad();
+        std::memcpy(&ret, in.data() + pos, sizeof(ret));
+        pos += sizeof(ret);
+        return ret;
+    }
+    // number of entries which take at least entry_size bytes each
+    // checked against the remaining bytes, so that corrupt counts don't lead to huge allocations
+    uint32_t count(size_t entry_size) {
+        auto ret = u32();
+        if ((in.size() - pos) / entry_size < ret) bad();
+        return ret;
+    }
+    std::string_view str() {
+        auto size = u32();
+        if (in.size() - pos < size) bad();
+        std::string_view ret(reinterpret_cast<const char*>(in.data() + pos), size);
+        pos += size;
+        return ret;
+    }
+};
+}
+
+std::vector<byte_t> save_type_manifest(const domain& d) {
+    domain_traverse tr(d);
+
+    name_table names;
+    std::unordered_map<const type*, uint32_t> type_indices;
+    std::vector<std::vector<uint32_t>> types;
+    std::vector<std::pair<std::vector<uint32_t>, uint32_t>> queries;
+
+    auto to_indices = [&](itlib::span<const mixin_info* const> mixins) {
+        std::vector<uint32_t> ret;
+        ret.reserve(mixins.size());
+        for (auto m : mixins) ret.push_back(names.index_of(m));
+        return ret;
+    };
+    auto type_index_of = [&](const type& t) {
+        auto [i, inserted] = type_indices.try_emplace(&t, uint32_t(types.size()));
+        if (inserted) types.push_back(to_indices(t.mixins));
+        return i->second;
+    };
+
+    tr.traverse_types([&](const type& t) {
+        type_index_of(t);
+    });
+    tr.traverse_type_queries([&](itlib::span<const mixin_info* const> query, const type& t) {
+        // queries may also lead to types which are not in the registry (the empty type)
+        auto index = type_index_of(t);
+        queries.emplace_back(to_indices(query), index);
+    });
+
+    writer w;
+    w.u32(manifest_magic);
+    w.u32(uint32_t(names.names.size()));
+    for (auto& n : names.names) w.str(n);
+    w.u32(uint32_t(types.size()));
+    for (auto& t : types) {
+        w.u32(uint32_t(t.size()));
+        for (auto i : t) w.u32(i);
+    }
+    w.u32(uint32_t(queries.size()));
+    for (auto& [q, t] : queries) {
+        w.u32(uint32_t(q.size()));
+        for (auto i : q) w.u32(i);
+        w.u32(t);
+    }
+    return std::move(w.out);
+}
+
+size_t load_type_manifest(domain& d, itlib::span<const byte_t> manifest) {
+    reader r{d, manifest};
+    if (r.u32() != manifest_magic) r.bad();
+
+    // null for mixins which are not registered
+    std::vector<const mixin_info*> mixins(r.count(sizeof(uint32_t))); // size of name
+    for (auto& m : mixins) {
+        m = d.get_mixin_info(r.str());
+    }
+
+    // mixins of all types and queries are stored here and referenced by spans
+    std::vector<const mixin_info*> buf;
+
+    // read a mixin list into buf and return its offset, or -1 if it has unregistered mixins
+    auto read_mixins = [&]() {
+        auto offset = buf.size();
+        auto num = r.count(sizeof(uint32_t));
+        bool valid = true;
+        for (uint32_t i = 0; i < num; ++i) {
+            auto index = r.u32();
+            if (index >= mixins.size()) r.bad();
+            if (!mixins[index]) valid = false;
+            buf.push_back(mixins[index]);
+        }
+        if (valid) return std::make_pair(offset, buf.size());
+        buf.resize(offset);
+        return std::make_pair(size_t(-1), size_t(-1));
+    };
+
+    const auto num_types = r.count(sizeof(uint32_t)); // num_mixins
+    std::vector<std::pair<size_t, size_t>> type_ranges; // offset, end in buf
+    std::vector<uint32_t> loaded_type_indices(num_types, uint32_t(-1)); // manifest index to loaded index
+    for (uint32_t i = 0; i < num_types; ++i) {
+        auto range = read_mixins();
+        if (range.first == size_t(-1)) continue;
+        loaded_type_indices[i] = uint32_t(type_ranges.size());
+        type_ranges.push_back(range);
+    }
+
+    const auto num_queries = r.count(2 * sizeof(uint32_t)); // num_mixins, type index
+    std::vector<std::pair<std::pair<size_t, size_t>, uint32_t>> query_ranges;
+    for (uint32_t i = 0; i < num_queries; ++i) {
+        auto range = read_mixins();
+        auto type_index = r.u32();
+        if (type_index >= num_types) r.bad();
+        if (range.first == size_t(-1)) continue;
+        auto loaded_index = loaded_type_indices[type_index];
+        if (loaded_index == uint32_t(-1)) continue;
+        query_ranges.emplace_back(range, loaded_index);
+    }
+
+    if (r.pos != manifest.size()) r.bad();
+
+    // buf is complete, so now we can make spans to it
+    auto to_span = [&](std::pair<size_t, size_t> range) {
+        return itlib::span<const mixin_info* const>(buf.data() + range.first, range.second - range.first);
+    };
+    std::vector<itlib::span<const mixin_info* const>> types;
+    types.reserve(type_ranges.size());
+    for (auto& range : type_ranges) types.push_back(to_span(range));
+    std::vector<domain::restored_query> queries;
+    queries.reserve(query_ranges.size());
+    for (auto& [range, index] : query_ranges) queries.push_back({to_span(range), index});
+
+    d.restore_types(types, queries);
+    return types.size();
+}
+
+}
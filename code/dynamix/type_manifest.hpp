@@ -0,0 +1,30 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#pragma once
+#include "../dnmx/api.h"
+#include "size.hpp"
+
+#include <itlib/span.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace dynamix {
+class domain;
+
+namespace util {
+// a type manifest is a compact binary dump of a domain's types and type queries
+// mixins in it are referenced by name, so it can be persisted and loaded on a later run
+// loading a manifest recreates the types and queries without running mutation rules
+// thus it's only valid if the mutation rules in the domain are the same as when it was saved
+// (which is the responsibility of the user)
+
+DYNAMIX_API std::vector<byte_t> save_type_manifest(const domain& d);
+
+// types and queries which reference mixins not registered in the domain are skipped
+// returns the number of loaded types
+// throws domain_error if the manifest is malformed
+DYNAMIX_API size_t load_type_manifest(domain& d, itlib::span<const byte_t> manifest);
+}
+}
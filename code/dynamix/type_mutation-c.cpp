@@ -46,6 +46,9 @@ bool dnmx_type_mutation_has(dnmx_type_mutation_handle hmut, const dnmx_mixin_inf
 const dnmx_mixin_info* dnmx_type_mutation_has_by_name(dnmx_type_mutation_handle hmut, dnmx_sv name) {
     return self->has(name.to_std());
 }
+bool dnmx_type_mutation_has_id(dnmx_type_mutation_handle hmut, dnmx_mixin_id id) {
+    return self->has(id);
+}
 bool dnmx_type_mutation_implements_strong(dnmx_type_mutation_handle hmut, const dnmx_feature_info* info) {
     return self->implements_strong(*info);
 }
@@ -109,6 +112,7 @@ const dnmx_mixin_info* const* dnmx_type_mutation_get_mixins(dnmx_type_mutation_h
 bool dnmx_type_mutation_set_mixins(dnmx_type_mutation_handle hmut, const dnmx_mixin_info* const* mixins, dnmx_mixin_index_t num_mixins) {
     try {
         self->mixins.assign(mixins, mixins + num_mixins);
+        self->mixins_changed();
         return true;
     }
     catch (std::exception&) {
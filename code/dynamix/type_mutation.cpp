@@ -5,6 +5,7 @@
 
 #include "type.hpp"
 #include "domain.hpp"
+#include "domain.from_info.hpp"
 #include "mixin_info.hpp"
 #include "feature_info.hpp"
 #include "feature_for_mixin.hpp"
@@ -13,14 +14,23 @@
 #include <itlib/qalgorithm.hpp>
 #include <itlib/stride_span.hpp>
 
+#include <algorithm>
+#include <new>
 #include <cassert>
 
 namespace dynamix {
 
 type_mutation::type_mutation(domain& d, const allocator& alloc) noexcept
-    : dom(d)
-    , mixins(alloc)
-{}
+    : m_mixins_resource(alloc.resource())
+    , m_index_resource(alloc.resource())
+    , dom(d)
+    , mixins(allocator(&m_mixins_resource))
+    , m_index(allocator(&m_index_resource))
+{
+    // take the inline buffers
+    mixins.reserve(inline_capacity);
+    m_index.reserve(inline_index_ids / 64);
+}
 
 type_mutation::type_mutation(const type& base, const allocator& alloc) noexcept
     : type_mutation(base.dom, alloc)
@@ -28,6 +38,71 @@ type_mutation::type_mutation(const type& base, const allocator& alloc) noexcept
     mixins.assign(base.mixins.begin(), base.mixins.end());
 }
 
+type_mutation::type_mutation(const type_mutation& other) noexcept
+    : type_mutation(other.dom, allocator(other.m_mixins_resource.upstream()))
+{
+    mixins.assign(other.mixins.begin(), other.mixins.end());
+}
+
+namespace {
+bool test_bit(const compat::pmr::vector<uint64_t>& index, dnmx_id_int_t i) noexcept {
+    const auto word = i / 64;
+    if (word >= index.size()) return false;
+    return index[word] & (uint64_t(1) << (i % 64));
+}
+bool set_bit(compat::pmr::vector<uint64_t>& index, dnmx_id_int_t i) {
+    const auto word = i / 64;
+    if (word >= index.size()) index.resize(word + 1, 0);
+    const auto bit = uint64_t(1) << (i % 64);
+    const bool was_set = index[word] & bit;
+    index[word] |= bit;
+    return !was_set;
+}
+void clear_bit(compat::pmr::vector<uint64_t>& index, dnmx_id_int_t i) noexcept {
+    const auto word = i / 64;
+    if (word >= index.size()) return;
+    index[word] &= ~(uint64_t(1) << (i % 64));
+}
+}
+
+bool type_mutation::indexed(const mixin_info& info) const noexcept {
+    // mixins of other domains may have the same ids as ours, so they are not indexed
+    return info.id != invalid_mixin_id && domain_from_info(info) == &dom;
+}
+
+bool type_mutation::sync_index() const noexcept {
+    if (m_indexed_size == mixins.size()) return true;
+
+    std::fill(m_index.begin(), m_index.end(), 0);
+    m_maybe_dups = false;
+    try {
+        for (auto m : mixins) {
+            if (!indexed(*m)) continue;
+            if (!set_bit(m_index, m->iid())) m_maybe_dups = true;
+        }
+    }
+    catch (std::bad_alloc&) {
+        m_indexed_size = not_indexed;
+        return false;
+    }
+    m_indexed_size = mixins.size();
+    return true;
+}
+
+void type_mutation::add(const mixin_info& info) {
+    if (!sync_index()) {
+        mixins.push_back(&info);
+        return;
+    }
+
+    // if anything below throws, the index will be rebuilt on the next query
+    m_indexed_size = not_indexed;
+    const bool new_bit = indexed(info) ? set_bit(m_index, info.iid()) : true;
+    mixins.push_back(&info);
+    if (!new_bit) m_maybe_dups = true;
+    m_indexed_size = mixins.size();
+}
+
 #define by_name [&](const auto* info) { return info->name == name; }
 
 static void do_to_back(compat::pmr::vector<const mixin_info*>::iterator i, compat::pmr::vector<const mixin_info*>& vec) {
@@ -54,19 +129,54 @@ const mixin_info& type_mutation::to_back(std::string_view name) {
 }
 
 bool type_mutation::remove(const mixin_info& info) noexcept {
-    return itlib::erase_first(mixins, &info);
+    if (!sync_index()) return itlib::erase_first(mixins, &info);
+
+    if (indexed(info)) {
+        if (!test_bit(m_index, info.iid())) return false;
+        itlib::erase_first(mixins, &info);
+        if (!m_maybe_dups || !itlib::pfind(mixins, &info)) {
+            clear_bit(m_index, info.iid());
+        }
+    }
+    else if (!itlib::erase_first(mixins, &info)) {
+        return false;
+    }
+
+    m_indexed_size = mixins.size();
+    return true;
 }
 const mixin_info* type_mutation::remove(std::string_view name) noexcept {
-    auto f = itlib::qfind_if(mixins, by_name);
-    if (f == mixins.end()) return nullptr;
+    auto f = itlib::pfind_if(mixins, by_name);
+    if (!f) return nullptr;
     auto ret = *f;
-    mixins.erase(f);
+    remove(*ret); // this will remove *f as it's the first entry of ret
     return ret;
 }
 bool type_mutation::has(const mixin_info& info) const noexcept {
+    if (indexed(info) && sync_index()) return test_bit(m_index, info.iid());
     return !!itlib::pfind(mixins, &info);
 }
+bool type_mutation::has(mixin_id id) const noexcept {
+    if (id == invalid_mixin_id) return false;
+    if (sync_index()) return test_bit(m_index, id.i);
+    return !!itlib::pfind_if(mixins, [&](const mixin_info* m) {
+        return m->id == id && indexed(*m);
+    });
+}
 const mixin_info* type_mutation::has(std::string_view name) const noexcept {
+    // in small mutations comparing the names is cheaper than the lookup in the domain (which locks)
+    if (mixins.size() > max_name_scan && !dom.settings().allow_duplicate_mixin_names) {
+        // names are unique, so we can look the mixin up in the domain's name index
+        if (auto info = dom.get_mixin_info(name)) {
+            return has(*info) ? info : nullptr;
+        }
+        // ... but the mutation may also have mixins which are not registered yet
+        auto f = itlib::pfind_if(mixins, [&](const mixin_info* info) {
+            return info->id == invalid_mixin_id && info->name == name;
+        });
+        if (f) return *f;
+        return nullptr;
+    }
     auto f = itlib::pfind_if(mixins, by_name);
     if (f) return *f;
     return nullptr;
@@ -83,6 +193,21 @@ bool type_mutation::implements_strong(const feature_info& info) const noexcept {
     return false;
 }
 const feature_info* type_mutation::implements_strong(std::string_view name) const noexcept {
+    if (!dom.settings().allow_duplicate_feature_names) {
+        // names are unique, so we can look the feature up in the domain's name index
+        if (auto info = dom.get_feature_info(name)) {
+            return implements_strong(*info) ? info : nullptr;
+        }
+        // ... but the mutation may also have mixins which are not registered yet (and so are their features)
+        for (auto m : mixins) {
+            if (m->id != invalid_mixin_id) continue;
+            auto features = m->features_span();
+            auto span = fspan(features);
+            auto f = itlib::pfind_if(span, by_name);
+            if (f) return *f;
+        }
+        return nullptr;
+    }
     for (auto m : mixins) {
         auto features = m->features_span();
         auto span = fspan(features);
@@ -122,22 +247,42 @@ const mixin_info* type_mutation::add_if_lacking(std::string_view name) {
 }
 
 void type_mutation::dedup() noexcept {
+    const bool use_index = sync_index();
+    if (use_index && !m_maybe_dups && std::all_of(mixins.begin(), mixins.end(), [&](const mixin_info* m) { return indexed(*m); })) {
+        // nothing to do
+        return;
+    }
+
     // first mark as null
-    for (auto i = mixins.begin(); i != mixins.end(); ++i) {
+    // go backwards, so that we can leave the latter entries
+    if (use_index) {
+        // the index is rebuilt as we go
+        std::fill(m_index.begin(), m_index.end(), 0);
+    }
+    for (auto i = mixins.rbegin(); i != mixins.rend(); ++i) {
         auto& info = *i;
         assert(info);
 
-        for (auto j = i + 1; j != mixins.end(); ++j) {
-            if (info == *j) {
-                // duplicate
-                // remove the earlier
-                info = nullptr;
-            }
+        if (use_index && indexed(*info)) {
+            // all bits were already allocated, so this won't throw
+            if (!set_bit(m_index, info->iid())) info = nullptr;
+            continue;
+        }
+
+        if (std::find(mixins.rbegin(), i, info) != i) {
+            // duplicate
+            // remove the earlier
+            info = nullptr;
         }
     }
 
     // then erase
     itlib::erase_all(mixins, nullptr);
+
+    if (use_index) {
+        m_maybe_dups = false;
+        m_indexed_size = mixins.size();
+    }
 }
 
 }
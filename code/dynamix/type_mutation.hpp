@@ -7,9 +7,11 @@
 #include "allocator.hpp"
 #include "feature_info_fwd.hpp"
 #include "mixin_info_fwd.hpp"
+#include "mixin_id.hpp"
 #include "globals.hpp"
 
 #include "compat/pmr/vector.hpp"
+#include "bits/inline_buffer_resource.hpp"
 
 #include <string_view>
 
@@ -20,20 +22,45 @@ class type;
 
 // a class which represents a type mutation in progress
 class DYNAMIX_API type_mutation {
+public:
+    // mutations with up to this many mixins don't allocate
+    // (the mixins are kept in an inline buffer)
+    static constexpr size_t inline_capacity = 16;
+
+    // the index of mixins by id doesn't allocate for ids up to this
+    static constexpr size_t inline_index_ids = 256;
+
+    // has and lacks by name search mutations with up to this many mixins without the domain
+    static constexpr size_t max_name_scan = 16;
+private:
+    bits::inline_buffer_resource<inline_capacity * sizeof(const mixin_info*), alignof(const mixin_info*)> m_mixins_resource;
+    bits::inline_buffer_resource<inline_index_ids / 8, alignof(uint64_t)> m_index_resource;
 public:
     domain& dom;
-    compat::pmr::vector<const mixin_info*> mixins; // mixins of the not yet materialized type
+
+    // mixins of the not yet materialized type
+    // they are indexed by id, which makes has/lacks (and the functions which use them) constant time
+    // the index is kept in sync by the member functions below
+    // if mixins are modified directly, the index is rebuilt on the next query if their number has changed
+    // modifications which keep the number of mixins, but change the set (permutations are fine),
+    // must be followed by a call to mixins_changed()
+    compat::pmr::vector<const mixin_info*> mixins;
 
     // start a mutation from the empty type
     // optionally provide an allocator for the type template
+    // (it is only used if the mixins don't fit in the inline buffer)
     explicit type_mutation(domain& d, const allocator& alloc = {}) noexcept;
 
     // start a mutation with a specific base
     // optionally provide an allocator for the type template
     explicit type_mutation(const type& base, const allocator& alloc = {}) noexcept;
 
+    // copying (and moving) copies the mixins to the new mutation's own buffer
+    type_mutation(const type_mutation& other) noexcept;
+    type_mutation& operator=(const type_mutation&) = delete;
+
     // add mixin
-    void add(const mixin_info& info) { mixins.push_back(&info); }
+    void add(const mixin_info& info);
     const mixin_info& add(std::string_view name); // can throw bad_mutation
     const mixin_info* safe_add(std::string_view name); // no bad_mutation if name is not a registered mixin
     template <typename Mixin>
@@ -73,14 +100,23 @@ public:
     // will leave the latter entry if a duplicate exists
     void dedup() noexcept;
 
+    // invalidate the index of mixins after a direct modification of mixins (see above)
+    void mixins_changed() noexcept { m_indexed_size = not_indexed; }
+
     // queries for the not yet materialized type
 
-    // these are linear searches so they may be slow
-    // we don't have the indexes of a complete type here
+    // has and lacks use the index of mixins
+    // (mixins which are not registered in the domain are not indexed, so for them these are linear searches)
+    // the ones by name compare the names of up to max_name_scan mixins
+    // for larger mutations they look the name up in the domain (which takes a lock)
     [[nodiscard]] bool has(const mixin_info& info) const noexcept;
     [[nodiscard]] const mixin_info* has(std::string_view name) const noexcept;
+    [[nodiscard]] bool has(mixin_id id) const noexcept;
     [[nodiscard]] bool lacks(const mixin_info& info) const noexcept { return !has(info); }
     [[nodiscard]] bool lacks(std::string_view name) const noexcept { return !has(name); }
+    [[nodiscard]] bool lacks(mixin_id id) const noexcept { return !has(id); }
+
+    // features are not indexed: these are linear searches so they may be slow
     [[nodiscard]] bool implements_strong(const feature_info& info) const noexcept;
     [[nodiscard]] const feature_info* implements_strong(std::string_view name) const noexcept;
     [[nodiscard]] bool implements(const feature_info& info) const noexcept;
@@ -97,6 +133,20 @@ public:
 
     dnmx_type_mutation_handle to_c_hanlde() noexcept { return reinterpret_cast<dnmx_type_mutation_handle>(this); }
     static type_mutation* from_c_handle(dnmx_type_mutation_handle ha) noexcept { return reinterpret_cast<type_mutation*>(ha); }
+
+private:
+    // a bit per mixin id for the mixins which are registered in the domain
+    mutable compat::pmr::vector<uint64_t> m_index;
+
+    // the number of mixins when the index was last synced with them
+    static constexpr size_t not_indexed = ~size_t(0);
+    mutable size_t m_indexed_size = 0;
+
+    // set when an indexed mixin is added more than once
+    mutable bool m_maybe_dups = false;
+
+    bool indexed(const mixin_info& info) const noexcept;
+    bool sync_index() const noexcept; // returns false if the index can't be used
 };
 
 // create a type mutation from list of mixins
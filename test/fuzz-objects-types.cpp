@@ -7,6 +7,8 @@
 #include <dynamix/mutate.hpp>
 #include <dynamix/exception.hpp>
 #include <dynamix/dbg_dmp.hpp>
+#include <dynamix/domain_traverse.hpp>
+#include <dynamix/type.hpp>
 
 #include <doctest/doctest.h>
 #include <doctest/util/random.hpp>
@@ -53,6 +55,7 @@ struct object_producer {
     std::minstd_rand rnd;
     std::vector<dynamix::object> objects;
     std::vector<dynamix::object> copies;
+    std::vector<dynamix::object> mutated;
 
     object_producer(dynamix::domain& d, const std::deque<dynamix::util::mixin_info_data>& mix, uint32_t seed)
         : dom(d)
@@ -108,10 +111,73 @@ struct object_producer {
             }
         }
     }
+
+    // mutate objects by adding and removing single mixins
+    // this will create types whose ftables are derived from the ftables of existing ones
+    void mutate() {
+        if (objects.empty()) return;
+        for (int i = 0; i < SIZE; ++i) {
+            dynamix::object o(dom);
+            o.reset_type(objects[rnd() % objects.size()].get_type());
+            for (int j = 0; j < 5; ++j) {
+                auto& t = o.get_type();
+                try {
+                    if (t.mixins.empty() || rnd() % 2) {
+                        dynamix::mutate(o, dynamix::add(mixins[rnd() % mixins.size()].info));
+                    }
+                    else {
+                        dynamix::mutate(o, dynamix::remove(*t.mixins[rnd() % t.mixins.size()]));
+                    }
+                }
+                catch (const dynamix::exception&) {
+                    // clashes, mixins without default init...
+                }
+            }
+            mutated.push_back(std::move(o));
+        }
+    }
 };
 
+// check a type's ftable against one built from scratch here
+bool ftable_matches_full_build(const dynamix::type& t) {
+    std::vector<std::vector<dynamix::type::ftable_payload>> expected;
+    for (dynamix::mixin_index_t i = 0; i < t.mixins.size(); ++i) {
+        for (auto& f : t.mixins[i]->features_span()) {
+            auto fid = f.info->iid();
+            if (fid >= expected.size()) expected.resize(fid + 1);
+            expected[fid].push_back({i, f.payload, &f});
+        }
+    }
+    if (expected.size() != t.ftable_length) return false;
+
+    for (size_t fid = 0; fid < expected.size(); ++fid) {
+        auto& ex = expected[fid];
+        auto& entry = t.ftable[fid];
+        if (ex.empty()) {
+            if (entry.begin || entry.top_bid_back || entry.end) return false;
+            continue;
+        }
+
+        std::sort(ex.begin(), ex.end(), [](const dynamix::type::ftable_payload& a, const dynamix::type::ftable_payload& b) {
+            if (a.data->bid != b.data->bid) return a.data->bid > b.data->bid;
+            if (a.data->priority != b.data->priority) return a.data->priority < b.data->priority;
+            return a.mixin_index > b.mixin_index;
+        });
+        size_t top_bid_back = 0;
+        while (top_bid_back + 1 < ex.size() && ex[top_bid_back + 1].data->bid == ex[0].data->bid) ++top_bid_back;
+
+        if (size_t(entry.end - entry.begin) != ex.size()) return false;
+        if (size_t(entry.top_bid_back - entry.begin) != top_bid_back) return false;
+        for (size_t i = 0; i < ex.size(); ++i) {
+            auto& pl = entry.begin[i];
+            if (pl.mixin_index != ex[i].mixin_index || pl.payload != ex[i].payload || pl.data != ex[i].data) return false;
+        }
+    }
+    return true;
+}
+
 class custom_rule {
-    dynamix::mutation_rule_info m_info;
+    dynamix::mutation_rule_info m_info = {};
     const dynamix::mixin_info& m_primary;
     const dynamix::mixin_info& m_dep;
     bool m_use_primary_name;
@@ -364,7 +430,10 @@ TEST_CASE("fuzz objects and types") {
 
     std::vector<std::thread> threads;
     for (auto& p : producers) {
-        threads.emplace_back([&]() { p.produce(); });
+        threads.emplace_back([&]() {
+            p.produce();
+            p.mutate();
+        });
     }
 
     for (auto& t : threads) {
@@ -383,4 +452,10 @@ TEST_CASE("fuzz objects and types") {
             ++ci;
         }
     }
+
+    int mismatches = 0;
+    dynamix::domain_traverse(dom).traverse_types([&](const dynamix::type& t) {
+        if (!ftable_matches_full_build(t)) ++mismatches;
+    });
+    CHECK(mismatches == 0);
 }
@@ -0,0 +1,59 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include <dynamix/bits/inline_buffer_resource.hpp>
+#include <dynamix/compat/pmr/vector.hpp>
+#include <doctest/doctest.h>
+
+#include <cstdlib>
+
+using namespace dynamix;
+
+class counting_resource final : public compat::pmr::memory_resource {
+public:
+    int num_allocs = 0;
+    int num_live = 0;
+private:
+    void* do_allocate(std::size_t bytes, std::size_t) override {
+        ++num_allocs;
+        ++num_live;
+        return std::malloc(bytes);
+    }
+    void do_deallocate(void* p, std::size_t, std::size_t) override {
+        --num_live;
+        std::free(p);
+    }
+    bool do_is_equal(const compat::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST_CASE("inline_buffer_resource") {
+    counting_resource upstream;
+    {
+        bits::inline_buffer_resource<4 * sizeof(int), alignof(int)> buf(&upstream);
+        CHECK(buf.upstream() == &upstream);
+
+        compat::pmr::vector<int> vec(&buf);
+        vec.reserve(4);
+        vec.assign({1, 2, 3, 4});
+        CHECK(upstream.num_allocs == 0);
+
+        // grows beyond the buffer
+        vec.push_back(5);
+        CHECK(upstream.num_allocs == 1);
+        CHECK(upstream.num_live == 1);
+        CHECK(vec.size() == 5);
+        CHECK(vec.front() == 1);
+        CHECK(vec.back() == 5);
+
+        // the buffer is free again
+        compat::pmr::vector<int>(&buf).swap(vec);
+        CHECK(upstream.num_live == 0);
+        vec.reserve(3);
+        vec.push_back(6);
+        CHECK(upstream.num_allocs == 1);
+        CHECK(vec.front() == 6);
+    }
+    CHECK(upstream.num_live == 0);
+}
@@ -107,3 +107,53 @@ TEST_CASE("register all features") {
     CHECK_FALSE(d.get_feature_info("update_actor"));
     CHECK_FALSE(d.get_feature_info("can_move_to"));
 }
+
+TEST_CASE("register features batch") {
+    test_data t;
+    domain d;
+
+    {
+        feature_info ua2 = dnmx_make_feature_info();
+        ua2.name = dnmx_make_sv_lit("update_actor");
+        feature_info* infos[] = {t.render, t.update_actor, &ua2};
+        CHECK_THROWS_WITH_AS(d.register_features(infos), "unnamed domain: register feature with duplicate name 'update_actor'", domain_error);
+        for (auto i : infos) {
+            CHECK(i->id == invalid_feature_id);
+        }
+    }
+
+    feature_info* infos[] = {t.render, t.update_actor, t.get_name};
+    d.register_features(infos);
+    CHECK(t.render->iid() == 0);
+    CHECK(t.update_actor->iid() == 1);
+    CHECK(t.get_name->iid() == 2);
+    CHECK(d.get_feature_info("get_name") == t.get_name);
+
+    d.unregister_feature(*t.render);
+    feature_info* reg[] = {t.move_to, t.get_hp};
+    d.register_features(reg);
+    CHECK(t.move_to->iid() == 0);
+    CHECK(t.get_hp->iid() == 3);
+}
+
+TEST_CASE("register dupes features batch") {
+    domain_settings s = {};
+    s.allow_duplicate_feature_names = true;
+    domain d({}, s);
+
+    feature_info e = dnmx_make_feature_info();
+    feature_info* infos[] = {&e, &e};
+    CHECK_THROWS_WITH_AS(d.register_features(infos), "unnamed domain: register feature '' more than once", domain_error);
+    CHECK(e.id == invalid_feature_id);
+
+    feature_info aa = dnmx_make_feature_info();
+    aa.name = dnmx_make_sv_lit("aa");
+    feature_info aa2 = dnmx_make_feature_info();
+    aa2.name = dnmx_make_sv_lit("aa");
+    feature_info* reg[] = {&e, &aa, &aa2};
+    d.register_features(reg);
+    CHECK(e.iid() == 0);
+    CHECK(aa.iid() == 1);
+    CHECK(aa2.iid() == 2);
+    CHECK(d.get_feature_info("aa") == &aa);
+}
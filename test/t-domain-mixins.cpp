@@ -166,4 +166,79 @@ TEST_CASE("register dupe mixins") {
 
     CHECK(dom.get_mixin_info(t.movable->id) == t.movable);
     CHECK(dom.get_mixin_info(dup.id) == &dup);
+
+    // the first one is found by name in domains and types
+    CHECK(dom.get_mixin_info("movable") == t.movable);
+    {
+        const mixin_info* md[] = {t.movable, &dup};
+        auto& type = dom.get_type(md);
+        CHECK(type.index_of("movable") == 0);
+        const mixin_info* dm[] = {&dup, t.movable};
+        auto& type2 = dom.get_type(dm);
+        CHECK(type2.index_of("movable") == 0);
+        CHECK(type2.has("movable"));
+        CHECK(type2.implements_strong("move_to"));
+        CHECK_FALSE(type2.implements_strong("render"));
+        CHECK_FALSE(type2.has("mesh"));
+    }
+
+    // ... and the one with the lowest id when it's unregistered
+    const auto movable_id = t.movable->id;
+    dom.unregister_mixin(*t.movable);
+    CHECK(dom.get_mixin_info("movable") == &dup);
+    dom.register_mixin(*t.movable);
+    CHECK(t.movable->id == movable_id);
+    CHECK(dom.get_mixin_info("movable") == t.movable);
+    dom.unregister_mixin(dup);
+    CHECK(dom.get_mixin_info("movable") == t.movable);
+    dom.unregister_mixin(*t.movable);
+    CHECK_FALSE(dom.get_mixin_info("movable"));
+}
+
+TEST_CASE("register mixins") {
+    test_data t;
+    domain dom("test");
+
+    {
+        // nothing is registered if any mixin fails
+        mixin_info m2 = dnmx_make_mixin_info();
+        m2.name = dnmx_sv::from_std("movable");
+        mixin_info* infos[] = {t.mesh, t.movable, &m2};
+        CHECK_THROWS_WITH_AS(dom.register_mixins(infos), "test: register mixin with duplicate name 'movable'", domain_error);
+        for (auto i : infos) {
+            CHECK(i->id == invalid_mixin_id);
+            CHECK_FALSE(domain_from_info(*i));
+        }
+        CHECK_FALSE(dom.get_mixin_info("movable"));
+        CHECK(t.set_position->id == invalid_feature_id);
+        CHECK(t.render->id == invalid_feature_id);
+    }
+
+    mixin_info* infos[] = {t.mesh, t.movable, t.ai, t.stats};
+    dom.register_mixins(infos);
+    for (uint32_t i = 0; i < std::size(infos); ++i) {
+        CHECK(infos[i]->iid() == i);
+        CHECK(domain_from_info(*infos[i]) == &dom);
+        CHECK(dom.get_mixin_info(infos[i]->name.to_std()) == infos[i]);
+        for (auto& f : infos[i]->features_span()) {
+            CHECK(dom.get_feature_info(f.info->name.to_std()) == f.info);
+        }
+    }
+
+    // the lowest ids are reused
+    mixin_info* unreg[] = {t.stats, t.movable};
+    dom.unregister_mixins(unreg);
+    mixin_info* reg[] = {t.invisible, t.flyer, t.immaterial};
+    dom.register_mixins(reg);
+    CHECK(t.invisible->iid() == 1);
+    CHECK(t.flyer->iid() == 3);
+    CHECK(t.immaterial->iid() == 4);
+
+    // registered mixins can't be registered again
+    mixin_info* again[] = {t.movable, t.mesh};
+    CHECK_THROWS_WITH_AS(dom.register_mixins(again), "test: register mixin 'mesh' with a valid id 0", domain_error);
+    CHECK(t.movable->id == invalid_mixin_id);
+
+    dom.register_mixins({}); // noop
+    CHECK(dom.get_mixin_info(mixin_id{5}) == nullptr);
 }
@@ -3,9 +3,17 @@
 //
 #include "test_data.hpp"
 
+#include <dynamix/mutation_rule_info.hpp>
+#include <dynamix/exception.hpp>
+#include <dynamix/object.hpp>
+
 #include <doctest/doctest.h>
 
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace dynamix;
 
@@ -107,3 +115,265 @@ TEST_CASE("mixins") {
         CHECK(&m.info == dom.get_mixin_info(m.info.name.to_std()));
     }
 }
+
+TEST_CASE("mixins by id") {
+    domain dom;
+
+    // enough mixins to span many chunks of the registry
+    std::vector<std::string> names(1000);
+    std::vector<mixin_info> infos(names.size(), dnmx_make_mixin_info());
+    for (size_t i = 0; i < infos.size(); ++i) {
+        names[i] = "m" + std::to_string(i);
+        infos[i].name = dnmx_sv::from_std(names[i]);
+    }
+
+    std::atomic_bool done = false;
+    std::thread writer([&]() {
+        for (int r = 0; r < 3; ++r) {
+            for (auto& m : infos) dom.register_mixin(m);
+            for (size_t i = 0; i < infos.size(); i += 2) dom.unregister_mixin(infos[i]);
+            for (size_t i = 0; i < infos.size(); i += 2) dom.register_mixin(infos[i]);
+            for (auto& m : infos) dom.unregister_mixin(m);
+        }
+        done = true;
+    });
+    std::thread reader([&]() {
+        int bad = 0;
+        while (!done) {
+            for (uint32_t i = 0; i < infos.size() + 10; ++i) {
+                auto m = dom.get_mixin_info(mixin_id{i});
+                if (m && (m < infos.data() || m >= infos.data() + infos.size())) ++bad;
+            }
+        }
+        CHECK(bad == 0);
+    });
+    writer.join();
+    reader.join();
+
+    for (auto& m : infos) {
+        dom.register_mixin(m);
+        CHECK(dom.get_mixin_info(m.id) == &m);
+    }
+}
+
+TEST_CASE("types") {
+    domain dom;
+    test_data t;
+    t.register_all_mixins(dom);
+
+    const std::vector<std::vector<const mixin_info*>> queries = {
+        {t.movable},
+        {t.mesh},
+        {t.ai, t.stats, t.immaterial, t.mesh},
+        {t.ai, t.flyer, t.mesh, t.invisible},
+        {t.actor, t.controlled, t.physical},
+        {t.physical, t.procedural_geometry},
+    };
+
+    // adding and removing rules invalidates stored queries while others look them up
+    auto noop = [](dnmx_type_mutation_handle, uintptr_t) { return dnmx_result_success; };
+    mutation_rule_info rule = {dnmx_make_sv_lit("noop"), noop, 0, 0};
+
+    std::atomic_bool done = false;
+    std::thread rules([&]() {
+        for (int i = 0; i < 200; ++i) {
+            dom.add_mutation_rule(rule);
+            dom.remove_mutation_rule(rule);
+        }
+        done = true;
+    });
+
+    auto get_types = [&]() {
+        int mismatches = 0;
+        do {
+            for (auto& q : queries) {
+                auto& type = dom.get_type(q);
+                if (!std::equal(q.begin(), q.end(), type.mixins.begin(), type.mixins.end())) ++mismatches;
+                if (q.size() == 1 && &dom.get_type_with(dom.get_empty_type(), *q.front()) != &type) ++mismatches;
+            }
+        } while (!done);
+        CHECK(mismatches == 0);
+    };
+    std::thread a(get_types);
+    std::thread b(get_types);
+
+    rules.join();
+    a.join();
+    b.join();
+
+    for (auto& q : queries) {
+        auto& type = dom.get_type(q);
+        CHECK(std::equal(q.begin(), q.end(), type.mixins.begin(), type.mixins.end()));
+    }
+    CHECK(dom.num_types() == queries.size());
+    CHECK(dom.num_type_queries() == queries.size());
+}
+
+TEST_CASE("single-flight types") {
+    domain dom;
+    test_data t;
+    t.register_all_mixins(dom);
+
+    // a rule which makes all threads meet before any of them looks up the type
+    // since they're all holding a shared lock, none can add the type before the others look for it
+    static constexpr int num_threads = 4;
+    std::atomic_int arrived = 0;
+    auto barrier = [](dnmx_type_mutation_handle, uintptr_t user_data) {
+        auto& a = *reinterpret_cast<std::atomic_int*>(user_data);
+        ++a;
+        while (a < num_threads) std::this_thread::yield();
+        return dnmx_result_success;
+    };
+    mutation_rule_info rule = {dnmx_make_sv_lit("barrier"), barrier, reinterpret_cast<uintptr_t>(&arrived), 0};
+    dom.add_mutation_rule(rule);
+
+    const mixin_info* q[] = {t.movable, t.mesh, t.invisible};
+    std::vector<const type*> results(num_threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i]() {
+            results[i] = &dom.get_type(q);
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    // one built the type, the others waited for it
+    CHECK(dom.num_types() == 1);
+    CHECK(dom.num_avoided_type_builds() == num_threads - 1);
+    for (auto r : results) {
+        CHECK(r == results.front());
+    }
+    CHECK(std::equal(std::begin(q), std::end(q), results.front()->mixins.begin(), results.front()->mixins.end()));
+
+    dom.remove_mutation_rule(rule);
+}
+
+TEST_CASE("gc on zero objects") {
+    domain dom;
+    test_data t;
+    t.register_all_mixins(dom);
+
+    type_gc_policy policy;
+    policy.on_zero_objects = true;
+    dom.set_type_gc_policy(policy);
+
+    // each thread uses its own types, so they can't be collected before objects are created
+    // but lookups of one thread go through queries which the other one erases
+    using queries = std::vector<std::vector<const mixin_info*>>;
+    const queries qa = {{t.movable}, {t.mesh}, {t.ai, t.stats}, {t.ai, t.flyer, t.mesh, t.invisible}};
+    const queries qb = {{t.controlled}, {t.immaterial}, {t.procedural_geometry, t.invisible}, {t.controlled, t.invulnerable, t.immaterial}};
+
+    auto churn = [&](const queries& qs) {
+        int mismatches = 0;
+        for (int i = 0; i < 200; ++i) {
+            for (auto& q : qs) {
+                object obj(dom.get_type(q));
+                auto& type = obj.get_type();
+                if (!std::equal(q.begin(), q.end(), type.mixins.begin(), type.mixins.end())) ++mismatches;
+            }
+        }
+        CHECK(mismatches == 0);
+    };
+    std::thread a([&]() { churn(qa); });
+    std::thread b([&]() { churn(qb); });
+    a.join();
+    b.join();
+
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.num_type_queries() == 0);
+}
+
+TEST_CASE("gc while getting types") {
+    domain dom;
+    test_data t;
+    t.register_all_mixins(dom);
+
+    // automatic collections run while the threads get types
+    // types which are returned while being collected survive and returned types are pinned until they get objects
+    // (the threads share the types, so each collection races with lookups of the other thread)
+    type_gc_policy policy;
+    policy.on_zero_objects = true;
+    policy.memory_threshold = 1;
+    policy.step_budget = 4;
+    dom.set_type_gc_policy(policy);
+
+    const std::vector<std::vector<const mixin_info*>> queries = {
+        {t.movable}, {t.mesh}, {t.ai, t.stats}, {t.ai, t.flyer, t.mesh},
+    };
+
+    auto get_types = [&]() {
+        int mismatches = 0;
+        for (int i = 0; i < 500; ++i) {
+            for (auto& q : queries) {
+                object obj(dom.get_type(q));
+                auto& type = obj.get_type();
+                object with(dom.get_type_with(type, *t.invisible));
+                if (!std::equal(q.begin(), q.end(), type.mixins.begin(), type.mixins.end())) ++mismatches;
+                if (!with.get_type().has(*t.invisible)) ++mismatches;
+            }
+        }
+        CHECK(mismatches == 0);
+    };
+    std::thread a(get_types);
+    std::thread b(get_types);
+    a.join();
+    b.join();
+
+    policy = {};
+    dom.set_type_gc_policy(policy);
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.num_type_queries() == 0);
+}
+
+TEST_CASE("prewarm types") {
+    domain dom;
+    test_data t;
+    t.register_all_mixins(dom);
+
+    using query = itlib::span<const mixin_info* const>;
+
+    const mixin_info* m[] = {t.movable};
+    const mixin_info* asim[] = {t.ai, t.stats, t.immaterial, t.mesh};
+    const mixin_info* afmi[] = {t.ai, t.flyer, t.mesh, t.invisible};
+    const mixin_info* acp[] = {t.actor, t.controlled, t.physical};
+    const mixin_info* pg[] = {t.physical, t.procedural_geometry};
+    const mixin_info* gp[] = {t.procedural_geometry, t.physical};
+    const query queries[] = {m, asim, afmi, acp, pg, asim, gp, {}};
+
+    dom.get_type(acp); // one exists
+
+    dom.prewarm_types(queries);
+    CHECK(dom.num_types() == 6);
+    CHECK(dom.num_type_queries() == 7);
+
+    for (auto& q : queries) {
+        auto& type = dom.get_type(q);
+        CHECK(std::equal(q.begin(), q.end(), type.mixins.begin(), type.mixins.end()));
+    }
+    CHECK(dom.num_types() == 6);
+    CHECK(dom.num_type_queries() == 7);
+
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+
+    int num_jobs = 0;
+    dom.prewarm_types(queries, [&](size_t n, const std::function<void(size_t)>& job) {
+        num_jobs = int(n);
+        std::thread a([&]() { for (size_t i = 0; i < n; i += 2) job(i); });
+        std::thread b([&]() { for (size_t i = 1; i < n; i += 2) job(i); });
+        a.join();
+        b.join();
+    });
+    CHECK(num_jobs == 8);
+    CHECK(dom.num_types() == 6);
+    CHECK(dom.num_type_queries() == 7);
+
+    dom.garbage_collect_types();
+
+    const mixin_info* clash[] = {t.flyer, t.walker};
+    const query bad[] = {m, clash, asim};
+    CHECK_THROWS_AS(dom.prewarm_types(bad), type_error);
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.num_type_queries() == 1); // empty query to empty type
+}
@@ -30,6 +30,9 @@ DYNAMIX_DECLARE_MSG(uni_vec_msg, uni_vec, void, (test_obj&, std::vector<int>));
 DYNAMIX_DECLARE_MSG(multi_arg_msg, multi_arg, void, (test_obj&, lc_arg));
 DYNAMIX_DECLARE_MSG(inherited_msg, inherited_func, int, (const test_obj&, int));
 DYNAMIX_DECLARE_MSG(fill_vec_msg, fill_vec, void, (const test_obj&, std::vector<int>&));
+DYNAMIX_DECLARE_MSG(cached_uni_msg, cached_uni, int, (const test_obj&, int));
+DYNAMIX_DECLARE_MSG(cached_multi_msg, cached_multi, int, (const test_obj&, int&));
+DYNAMIX_DECLARE_MSG(batched_msg, batched, void, (test_obj&, int));
 
 #include <dynamix/declare_domain.hpp>
 
@@ -240,6 +243,56 @@ TEST_CASE("next impl") {
     }
 }
 
+TEST_CASE("cached") {
+    using namespace dynamix::mutate_ops;
+    test_obj a, b;
+    mutate(a, add<common>());
+    mutate(b, add<over>());
+
+    CHECK(cached_uni(a, 1) == 1);
+    CHECK(cached_uni(b, 1) == 102);
+    CHECK(cached_uni(a, 2) == 2);
+    CHECK(cached_uni(b, 2) == 103);
+
+    mutate(a, add<over>());
+    CHECK(cached_uni(a, 1) == 102); // overriden
+
+    test_obj empty;
+    CHECK(empty.get_type().serial != 0); // would match unused cache entries
+    CHECK_THROWS_WITH_AS(cached_uni(empty, 1),
+        "msgt: {} does not implement dynamix msg 'cached_uni_msg'",
+        dynamix::feature_error);
+    CHECK(cached_uni(b, 0) == 101);
+
+    {
+        // types are collected and new ones may take their place
+        const auto serial = b.get_type().serial;
+        mutate(a, remove<over>());
+        mutate(b, remove<over>(), add<common>());
+        dynamix::g::get_domain<test>().garbage_collect_types();
+        CHECK(cached_uni(b, 1) == 1);
+        mutate(b, remove<common>(), add<over>());
+        CHECK(b.get_type().serial != serial);
+        CHECK(cached_uni(b, 1) == 102);
+        CHECK(cached_uni(a, 1) == 1);
+    }
+
+    {
+        test_obj mc;
+        mutate(mc, add<multicaster>(5));
+        int sum = 0;
+        CHECK(cached_multi(mc, sum) == 5);
+        CHECK(cached_multi(a, sum) == 0);
+        CHECK(sum == 5);
+        mutate(mc, add<common>());
+        CHECK(cached_multi(mc, sum) == 0);
+        CHECK(sum == 10);
+        CHECK(cached_multi(a, sum) == 0);
+        CHECK(cached_multi(mc, sum) == 0);
+        CHECK(sum == 15);
+    }
+}
+
 #include <dynamix/msg/func_traits.hpp>
 
 DYNAMIX_MAKE_FUNC_TRAITS(overloaded);
@@ -247,6 +300,9 @@ DYNAMIX_MAKE_FUNC_TRAITS(uni_vec);
 DYNAMIX_MAKE_FUNC_TRAITS(multi_arg);
 DYNAMIX_MAKE_FUNC_TRAITS(inherited_func);
 DYNAMIX_MAKE_FUNC_TRAITS(fill_vec);
+DYNAMIX_MAKE_FUNC_TRAITS(cached_uni);
+DYNAMIX_MAKE_FUNC_TRAITS(cached_multi);
+DYNAMIX_MAKE_FUNC_TRAITS(batched);
 
 #include <dynamix/define_mixin.hpp>
 #include <dynamix/msg/next_impl.hpp>
@@ -277,6 +333,12 @@ DYNAMIX_DEFINE_MIXIN(test, common)
     .implements_by<simple_multi_arg>([](common* cmn, lc_arg arg) {
         cmn->val = arg.val;
     })
+    .implements_by<cached_uni_msg>([](const common* cmn, int i) { return cmn->val + i; })
+    .implements_by<cached_multi_msg>([](const common* cmn, int& sum) {
+        sum += cmn->val;
+        return cmn->val;
+    })
+    .implements_by<batched_msg>([](common* cmn, int i) { cmn->val = i; })
 ;
 
 struct get_ptr_clash {};
@@ -307,6 +369,12 @@ DYNAMIX_DEFINE_MIXIN(test, over)
         sum += 10;
         return 10;
     }, -1_bid)
+    .implements_by<cached_uni_msg>([](const over* o, int i) { return o->val + i; })
+    .implements_by<batched_msg>([](over* o, int i) { o->val = i; })
+    .implements_batch_by<batched_msg>([](itlib::span<over*> overs, int i) {
+        // the size of the batch is visible
+        for (auto o : overs) o->val = i + int(overs.size());
+    })
     ;
 
 DYNAMIX_DEFINE_MIXIN(test, multicaster)
@@ -317,6 +385,10 @@ DYNAMIX_DEFINE_MIXIN(test, multicaster)
     .implements_by<simple_multi_arg>([](multicaster* mc, lc_arg arg) {
         mc->val = arg.val;
     })
+    .implements_by<cached_multi_msg>([](const multicaster* mc, int& sum) {
+        sum += mc->val;
+        return mc->val;
+    })
 ;
 
 class next_impl {
@@ -368,7 +440,159 @@ DYNAMIX_DEFINE_MSG_EX(uni_vec_msg, unicast, false, nullptr, uni_vec, void, (test
 DYNAMIX_DEFINE_MSG(multi_arg_msg, multicast, multi_arg, void, (test_obj&, lc_arg));
 DYNAMIX_DEFINE_MSG(inherited_msg, unicast, inherited_func, int, (const test_obj&, int));
 DYNAMIX_DEFINE_MSG(fill_vec_msg, multicast, fill_vec, void, (const test_obj&, std::vector<int>&));
+DYNAMIX_DEFINE_CACHED_MSG(cached_uni_msg, unicast, 1, cached_uni, int, (const test_obj&, int));
+DYNAMIX_DEFINE_CACHED_MSG(cached_multi_msg, multicast, 2, cached_multi, int, (const test_obj&, int&));
+DYNAMIX_DEFINE_MSG(batched_msg, unicast, batched, void, (test_obj&, int));
 
 #include <dynamix/define_domain.hpp>
 
 DYNAMIX_DEFINE_DOMAIN(test, "msgt");
+
+TEST_CASE("batch") {
+    using namespace dynamix::mutate_ops;
+    std::vector<test_obj> objs(7);
+    for (auto i : {0, 1, 4, 5}) mutate(objs[i], add<over>());
+    for (auto i : {2, 3, 6}) mutate(objs[i], add<common>());
+    overloaded(objs[5], 5);
+
+    int results[7] = {};
+    cached_uni_msg::traits::call_unicast_batch(itlib::span(objs), results, 1);
+    CHECK(results[0] == 102);
+    CHECK(results[1] == 102);
+    CHECK(results[2] == 1);
+    CHECK(results[3] == 1);
+    CHECK(results[4] == 102);
+    CHECK(results[5] == 6);
+    CHECK(results[6] == 1);
+
+    // void and same args for all
+    std::vector<int> vec = {1, 2, 3};
+    uni_vec_msg::traits::call_unicast_batch(itlib::span(objs), nullptr, vec);
+    CHECK(vec.size() == 3);
+    cached_uni_msg::traits::call_unicast_batch(itlib::span(objs), nullptr, 1); // discard results
+
+    // pointers
+    std::vector<const test_obj*> ptrs;
+    for (auto i = objs.rbegin(); i != objs.rend(); ++i) ptrs.push_back(&*i);
+    cached_uni_msg::traits::call_unicast_batch(itlib::span(ptrs), results, 2);
+    CHECK(results[0] == 2);
+    CHECK(results[1] == 5);
+    CHECK(results[2] == 5);
+    CHECK(results[3] == 2);
+    CHECK(results[4] == 2);
+    CHECK(results[5] == 5);
+    CHECK(results[6] == 5);
+
+    // default payloads
+    test_obj empty;
+    ptrs = {&objs[0], &empty, &empty, &objs[1]};
+    const void* ptr_results[4] = {};
+    get_ptr::traits::call_unicast_batch(itlib::span(ptrs), ptr_results);
+    CHECK(ptr_results[0] == get_ptr::call(objs[0]));
+    CHECK(ptr_results[1] == &empty);
+    CHECK(ptr_results[2] == &empty);
+    CHECK(ptr_results[3] == get_ptr::call(objs[1]));
+
+    // missing implementation
+    ptrs = {&objs[0], &objs[2], &empty, &objs[3]};
+    results[3] = 0;
+    CHECK_THROWS_WITH_AS(cached_uni_msg::traits::call_unicast_batch(itlib::span(ptrs), results, 3),
+        "msgt: {} does not implement dynamix msg 'cached_uni_msg'",
+        dynamix::feature_error);
+    CHECK(results[0] == 6);
+    CHECK(results[1] == 3);
+    CHECK(results[3] == 0); // not called
+
+    // multicast
+    std::vector<test_obj> mcs(3);
+    mutate(mcs[0], add<multicaster>(3));
+    mutate(mcs[1], add<multicaster>(4));
+    mutate(mcs[2], add<multicaster>(5), add<common>());
+    int sum = 0;
+    simple_mc::traits::call_multicast_batch(itlib::span(mcs), results, sum);
+    CHECK(sum == 12);
+    CHECK(results[0] == 3);
+    CHECK(results[1] == 4);
+    CHECK(results[2] == 0);
+}
+
+TEST_CASE("batch payloads") {
+    using namespace dynamix::mutate_ops;
+    std::vector<test_obj> objs(5);
+    for (auto i : {0, 1, 3, 4}) mutate(objs[i], add<over>());
+    mutate(objs[2], add<common>());
+
+    batched(objs[0], 5); // scalar
+    CHECK(objs[0].get<over>()->val == 5);
+
+    batched_msg::traits::call_unicast_batch(itlib::span(objs), nullptr, 100);
+    CHECK(objs[0].get<over>()->val == 102);
+    CHECK(objs[1].get<over>()->val == 102);
+    CHECK(objs[2].get<common>()->val == 100);
+    CHECK(objs[3].get<over>()->val == 102);
+    CHECK(objs[4].get<over>()->val == 102);
+
+    std::vector<test_obj*> ptrs = {&objs[0], &objs[2], &objs[1]};
+    batched_msg::traits::call_unicast_batch(itlib::span(ptrs), nullptr, 10);
+    CHECK(objs[0].get<over>()->val == 11);
+    CHECK(objs[1].get<over>()->val == 11);
+    CHECK(objs[2].get<common>()->val == 10);
+
+    // big groups are split in chunks
+    constexpr size_t chunk = batched_msg::traits::caller::batch_chunk_size;
+    std::vector<test_obj> many(chunk + 3);
+    for (auto& o : many) mutate(o, add<over>());
+    batched_msg::traits::call_unicast_batch(itlib::span(many), nullptr, 0);
+    CHECK(many.front().get<over>()->val == int(chunk));
+    CHECK(many[chunk - 1].get<over>()->val == int(chunk));
+    CHECK(many[chunk].get<over>()->val == 3);
+    CHECK(many.back().get<over>()->val == 3);
+
+    // a batch payload of a feature which the mixin doesn't implement
+    dynamix::util::mixin_info_data data;
+    dynamix::util::mixin_info_data_builder<over> b(data, "over_batch");
+    CHECK_THROWS_WITH_AS(b.implements_batch_by<batched_msg>([](itlib::span<over*>, int) {}),
+        "'over_batch': batch payload for 'batched_msg' which is not implemented",
+        dynamix::feature_error);
+    b.implements_by<batched_msg>([](over*, int) {});
+    b.implements_batch_by<batched_msg>([](itlib::span<over*>, int) {});
+    CHECK(!!data.info.features[0].batch_payload);
+
+    // untyped batch payloads get the mixins as they are stored in objects
+    using traits = batched_msg::traits;
+    auto raw = traits::make_batch_payload_by({}, static_cast<void*>(nullptr), +[](void* const* mixins, size_t num, int i) {
+        for (size_t m = 0; m < num; ++m) static_cast<over*>(mixins[m])->val = i + int(num);
+    });
+    void* ms[] = {objs[0].get<over>(), objs[1].get<over>()};
+    auto& raw_pl = *static_cast<const traits::batch_payload_t*>(raw.get());
+    raw_pl.func(raw_pl, ms, 2, 20);
+    CHECK(objs[0].get<over>()->val == 22);
+    CHECK(objs[1].get<over>()->val == 22);
+}
+
+TEST_CASE("call site caches") {
+    using namespace dynamix::mutate_ops;
+    test_obj a, b;
+    mutate(a, add<common>());
+    mutate(b, add<over>());
+
+    // a cache owned by the caller
+    dynamix::msg_inline_cache<1> cache;
+    CHECK(cached_uni_msg::traits::call_unicast_cached(cache, a, 1) == 1);
+    CHECK(cached_uni_msg::traits::call_unicast_cached(cache, b, 1) == 102);
+    CHECK(cached_uni_msg::traits::call_unicast_cached(cache, b, 2) == 103);
+    CHECK(cache.find(b.get_type()));
+    CHECK_FALSE(cache.find(a.get_type()));
+
+    // sites don't evict each other's entries
+    for (int i = 0; i < 3; ++i) {
+        CHECK(DYNAMIX_CALL_SITE_CACHED(cached_uni_msg, unicast, 1, a, i) == i);
+        CHECK(DYNAMIX_CALL_SITE_CACHED(cached_uni_msg, unicast, 1, b, i) == 101 + i);
+    }
+
+    test_obj mc;
+    mutate(mc, add<multicaster>(5), add<common>());
+    int sum = 0;
+    CHECK(DYNAMIX_CALL_SITE_CACHED(cached_multi_msg, multicast, 2, mc, sum) == 0);
+    CHECK(sum == 5);
+}
@@ -146,7 +146,7 @@ TEST_CASE("apply rules") {
         });
         return result_success;
     };
-    mutation_rule_info mri;
+    mutation_rule_info mri = {};
     mri.name = dnmx_make_sv_lit("mri");
     mri.apply = ban_empty;
     mri.user_data = reinterpret_cast<uintptr_t>(&mrtd);
@@ -379,3 +379,129 @@ TEST_CASE("no-participation rule") {
     CHECK(dom.num_types() == 7);
     CHECK(dom.num_type_queries() == 4);
 }
+
+TEST_CASE("declared rule mixins") {
+    test_data t;
+    domain dom("drm");
+    t.register_all_mixins(dom);
+
+    const mixin_info* m[] = {t.movable};
+    const mixin_info* as[] = {t.ai, t.stats};
+    const mixin_info* me[] = {t.mesh};
+    const mixin_info* mi[] = {t.mesh, t.invisible};
+    const mixin_info* i[] = {t.invisible};
+    for (auto& q : {itlib::span(m), itlib::span(as), itlib::span(me), itlib::span(mi), itlib::span(i)}) {
+        dom.get_type(q);
+    }
+    CHECK(dom.num_type_queries() == 5);
+
+    // meshes are invisible
+    auto add_invisible = [](dnmx_type_mutation_handle mutation, uintptr_t user_data) {
+        auto mut = type_mutation::from_c_handle(mutation);
+        auto& td = *reinterpret_cast<test_data*>(user_data);
+        if (mut->has(*td.mesh)) mut->add_if_lacking(*td.invisible);
+        return result_success;
+    };
+    const mixin_info* reacts_to[] = {t.mesh};
+    const mixin_info* changes[] = {t.invisible};
+    mutation_rule_info mri = {};
+    mri.name = dnmx_make_sv_lit("invisible meshes");
+    mri.apply = add_invisible;
+    mri.user_data = reinterpret_cast<uintptr_t>(&t);
+    mri.reacts_to = reacts_to;
+    mri.num_reacts_to = 1;
+    CHECK_FALSE(mri.is_opaque());
+
+    // only the queries with meshes are invalidated
+    dom.add_mutation_rule(mri);
+    CHECK(dom.num_type_queries() == 3);
+    CHECK(dom.get_type(me) == dom.get_type(mi));
+    CHECK(dom.num_type_queries() == 5);
+
+    dom.remove_mutation_rule(mri);
+    CHECK(dom.num_type_queries() == 3);
+    CHECK(dom.get_type(me).num_mixins() == 1);
+
+    // ... and the ones with the changed mixins
+    mri.changes = changes;
+    mri.num_changes = 1;
+    dom.add_mutation_rule(mri);
+    CHECK(dom.num_type_queries() == 2);
+    CHECK(dom.get_type(m).num_mixins() == 1);
+    CHECK(dom.get_type(as).num_mixins() == 2);
+    CHECK(dom.num_type_queries() == 2);
+    dom.remove_mutation_rule(mri);
+
+    // opaque rules invalidate everything
+    mutation_rule_info opaque = {};
+    opaque.name = dnmx_make_sv_lit("opaque");
+    opaque.apply = [](dnmx_type_mutation_handle, uintptr_t) { return result_success; };
+    dom.add_mutation_rule(opaque);
+    CHECK(dom.num_type_queries() == 0);
+    dom.remove_mutation_rule(opaque);
+}
+
+TEST_CASE("declarative rules") {
+    test_data t;
+    domain dom("dr");
+    t.register_all_mixins(dom);
+
+    // a chain which opaque rules would need multiple applications for
+    const mutation_rule_clause chain[] = {
+        {t.invisible, t.stats, false},
+        {t.mesh, t.invisible, false},
+    };
+    mutation_rule_info r_chain = {};
+    r_chain.name = dnmx_make_sv_lit("chain");
+    r_chain.clauses = chain;
+    r_chain.num_clauses = 2;
+    CHECK_FALSE(r_chain.is_opaque());
+    dom.add_mutation_rule(r_chain);
+
+    auto check_type = [&](std::vector<const mixin_info*> query, std::vector<const mixin_info*> expected) {
+        auto& type = dom.get_type(query);
+        CHECK(std::equal(expected.begin(), expected.end(), type.mixins.begin(), type.mixins.end()));
+    };
+
+    check_type({t.mesh}, {t.mesh, t.invisible, t.stats});
+    check_type({t.invisible, t.ai}, {t.invisible, t.ai, t.stats});
+    check_type({t.ai}, {t.ai});
+
+    // removals win and the additions they cause are dropped
+    const mutation_rule_clause no_invisible[] = {
+        {t.movable, t.invisible, true},
+    };
+    mutation_rule_info r_remove = {};
+    r_remove.name = dnmx_make_sv_lit("no invisible");
+    r_remove.clauses = no_invisible;
+    r_remove.num_clauses = 1;
+    dom.add_mutation_rule(r_remove);
+    CHECK(dom.num_type_queries() == 1); // only {ai} is not affected
+
+    check_type({t.movable, t.mesh}, {t.movable, t.mesh});
+    check_type({t.mesh, t.invisible, t.movable}, {t.mesh, t.movable});
+    check_type({t.mesh}, {t.mesh, t.invisible, t.stats});
+
+    // opaque rules are applied afterwards
+    auto add_ai = [](dnmx_type_mutation_handle mutation, uintptr_t user_data) {
+        auto mut = type_mutation::from_c_handle(mutation);
+        auto& td = *reinterpret_cast<test_data*>(user_data);
+        if (mut->has(*td.stats)) mut->add_if_lacking(*td.ai);
+        return result_success;
+    };
+    mutation_rule_info r_opaque = {};
+    r_opaque.name = dnmx_make_sv_lit("ai stats");
+    r_opaque.apply = add_ai;
+    r_opaque.user_data = reinterpret_cast<uintptr_t>(&t);
+    dom.add_mutation_rule(r_opaque);
+
+    check_type({t.mesh}, {t.mesh, t.invisible, t.stats, t.ai});
+    check_type({t.movable, t.mesh}, {t.movable, t.mesh});
+
+    dom.remove_mutation_rule(r_opaque);
+    dom.remove_mutation_rule(r_remove);
+    check_type({t.movable, t.mesh}, {t.movable, t.mesh, t.invisible, t.stats});
+    dom.remove_mutation_rule(r_chain);
+    check_type({t.movable, t.mesh}, {t.movable, t.mesh});
+    CHECK(dom.num_mutation_rules() == 0);
+}
@@ -14,6 +14,15 @@
 void setUp(void) {}
 void tearDown(void) {}
 
+void count_event(const dnmx_domain_event* e, uintptr_t user_data) {
+    int* counts = (int*)user_data;
+    ++counts[e->type];
+}
+
+void store_type(dnmx_type_handle ht, uintptr_t user_data) {
+    *(dnmx_type_handle*)user_data = ht;
+}
+
 bool can_jump(dnmx_type_handle ht) {
     return dnmx_type_implements_strong_by_name(ht, dnmx_make_sv_lit("jump"));
 }
@@ -154,8 +163,37 @@ void simple(void) {
 
     CHECK(dnmx_get_num_types(dom) == 2);
 
+    {
+        const dnmx_mixin_info* req[] = {&shooter};
+        dnmx_type_class shooters = {dnmx_make_sv_lit("shooters")};
+        shooters.required = req;
+        shooters.num_required = 1;
+        T_SUCCESS(dnmx_register_type_class(dom, &shooters));
+        CHECK(dnmx_type_is_of(tas, &shooters));
+        CHECK_FALSE(dnmx_type_is_of(taw, &shooters));
+        dnmx_type_handle found = NULL;
+        dnmx_for_each_type_of(dom, &shooters, store_type, (uintptr_t)&found);
+        CHECK(found == tas);
+        dnmx_unregister_type_class(dom, &shooters);
+    }
+
+    {
+        dnmx_domain_stats stats = dnmx_get_domain_stats(dom);
+        CHECK(stats.type_query_hits == 1);
+        CHECK(stats.type_query_misses == 3);
+        CHECK(stats.types_created == 2);
+    }
+
+    int event_counts[4] = {0};
+    dnmx_domain_listener listener = {count_event, (uintptr_t)event_counts};
+    dnmx_set_domain_listener(dom, &listener);
+
     type = dnmx_get_type_from_infos(dom, ar_aw, 1);
     CHECK(type != taw);
+    CHECK(event_counts[dnmx_domain_event_query_miss] == 1);
+    CHECK(event_counts[dnmx_domain_event_type_created] == 1);
+    CHECK(event_counts[dnmx_domain_event_gc] == 0);
+    dnmx_set_domain_listener(dom, NULL);
     {
         dnmx_ftable_entry fe = dnmx_ftable_at(type, shoot.id);
         CHECK(fe.end - fe.begin == 0);
@@ -221,6 +259,7 @@ void mutations(void) {
 
         CHECK(dnmx_type_mutation_has(mut, &warrior));
         CHECK(&athlete == dnmx_type_mutation_has_by_name(mut, dnmx_make_sv_lit("athlete")));
+        CHECK(dnmx_type_mutation_has_id(mut, warrior.id));
         CHECK(dnmx_type_mutation_implements_strong(mut, &shoot));
         CHECK(&run == dnmx_type_mutation_implements_strong_by_name(mut, dnmx_make_sv_lit("run")));
 
@@ -316,11 +355,71 @@ void mutation_rules(void) {
     dnmx_destroy_domain(dom);
 }
 
+void compact(void) {
+    dnmx_feature_info
+        run = dnmx_make_feature_info(),
+        shoot = dnmx_make_feature_info(),
+        jump = dnmx_make_feature_info();
+
+    run.name = dnmx_make_sv_lit("run");
+    run.allow_clashes = true;
+    shoot.name = dnmx_make_sv_lit("shoot");
+    jump.name = dnmx_make_sv_lit("jump");
+
+    dnmx_mixin_info
+        athlete = dnmx_make_mixin_info(),
+        warrior = dnmx_make_mixin_info();
+
+    athlete.name = dnmx_make_sv_lit("athlete");
+    dnmx_feature_for_mixin ath_skills[] = {{&run}, {&jump}};
+    athlete.features = ath_skills;
+    athlete.num_features = 2;
+
+    warrior.name = dnmx_make_sv_lit("warrior");
+    dnmx_feature_for_mixin war_skills[] = {{&run}, {&shoot}};
+    warrior.features = war_skills;
+    warrior.num_features = 2;
+
+    dnmx_domain_settings settings = {0};
+    settings.compact_types = true;
+    dnmx_domain_handle dom = dnmx_create_domain(dnmx_make_sv_lit("test"), settings, 0, NULL);
+    dnmx_register_mixin(dom, &athlete);
+    dnmx_register_mixin(dom, &warrior);
+
+    const dnmx_mixin_info* ar_aw[] = {&athlete, &warrior};
+    dnmx_type_handle type = dnmx_get_type_from_infos(dom, ar_aw, 2);
+    T_NOT_NULL(type);
+    CHECK(dnmx_type_index_of(type, &athlete) == 0);
+    CHECK(dnmx_type_index_of(type, &warrior) == 1);
+
+    {
+        dnmx_ftable_entry fe = dnmx_ftable_at(type, shoot.id);
+        CHECK(fe.end - fe.begin == 1);
+        fe = dnmx_ftable_at(type, run.id);
+        CHECK(fe.end - fe.begin == 2);
+        fe = dnmx_ftable_at(type, jump.id);
+        CHECK(fe.end - fe.begin == 1);
+    }
+
+    type = dnmx_get_type_from_infos(dom, ar_aw, 1);
+    CHECK(dnmx_type_has(type, &athlete));
+    CHECK_FALSE(dnmx_type_has(type, &warrior));
+    {
+        dnmx_ftable_entry fe = dnmx_ftable_at(type, shoot.id);
+        CHECK(fe.end - fe.begin == 0);
+        fe = dnmx_ftable_at(type, run.id);
+        CHECK(fe.end - fe.begin == 1);
+    }
+
+    dnmx_destroy_domain(dom);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(empty);
     RUN_TEST(simple);
     RUN_TEST(mutations);
     RUN_TEST(mutation_rules);
+    RUN_TEST(compact);
     return UNITY_END();
 }
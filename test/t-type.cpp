@@ -6,9 +6,17 @@
 #include <dynamix/exception.hpp>
 #include <dynamix/type.hpp>
 #include <dynamix/object_mixin_data.hpp>
+#include <dynamix/object.hpp>
+#include <dynamix/type_mutation.hpp>
+#include <dynamix/mutation_rule_info.hpp>
+#include <dynamix/mutate.hpp>
+#include <dynamix/trace_recorder.hpp>
 
 #include <doctest/doctest.h>
 
+#include <thread>
+#include <sstream>
+
 using namespace dynamix;
 
 TEST_SUITE_BEGIN("dynamix");
@@ -663,6 +671,186 @@ TEST_CASE("types") {
     CHECK(dom.num_type_queries() == 0);
 }
 
+TEST_CASE("domain stats") {
+    test_data t;
+    domain dom("ds");
+    t.register_all_mixins(dom);
+
+    auto s = dom.stats();
+    CHECK(s.type_query_hits == 0);
+    CHECK(s.type_query_misses == 0);
+    CHECK(s.types_created == 0);
+
+    t.create_types(dom);
+    s = dom.stats();
+    CHECK(s.type_query_hits == 0);
+    CHECK(s.type_query_misses == 4);
+    CHECK(s.types_created == 4);
+    CHECK(s.types_discarded == 0);
+    CHECK(s.type_bytes_allocated == dom.types_memory());
+    CHECK(s.rule_applications == 0);
+    CHECK(s.unique_locks >= 4);
+
+    t.create_types(dom);
+    s = dom.stats();
+    CHECK(s.type_query_hits == 4);
+    CHECK(s.type_query_misses == 4);
+
+    mutation_rule_info noop = {};
+    noop.name = dnmx_make_sv_lit("noop");
+    noop.apply = [](dnmx_type_mutation_handle, uintptr_t) -> error_return_t { return result_success; };
+    dom.add_mutation_rule(noop); // clears the queries
+
+    t.create_types(dom);
+    s = dom.stats();
+    CHECK(s.type_query_misses == 8);
+    CHECK(s.rule_applications == 4);
+    CHECK(s.rule_passes == 4);
+    CHECK(s.types_created == 4); // found existing
+
+    dom.garbage_collect_types();
+    s = dom.stats();
+    CHECK(s.gc_runs == 1);
+    CHECK(s.types_collected == 4);
+
+    dom.remove_mutation_rule(noop);
+}
+
+TEST_CASE("domain listener") {
+    test_data t;
+    domain dom("dl");
+    t.register_all_mixins(dom);
+
+    struct event {
+        domain_event_type et;
+        std::vector<const mixin_info*> mixins;
+        const dynamix::type* tp;
+        uint32_t count;
+    };
+    std::vector<event> events;
+    domain_listener listener = {[](const domain_event* e, uintptr_t ud) {
+        auto& evs = *reinterpret_cast<std::vector<event>*>(ud);
+        CHECK(e->duration_ns < 1'000'000'000'000);
+        auto m = e->mixins_span();
+        evs.push_back({e->type, {m.begin(), m.end()}, type::from_c_handle(e->type_handle), e->count});
+    }, reinterpret_cast<uintptr_t>(&events)};
+
+    t.create_types(dom); // no listener
+    CHECK(events.empty());
+
+    dom.set_listener(&listener);
+    t.create_types(dom); // all hits
+    CHECK(events.empty());
+
+    const mixin_info* ma[] = {t.mesh, t.ai};
+    auto& t_ma = dom.get_type(ma);
+    REQUIRE(events.size() == 2);
+    CHECK(events[0].et == dnmx_domain_event_type_created);
+    CHECK(events[0].tp == &t_ma);
+    CHECK(events[0].mixins.size() == 2);
+    CHECK(events[1].et == dnmx_domain_event_query_miss);
+    CHECK(events[1].tp == &t_ma);
+    CHECK(events[1].mixins.size() == 2);
+    events.clear();
+
+    mutation_rule_info noop = {};
+    noop.name = dnmx_make_sv_lit("noop");
+    noop.apply = [](dnmx_type_mutation_handle, uintptr_t) -> error_return_t { return result_success; };
+    dom.add_mutation_rule(noop);
+    dom.get_type(ma);
+    REQUIRE(events.size() == 2);
+    CHECK(events[0].et == dnmx_domain_event_rules_applied);
+    CHECK(events[0].count == 1);
+    CHECK(events[0].mixins.size() == 2);
+    CHECK(events[1].et == dnmx_domain_event_query_miss);
+    CHECK(events[1].tp == &t_ma);
+    events.clear();
+    dom.remove_mutation_rule(noop);
+
+    dom.garbage_collect_types();
+    REQUIRE(events.size() == 1);
+    CHECK(events[0].et == dnmx_domain_event_gc);
+    CHECK(events[0].count == 5);
+    events.clear();
+
+    util::trace_recorder rec(2);
+    dom.set_listener(&rec.listener());
+    t.create_types(dom);
+    CHECK(rec.size() == 2);
+    std::ostringstream out;
+    rec.dump(out);
+    auto json = out.str();
+    CHECK(json.find("\"traceEvents\"") != std::string::npos);
+    CHECK(json.find("\"name\":\"query miss\"") != std::string::npos);
+    CHECK(json.find("\"domain\":\"dl\"") != std::string::npos);
+    rec.clear();
+    CHECK(rec.size() == 0);
+
+    dom.set_listener(nullptr);
+    dom.garbage_collect_types();
+    CHECK(events.empty());
+    CHECK(rec.size() == 0);
+}
+
+TEST_CASE("unregister mixins") {
+    test_data t;
+    domain dom("tum");
+    t.register_all_mixins(dom);
+
+    // a rule which removes invisible from types with mesh
+    mutation_rule_info rule = {dnmx_make_sv_lit("visible meshes"), [](dnmx_type_mutation_handle mutation, uintptr_t ud) {
+        auto& td = *reinterpret_cast<test_data*>(ud);
+        auto mut = type_mutation::from_c_handle(mutation);
+        if (mut->has(*td.mesh)) mut->remove(*td.invisible);
+        return result_success;
+    }, reinterpret_cast<uintptr_t>(&t), 0};
+    dom.add_mutation_rule(rule);
+
+    const mixin_info* mi[] = {t.mesh, t.invisible};
+    const mixin_info* m[] = {t.mesh};
+    const mixin_info* ai[] = {t.ai, t.invisible};
+    const mixin_info* as[] = {t.ai, t.stats};
+    const mixin_info* s[] = {t.stats};
+    auto& t_m = dom.get_type(mi);
+    CHECK(&t_m == &dom.get_type(m));
+    dom.get_type(ai);
+    dom.get_type(as);
+    auto& t_s = dom.get_type(s);
+    CHECK(dom.num_types() == 4);
+    CHECK(dom.num_type_queries() == 5);
+
+    // nothing is unregistered if one of the mixins is not registered
+    mixin_info foreign = dnmx_make_mixin_info();
+    foreign.name = dnmx_make_sv_lit("foreign");
+    mixin_info* bad[] = {t.invisible, &foreign};
+    CHECK_THROWS(dom.unregister_mixins(bad));
+    CHECK(dom.num_types() == 4);
+    CHECK(dom.num_type_queries() == 5);
+    CHECK(dom.get_mixin_info("invisible") == t.invisible);
+
+    // {mesh, invisible} leads to {mesh} but it's removed with invisible
+    mixin_info* infos[] = {t.invisible, t.ai, t.invisible};
+    dom.unregister_mixins(infos);
+    CHECK(t.invisible->id == invalid_mixin_id);
+    CHECK(t.ai->id == invalid_mixin_id);
+    CHECK_FALSE(dom.get_mixin_info("ai"));
+    CHECK(dom.num_types() == 2);
+    CHECK(dom.num_type_queries() == 2);
+    CHECK(&dom.get_type(m) == &t_m);
+    CHECK(&dom.get_type(s) == &t_s);
+    CHECK(&dom.get_type_with(t_s, *t.mesh) == &dom.get_type_with(t_s, *t.mesh));
+    CHECK(dom.num_types() == 3);
+
+    dom.register_mixin(*t.invisible);
+    CHECK(&dom.get_type(mi) == &t_m);
+    CHECK(dom.num_type_queries() == 4);
+
+    mixin_info* mesh[] = {t.mesh};
+    dom.unregister_mixins(mesh);
+    CHECK(dom.num_types() == 1);
+    CHECK(dom.num_type_queries() == 1);
+}
+
 TEST_CASE("unregistered mixins") {
     test_data t;
     domain dom("tt");
@@ -718,3 +906,363 @@ TEST_CASE("types canon") {
     CHECK(dom.num_types() == 11);
     CHECK(dom.num_type_queries() == 14);
 }
+
+TEST_CASE("compact types") {
+    test_data ft;
+    domain fdom("flat");
+    ft.register_all_mixins(fdom);
+    ft.create_types(fdom);
+    ft.create_more_types(fdom);
+
+    test_data t;
+    domain_settings s = {};
+    s.compact_types = true;
+    domain dom("compact", s);
+    t.register_all_mixins(dom);
+    t.create_types(dom);
+    t.create_more_types(dom);
+    test_more_types(t);
+
+    auto check_same = [&](const type& flat, const type& compact) {
+        CHECK(compact.sparse_mixin_indices.empty());
+        CHECK(compact.ftable_hash.keys);
+
+        uint32_t num_features = 0;
+        for (auto& e : itlib::span(compact.ftable, compact.ftable_length)) num_features += !!e;
+        CHECK(compact.ftable_length <= num_features * 2);
+
+        for (size_t i = 0; i < t.features.size(); ++i) {
+            auto fe = flat.ftable_at(ft.features[i].id);
+            auto ce = compact.ftable_at(t.features[i].id);
+            REQUIRE(fe.size() == ce.size());
+            for (size_t j = 0; j < fe.size(); ++j) {
+                CHECK(fe.begin[j].mixin_index == ce.begin[j].mixin_index);
+            }
+            if (fe) CHECK(fe.top_bid_back - fe.begin == ce.top_bid_back - ce.begin);
+            CHECK(flat.implements_strong(ft.features[i].name.to_std()) == compact.implements_strong(t.features[i].name.to_std()));
+        }
+
+        for (auto& md : t.mixins) {
+            auto m = &md.info;
+            auto index = compact.index_of(m->id);
+            if (index == invalid_mixin_index) {
+                CHECK_FALSE(compact.has(m->id));
+                continue;
+            }
+            CHECK(compact.has(m->id));
+            CHECK(compact.mixins[index] == m);
+        }
+    };
+    check_same(*ft.t_mov, *t.t_mov);
+    check_same(*ft.t_asim, *t.t_asim);
+    check_same(*ft.t_m, *t.t_m);
+    check_same(*ft.t_afmi, *t.t_afmi);
+    check_same(*ft.t_acp, *t.t_acp);
+    check_same(*ft.t_pp, *t.t_pp);
+    check_same(*ft.t_siee, *t.t_siee);
+    check_same(*ft.t_apio, *t.t_apio);
+
+    // derived ftables
+    check_same(fdom.get_type_with(*ft.t_asim, *ft.invisible), dom.get_type_with(*t.t_asim, *t.invisible));
+    check_same(fdom.get_type_without(*ft.t_asim, *ft.ai), dom.get_type_without(*t.t_asim, *t.ai));
+
+    {
+        object obj(*t.t_m);
+        CHECK(obj.has(*t.mesh));
+        CHECK_FALSE(obj.has(*t.ai));
+        CHECK(obj.get(*t.mesh));
+    }
+
+    CHECK(dom.types_memory() < fdom.types_memory());
+}
+
+TEST_CASE("compact mixin indices") {
+    // mixins with ids in many words of mixin_id_bits
+    std::deque<util::mixin_info_data> mixins(150);
+    domain_settings s = {};
+    s.compact_types = true;
+    domain dom("compact", s);
+    for (size_t i = 0; i < mixins.size(); ++i) {
+        util::mixin_info_data_builder b(mixins[i], "");
+        b.store_name("m" + std::to_string(i));
+        dom.register_mixin(mixins[i].info);
+    }
+
+    const mixin_info* query[] = {&mixins[130].info, &mixins[3].info, &mixins[70].info, &mixins[64].info, &mixins[63].info};
+    auto& t = dom.get_type(query);
+    CHECK(t.sparse_mixin_indices.empty());
+    for (mixin_index_t i = 0; i < t.mixins.size(); ++i) {
+        CHECK(t.has(t.mixins[i]->id));
+        CHECK(t.index_of(t.mixins[i]->id) == i);
+    }
+    for (auto i : {0, 4, 65, 129, 149}) {
+        CHECK_FALSE(t.has(mixins[i].info.id));
+        CHECK(t.index_of(mixins[i].info.id) == invalid_mixin_index);
+    }
+    CHECK_FALSE(t.has(mixin_id{1000}));
+    CHECK(t.index_of(mixin_id{1000}) == invalid_mixin_index);
+    CHECK_FALSE(t.has(invalid_mixin_id));
+
+    {
+        object obj(t);
+        CHECK(obj.get(mixins[70].info) == obj.get_at(t.index_of(mixins[70].info.id)));
+    }
+
+    dom.garbage_collect_types();
+    for (auto& m : mixins) dom.unregister_mixin(m.info);
+}
+
+TEST_CASE("shared ftables") {
+    test_data t;
+    domain dom("sf");
+    t.register_all_mixins(dom);
+
+    const dynamix::mixin_info* m[] = {t.mesh};
+    const dynamix::mixin_info* me[] = {t.mesh, t.empty};
+    const dynamix::mixin_info* em[] = {t.empty, t.mesh};
+    const dynamix::mixin_info* mes[] = {t.mesh, t.empty, t.stats};
+
+    auto& t_m = dom.get_type(m);
+    const auto memory = dom.types_memory();
+    auto& t_me = dom.get_type(me);
+    CHECK(t_me.ftable == t_m.ftable);
+    CHECK(t_me.ftable_length == t_m.ftable_length);
+    CHECK(dom.types_memory() - memory < t_me.buf_size + t_m.ftable_length * sizeof(type::ftable_entry));
+
+    // the mixin indices in the payloads differ
+    auto& t_em = dom.get_type(em);
+    CHECK(t_em.ftable != t_m.ftable);
+    CHECK(t_em.ftable_at(t.render->id).begin->mixin_index == 1);
+
+    auto& t_mes = dom.get_type(mes);
+    CHECK(t_mes.ftable != t_m.ftable);
+
+    {
+        // the ftable remains when the type which created it is collected
+        object obj(t_me);
+        dom.garbage_collect_types();
+        CHECK(dom.num_types() == 1);
+        test_feature_implementers(t_me, *t.render, {{t.mesh, 0, -2}});
+        CHECK(obj.get_type().implements_strong(*t.serialize));
+        auto& t_m2 = dom.get_type(m);
+        CHECK(t_m2.ftable == t_me.ftable);
+    }
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.types_memory() == 0);
+}
+
+TEST_CASE("type edges") {
+    test_data t;
+    domain dom("te");
+    t.register_all_mixins(dom);
+
+    auto& empty = dom.get_empty_type();
+    auto& t_m = dom.get_type_with(empty, *t.mesh);
+    CHECK(t_m.num_mixins() == 1);
+    CHECK(t_m.has(*t.mesh));
+    CHECK(&dom.get_type_with(empty, *t.mesh) == &t_m);
+
+    auto& t_ma = dom.get_type_with(t_m, *t.ai);
+    {
+        const dynamix::mixin_info* ma[] = {t.mesh, t.ai};
+        CHECK(&dom.get_type(ma) == &t_ma);
+    }
+    CHECK(&dom.get_type_with(t_m, *t.ai) == &t_ma);
+    CHECK(&dom.get_type_without(t_ma, *t.ai) == &t_m);
+    CHECK(&dom.get_type_without(t_ma, *t.mesh) == &dom.get_type_with(empty, *t.ai));
+    CHECK(&dom.get_type_without(t_ma, *t.stats) == &t_ma);
+    CHECK(dom.num_types() == 3);
+
+    // a rule which adds stats to every type with mesh
+    mutation_rule_info rule = {dnmx_make_sv_lit("stats"), [](dnmx_type_mutation_handle mutation, uintptr_t ud) {
+        auto& td = *reinterpret_cast<test_data*>(ud);
+        auto mut = type_mutation::from_c_handle(mutation);
+        if (mut->has(*td.mesh)) mut->add_if_lacking(*td.stats);
+        return result_success;
+    }, reinterpret_cast<uintptr_t>(&t), 0};
+    dom.add_mutation_rule(rule);
+
+    {
+        auto& t_ms = dom.get_type_with(empty, *t.mesh);
+        CHECK(&t_ms != &t_m);
+        CHECK(t_ms.has(*t.stats));
+        auto& t_mas = dom.get_type_with(t_m, *t.ai);
+        CHECK(&t_mas != &t_ma);
+        CHECK(t_mas.has(*t.stats));
+        CHECK(&dom.get_type_with(t_m, *t.ai) == &t_mas);
+    }
+
+    dom.remove_mutation_rule(rule);
+    CHECK(&dom.get_type_with(empty, *t.mesh) == &t_m);
+    CHECK(&dom.get_type_with(t_m, *t.ai) == &t_ma);
+
+    // keep only the types which objects reference
+    object obj(t_m);
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 1);
+    auto& t_m2 = dom.get_type_with(empty, *t.mesh);
+    CHECK(&t_m2 == &t_m);
+    auto& t_ma2 = dom.get_type_with(t_m2, *t.ai);
+    CHECK(t_ma2.has(*t.ai));
+    CHECK(&dom.get_type_without(t_ma2, *t.ai) == &t_m2);
+
+    dom.unregister_mixin(*t.ai);
+    CHECK(dom.num_types() == 1);
+    CHECK_THROWS_WITH_AS(dom.get_type_with(t_m2, *t.ai), "te: creating type {'mesh', 'ai'}: 'ai' unregistered", type_error);
+
+    domain dom2("te2");
+    CHECK_THROWS_AS(dom2.get_type_with(t_m2, *t.stats), domain_error);
+}
+
+TEST_CASE("type gc") {
+    test_data t;
+    domain dom("tgc");
+    t.register_all_mixins(dom);
+
+    // (all are default-constructible, so objects of the types can be created)
+    const mixin_info* singles[] = {t.mesh, t.ai, t.stats, t.movable, t.walker, t.invisible, t.immaterial, t.procedural_geometry};
+    auto get_single = [&](const mixin_info*& m) -> const type& {
+        return dom.get_type(itlib::span<const mixin_info* const>(&m, 1));
+    };
+    auto create_singles = [&]() {
+        for (auto& m : singles) get_single(m);
+    };
+    auto use_singles = [&]() {
+        // types are pinned for automatic collections until they get objects
+        for (auto& m : singles) object obj(get_single(m));
+    };
+
+    create_singles();
+    CHECK(dom.num_types() == 8);
+    CHECK(dom.num_type_queries() == 8);
+    CHECK(dom.types_memory() > 0);
+
+    {
+        // budgeted steps
+        object obj(get_single(singles[0]));
+        size_t collected = 0;
+        for (int i = 0; i < 6; ++i) {
+            auto step = dom.garbage_collect_types_step(3);
+            CHECK(step <= 3);
+            collected += step;
+        }
+        CHECK(collected == 7);
+        CHECK(dom.num_types() == 1);
+        CHECK(dom.num_type_queries() == 1);
+        CHECK(dom.garbage_collect_types_step(3) == 0);
+
+        // collected types are recreated on request
+        auto& t_ai = get_single(singles[1]);
+        CHECK(t_ai.has(*t.ai));
+        CHECK(dom.num_types() == 2);
+        CHECK(dom.num_type_queries() == 2);
+        auto& t_ma = dom.get_type_with(obj.get_type(), *t.ai);
+        CHECK(&dom.get_type_without(t_ma, *t.mesh) == &t_ai);
+        CHECK(dom.num_types() == 3);
+    }
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.num_type_queries() == 0);
+    CHECK(dom.types_memory() == 0);
+
+    // hysteresis
+    type_gc_policy policy;
+    policy.min_unused_time = std::chrono::hours(1);
+    dom.set_type_gc_policy(policy);
+    CHECK(dom.get_type_gc_policy().min_unused_time == policy.min_unused_time);
+    create_singles();
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 8);
+    CHECK(dom.num_type_queries() == 8);
+
+    policy.min_unused_time = std::chrono::milliseconds(1);
+    dom.set_type_gc_policy(policy);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    {
+        object obj(get_single(singles[0]));
+        dom.garbage_collect_types();
+        CHECK(dom.num_types() == 1);
+        CHECK(dom.num_type_queries() == 1);
+    }
+
+    // collection when objects drop to zero
+    dom.set_type_gc_policy({});
+    use_singles();
+    policy = {};
+    policy.on_zero_objects = true;
+    dom.set_type_gc_policy(policy);
+    CHECK(dom.num_types() == 8);
+    {
+        object a(get_single(singles[1]));
+        object b(get_single(singles[1]));
+        a.reset_type();
+        CHECK(dom.num_types() == 8);
+    }
+    CHECK(dom.num_types() == 7);
+    CHECK(dom.num_type_queries() == 7);
+    {
+        // mutations destroy no objects, but leave types unused
+        object obj(get_single(singles[2]));
+        mutate(obj, add(*t.ai));
+        CHECK(dom.num_types() == 7); // the stats type was collected, {stats, ai} was created
+    }
+    CHECK(dom.num_types() == 6);
+
+    // memory threshold
+    dom.set_type_gc_policy({});
+    use_singles();
+    CHECK(dom.num_types() == 8);
+    policy = {};
+    policy.memory_threshold = 1;
+    dom.set_type_gc_policy(policy);
+    get_single(singles[0]); // pinned until it gets an object
+    {
+        const mixin_info* ma[] = {t.mesh, t.ai};
+        object obj(dom.get_type(ma)); // new type: a step collects the unused ones which aren't pinned
+        CHECK(dom.num_types() == 2);
+    }
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+
+    // idle interval
+    use_singles();
+    policy = {};
+    policy.idle_interval = std::chrono::nanoseconds(1);
+    dom.set_type_gc_policy(policy);
+    {
+        object obj(get_single(singles[0]));
+        mutate(obj, add(*t.stats));
+        CHECK(dom.num_types() == 2); // the other types are collected when new types are created
+        CHECK(obj.get_type().has(*t.stats));
+    }
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+    CHECK(dom.num_type_queries() == 0);
+
+    // pins: types which have just been returned are not collected automatically
+    policy = {};
+    policy.on_zero_objects = true;
+    policy.memory_threshold = 1;
+    dom.set_type_gc_policy(policy);
+    create_singles(); // none of them is collected while the others are created
+    CHECK(dom.num_types() == 8);
+    {
+        auto& t_m = get_single(singles[0]); // returned twice: two pins
+        {
+            object obj(t_m); // an object releases a single pin
+        }
+        CHECK(dom.num_types() == 8);
+        object a(t_m);
+        object b(t_m);
+        a.reset_type();
+        CHECK(dom.num_types() == 8);
+    }
+    CHECK(dom.num_types() == 7); // unpinned and collected with the last object
+    CHECK(&get_single(singles[2]) == &get_single(singles[2]));
+    CHECK(dom.num_types() == 7);
+
+    // explicit collections ignore pins
+    dom.garbage_collect_types();
+    CHECK(dom.num_types() == 0);
+}
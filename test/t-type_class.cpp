@@ -6,9 +6,14 @@
 #include <dynamix/exception.hpp>
 #include <dynamix/type.hpp>
 #include <dynamix/object_mixin_data.hpp>
+#include <dynamix/object.hpp>
+#include <dynamix/domain_traverse.hpp>
 
 #include <doctest/doctest.h>
 
+#include <vector>
+#include <algorithm>
+
 using namespace dynamix;
 
 TEST_SUITE_BEGIN("dynamix");
@@ -60,4 +65,207 @@ TEST_CASE("type class") {
     CHECK_THROWS_WITH_AS(dom.register_type_class(tc),
         "tc: register type class with duplicate name 'custom'",
         dynamix::domain_error);
+
+    // registering sets the domain and id
+    CHECK(tc.dom == dom.to_c_hanlde());
+    CHECK(t.serializable.dom == dom.to_c_hanlde());
+    CHECK(tc.id != t.serializable.id);
+
+    domain dom2("tc2");
+    CHECK_THROWS_WITH_AS(dom2.register_type_class(tc),
+        "tc2: register type class 'custom' which has a domain = tc",
+        dynamix::domain_error);
+
+    dom.unregister_type_class(tc);
+    CHECK_FALSE(tc.dom);
+    CHECK(t.t_afmi->is_of(tc)); // not registered
+    dom2.register_type_class(tc);
+    CHECK(tc.dom == dom2.to_c_hanlde());
+    CHECK(t.t_afmi->is_of(tc)); // registered in another domain
+    CHECK_FALSE(t.t_acp->is_of(tc));
+    dom2.unregister_type_class(tc);
+}
+
+namespace {
+int num_mesh_matches = 0;
+int num_ai_matches = 0;
+}
+
+TEST_CASE("type class cache") {
+    test_data t;
+    domain dom("tcc");
+    t.register_all_mixins(dom);
+    t.create_types(dom);
+    t.create_more_types(dom);
+
+    type_class has_mesh = {dnmx_make_sv_lit("has_mesh"), [](dnmx_type_handle th) noexcept {
+        ++num_mesh_matches;
+        return type::from_c_handle(th)->has("mesh");
+    }};
+    type_class has_ai = {dnmx_make_sv_lit("has_ai"), [](dnmx_type_handle th) noexcept {
+        ++num_ai_matches;
+        return type::from_c_handle(th)->has("ai");
+    }};
+
+    // not registered: not cached
+    CHECK(t.t_m->is_of(has_mesh));
+    CHECK(t.t_m->is_of(has_mesh));
+    CHECK(num_mesh_matches == 2);
+
+    dom.register_type_class(has_mesh);
+    num_mesh_matches = 0;
+    CHECK(t.t_m->is_of(has_mesh));
+    CHECK_FALSE(t.t_pp->is_of(has_mesh));
+    CHECK(num_mesh_matches == 2);
+    CHECK(t.t_m->is_of(has_mesh));
+    CHECK(t.t_m->is_of("has_mesh"));
+    CHECK_FALSE(t.t_pp->is_of(has_mesh));
+    CHECK_FALSE(t.t_pp->is_of("has_mesh"));
+    CHECK(num_mesh_matches == 2);
+
+    {
+        object obj(*t.t_m);
+        CHECK(obj.is_of(has_mesh));
+        CHECK(obj.is_of("has_mesh"));
+        CHECK(num_mesh_matches == 2);
+    }
+
+    // the id of the unregistered class is reused
+    dom.unregister_type_class(has_mesh);
+    dom.register_type_class(has_ai);
+    CHECK_FALSE(t.t_m->is_of(has_ai));
+    CHECK(t.t_afmi->is_of("has_ai"));
+    CHECK(num_ai_matches == 2);
+    CHECK_FALSE(t.t_m->is_of(has_ai));
+    CHECK(num_ai_matches == 2);
+    CHECK_THROWS_AS((void)t.t_m->is_of("has_mesh"), type_error);
+
+    CHECK(t.t_m->is_of(has_mesh));
+    CHECK(num_mesh_matches == 3);
+
+    dom.unregister_type_class(has_ai);
+}
+
+TEST_CASE("declarative type class") {
+    test_data t;
+    domain dom("dtc");
+    t.register_all_mixins(dom);
+    t.create_types(dom);
+    t.create_more_types(dom);
+    t.create_reordered_types(dom);
+
+    const mixin_info* required[] = {t.mesh, t.procedural_geometry};
+    const mixin_info* forbidden[] = {t.ai};
+    type_class tc = {dnmx_make_sv_lit("pg_mesh")};
+    tc.required = required;
+    tc.num_required = 2;
+    tc.forbidden = forbidden;
+    tc.num_forbidden = 1;
+    CHECK(tc.declarative());
+
+    auto declared = [&](const type& tp) {
+        return tp.has(*t.mesh) && tp.has(*t.procedural_geometry) && !tp.has(*t.ai);
+    };
+
+    auto count_declared = [&]() {
+        size_t ret = 0;
+        domain_traverse tr(dom);
+        tr.traverse_types([&](const type& tp) {
+            if (declared(tp)) ++ret;
+        });
+        return ret;
+    };
+
+    std::vector<const type*> matching;
+    dom.for_each_type_of(tc, [&](const type& tp) {
+        CHECK(declared(tp));
+        matching.push_back(&tp);
+    });
+    CHECK(matching.size() == count_declared());
+    CHECK(std::count(matching.begin(), matching.end(), t.t_impsa) == 1);
+    const auto num_initial = matching.size();
+    CHECK(t.t_impsa->is_of(tc));
+    CHECK_FALSE(t.t_m->is_of(tc));
+    CHECK_FALSE(dom.get_empty_type().is_of(tc));
+
+    dom.register_type_class(tc);
+    CHECK(t.t_impsa->is_of("pg_mesh"));
+    CHECK_FALSE(t.t_asim->is_of("pg_mesh"));
+
+    {
+        const mixin_info* desc[] = {t.mesh, t.procedural_geometry, t.ai};
+        auto& tp = dom.get_type(desc);
+        CHECK_FALSE(tp.is_of(tc));
+    }
+    const type* t_mp;
+    {
+        const mixin_info* desc[] = {t.procedural_geometry, t.mesh};
+        t_mp = &dom.get_type(desc);
+        CHECK(t_mp->is_of(tc));
+    }
+
+    matching.clear();
+    dom.for_each_type_of(tc, [&](const type& tp) {
+        CHECK(declared(tp));
+        CHECK(tp.is_of(tc));
+        matching.push_back(&tp);
+    });
+    CHECK(matching.size() == num_initial + 1);
+    CHECK(matching.size() == count_declared());
+    CHECK(std::count(matching.begin(), matching.end(), t_mp) == 1);
+
+    size_t num_without_mesh = 0;
+    {
+        domain_traverse tr(dom);
+        tr.traverse_types([&](const type& tp) {
+            if (!tp.has(*t.mesh)) ++num_without_mesh;
+        });
+    }
+
+    // only forbidden
+    type_class no_mesh = {dnmx_make_sv_lit("no_mesh")};
+    const mixin_info* mesh[] = {t.mesh};
+    no_mesh.forbidden = mesh;
+    no_mesh.num_forbidden = 1;
+    dom.register_type_class(no_mesh);
+    CHECK(dom.get_empty_type().is_of(no_mesh));
+    CHECK(t.t_mov->is_of("no_mesh"));
+    CHECK_FALSE(t.t_m->is_of(no_mesh));
+    size_t num_no_mesh = 0;
+    dom.for_each_type_of(no_mesh, [&](const type& tp) {
+        CHECK_FALSE(tp.has(*t.mesh));
+        ++num_no_mesh;
+    });
+    CHECK(num_no_mesh == num_without_mesh);
+
+    // mixins must be registered
+    mixin_info foreign = dnmx_make_mixin_info();
+    foreign.name = dnmx_make_sv_lit("foreign");
+    const mixin_info* bad[] = {t.mesh, &foreign};
+    type_class bad_tc = {dnmx_make_sv_lit("bad")};
+    bad_tc.required = bad;
+    bad_tc.num_required = 2;
+    CHECK_THROWS_WITH_AS(dom.register_type_class(bad_tc),
+        "dtc: register type class 'bad' with mixin 'foreign' which is not registered in the domain",
+        domain_error);
+    CHECK_FALSE(dom.get_type_class("bad"));
+
+    // referenced mixins can't be unregistered
+    CHECK_THROWS_WITH_AS(dom.unregister_mixin(*t.ai),
+        "dtc: unregister mixin 'ai' which is referenced by type class 'pg_mesh'",
+        domain_error);
+    mixin_info* refs[] = {t.movable, t.procedural_geometry};
+    CHECK_THROWS_AS(dom.unregister_mixins(refs), domain_error);
+    CHECK(dom.get_mixin_info("movable") == t.movable);
+    CHECK(t_mp->is_of(tc));
+
+    dom.unregister_type_class(tc);
+    CHECK_THROWS_WITH_AS(dom.unregister_mixin(*t.mesh),
+        "dtc: unregister mixin 'mesh' which is referenced by type class 'no_mesh'",
+        domain_error);
+    dom.unregister_type_class(no_mesh);
+    CHECK(t_mp->is_of(tc));
+
+    dom.unregister_mixin(*t.ai);
+    CHECK_FALSE(dom.get_mixin_info("ai"));
 }
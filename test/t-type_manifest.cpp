@@ -0,0 +1,104 @@
+// Copyright (c) Borislav Stanimirov
+// SPDX-License-Identifier: MIT
+//
+#include "test_data.hpp"
+
+#include <doctest/doctest.h>
+
+#include <dynamix/type_manifest.hpp>
+#include <dynamix/domain_traverse.hpp>
+#include <dynamix/mutation_rule_info.hpp>
+#include <dynamix/type_mutation.hpp>
+#include <dynamix/exception.hpp>
+
+#include <cstring>
+
+using namespace dynamix;
+
+TEST_SUITE_BEGIN("dynamix");
+
+// adds stats to every type with mesh
+error_return_t add_stats(dnmx_type_mutation_handle mutation, uintptr_t) {
+    auto mut = type_mutation::from_c_handle(mutation);
+    if (mut->has("mesh")) mut->add_if_lacking("stats");
+    return result_success;
+}
+
+TEST_CASE("type manifest") {
+    const mutation_rule_info rule = {dnmx_make_sv_lit("stats"), add_stats, 0, 0};
+
+    std::vector<byte_t> manifest;
+    {
+        test_data t;
+        domain dom("src");
+        t.register_all_mixins(dom);
+        dom.add_mutation_rule(rule);
+        t.create_types(dom);
+        dom.get_type({}); // empty query
+        CHECK(dom.num_types() == 4);
+        CHECK(dom.num_type_queries() == 5);
+
+        manifest = util::save_type_manifest(dom);
+        CHECK(!manifest.empty());
+
+        domain empty("empty");
+        auto empty_manifest = util::save_type_manifest(empty);
+        CHECK(util::load_type_manifest(empty, empty_manifest) == 0);
+    }
+
+    {
+        // no rule here: the types come from the manifest
+        test_data t;
+        domain dom("dst");
+        t.register_all_mixins(dom);
+        CHECK(util::load_type_manifest(dom, manifest) == 5);
+        CHECK(dom.num_types() == 4);
+        CHECK(dom.num_type_queries() == 5);
+
+        const mixin_info* m[] = {t.mesh};
+        auto& tm = dom.get_type(m);
+        CHECK(tm.has(*t.stats));
+        CHECK(dom.num_types() == 4);
+
+        // loading again is a noop
+        CHECK(util::load_type_manifest(dom, manifest) == 5);
+        CHECK(dom.num_types() == 4);
+        CHECK(dom.num_type_queries() == 5);
+        CHECK(&dom.get_type(m) == &tm);
+    }
+
+    {
+        test_data t;
+        domain dom("partial");
+        t.register_all_mixins(dom);
+        dom.unregister_mixin(*t.ai);
+        CHECK(util::load_type_manifest(dom, manifest) == 3);
+        CHECK(dom.num_types() == 2);
+        CHECK(dom.num_type_queries() == 3);
+
+        domain_traverse tr(dom);
+        tr.traverse_types([&](const type& type) {
+            CHECK_FALSE(type.has(*t.ai));
+        });
+    }
+
+    {
+        test_data t;
+        domain dom("bad");
+        t.register_all_mixins(dom);
+        auto bad = manifest;
+        bad.pop_back();
+        CHECK_THROWS_AS(util::load_type_manifest(dom, bad), domain_error);
+        bad = manifest;
+        bad[0] = 0;
+        CHECK_THROWS_WITH_AS(util::load_type_manifest(dom, bad), "bad: bad type manifest at byte 4", domain_error);
+
+        // huge counts throw instead of allocating
+        bad = manifest;
+        std::memset(bad.data() + 4, 0xff, 4); // num_names
+        CHECK_THROWS_WITH_AS(util::load_type_manifest(dom, bad), "bad: bad type manifest at byte 8", domain_error);
+        bad.resize(8);
+        CHECK_THROWS_WITH_AS(util::load_type_manifest(dom, bad), "bad: bad type manifest at byte 8", domain_error);
+        CHECK(dom.num_types() == 0);
+    }
+}
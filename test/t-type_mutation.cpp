@@ -204,3 +204,83 @@ TEST_CASE("type_mutation canon") {
         CHECK(t.t_asmpi == &tasmpi);
     }
 }
+
+TEST_CASE("type_mutation index") {
+    test_data t;
+    domain dom;
+    t.register_all_mixins(dom);
+    t.create_types(dom);
+
+    test_data t2;
+    domain dom2;
+    t2.register_all_mixins(dom2);
+    CHECK(t2.mesh->id == t.mesh->id); // same ids in another domain
+
+    type_mutation mut(*t.t_asim);
+    CHECK(mut.has(t.mesh->id));
+    CHECK(mut.lacks(t.actor->id));
+    CHECK_FALSE(mut.has(invalid_mixin_id));
+    CHECK_FALSE(mut.has(*t2.mesh));
+
+    // foreign mixins are not indexed
+    mut.add(*t2.actor);
+    CHECK(mut.has(*t2.actor));
+    CHECK(mut.lacks(*t.actor));
+    CHECK(mut.lacks(t.actor->id));
+    CHECK(mut.remove(*t2.actor));
+    CHECK_FALSE(mut.remove(*t2.actor));
+    CHECK(mut.lacks(*t2.actor));
+
+    // duplicates
+    mut.add(*t.mesh);
+    CHECK(mut.remove(*t.mesh));
+    CHECK(mut.has(*t.mesh));
+    mut.add(*t.mesh);
+    mut.add(*t.ai);
+    mut.dedup();
+    CHECK(mut.mixins.size() == 4);
+    CHECK(mut.mixins[2] == t.mesh);
+    CHECK(mut.mixins[3] == t.ai);
+    CHECK(mut.remove(*t.mesh));
+    CHECK(mut.lacks(*t.mesh));
+    CHECK_FALSE(mut.remove(*t.mesh));
+
+    // direct modifications
+    mut.mixins.push_back(t.actor);
+    CHECK(mut.has(*t.actor));
+    CHECK(mut.has("actor"));
+    mut.mixins.pop_back();
+    CHECK(mut.lacks(*t.actor));
+
+    mut.mixins.back() = t.actor;
+    mut.mixins_changed(); // same size
+    CHECK(mut.has(*t.actor));
+    CHECK(mut.lacks(*t.ai));
+    CHECK(mut.has(t.actor->id));
+    CHECK(mut.lacks(t.ai->id));
+    CHECK(mut.has("actor"));
+    CHECK(mut.lacks("ai"));
+    std::swap(mut.mixins.front(), mut.mixins.back()); // permutations
+    CHECK(mut.has(*t.actor));
+    mut.mixins.front() = t.ai;
+    mut.mixins.back() = t.actor;
+    mut.mixins_changed();
+    CHECK(mut.lacks(*t.mesh));
+    CHECK(mut.has(*t.ai));
+
+    // copies have their own index
+    type_mutation copy(mut);
+    CHECK(copy.mixins == mut.mixins);
+    CHECK(copy.has(*t.actor));
+    copy.remove(*t.actor);
+    CHECK(copy.lacks(*t.actor));
+    CHECK(mut.has(*t.actor));
+
+    // names in large mutations are looked up in the domain
+    copy.mixins.assign(type_mutation::max_name_scan + 1, t.mesh);
+    copy.add(*t.actor);
+    CHECK(copy.has("mesh") == t.mesh);
+    CHECK(copy.has("actor") == t.actor);
+    CHECK(copy.lacks("ai"));
+    CHECK(copy.lacks("nope"));
+}
@@ -10,7 +10,7 @@ namespace dynamix {
 class type_mutation;
 namespace v1compat {
 class DYNAMIX_V1COMPAT_API mutation_rule {
-    mutation_rule_info m_info;
+    mutation_rule_info m_info = {};
 public:
     mutation_rule() noexcept;
 